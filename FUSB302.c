@@ -1,57 +1,144 @@
 #include "FUSB302.h"
+#include "FUSB302Trace.h"
 
-#define I2C_TIMEOUT 1
+#define SYNC_MERGE_GAP 2
 
-bool FUSB302_ReadControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
-    // Read register data
-    int ret;
-    if (reg != FUSB302_REG_ALL) {
-        ret = platform->i2cReadReg(FUSB302_I2C_ADDR, reg,
-                                   &data->controlRegData[reg - FUSB302_REG_CONTROL_START], 1,
-                                   I2C_TIMEOUT);
-    } else {
-        ret = platform->i2cReadReg(FUSB302_I2C_ADDR, FUSB302_REG_CONTROL_START,
-                                   data->controlRegData, FUSB302_REG_CONTROL_NUM, I2C_TIMEOUT);
+#ifdef FUSB302_STATIC_BUS
+#define I2C_READ_REG(platform) FUSB302_StaticI2CReadReg
+#define I2C_WRITE_REG(platform) FUSB302_StaticI2CWriteReg
+#else
+#define I2C_READ_REG(platform) (platform)->i2cReadReg
+#define I2C_WRITE_REG(platform) (platform)->i2cWriteReg
+#endif
+
+static int I2CTimeout(FUSB302_Platform_t *platform) {
+    return platform->i2cPolicy ? platform->i2cPolicy->timeout : FUSB302_I2C_DEFAULT_TIMEOUT;
+}
+
+static bool IsIdempotentRead(int reg, int numRegs) {
+    // Interrupt registers are cleared on read and FIFO reads consume data
+    if (reg == FUSB302_REG_FIFOS) {
+        return false;
+    }
+    int last = reg + numRegs - 1;
+    if (reg <= FUSB302_REG_INTERRUPTB && last >= FUSB302_REG_INTERRUPTA) {
+        return false;
+    }
+    if (reg <= FUSB302_REG_INTERRUPT && last >= FUSB302_REG_INTERRUPT) {
+        return false;
+    }
+    return true;
+}
+
+static bool PlatformRead(FUSB302_Platform_t *platform, int reg, uint8_t *buf, int numRegs,
+                         int timeout) {
+    bool ok = I2C_READ_REG(platform)(FUSB302_I2C_ADDR, reg, buf, numRegs, timeout) >= 0;
+
+    // Capture FIFO drains and register snapshots
+    if (platform->trace) {
+        FUSB302_TraceAccess(platform, reg == FUSB302_REG_FIFOS ? FUSB302_TRACE_RX
+                                                                : FUSB302_TRACE_READ,
+                            reg, buf, numRegs, !ok);
+    }
+    return ok;
+}
+
+static bool PlatformWrite(FUSB302_Platform_t *platform, int reg, const uint8_t *buf, int numRegs,
+                          int timeout) {
+    bool ok = I2C_WRITE_REG(platform)(FUSB302_I2C_ADDR, reg, buf, numRegs, timeout) >= 0;
+
+    // Capture TX FIFO writes and register writes
+    if (platform->trace) {
+        FUSB302_TraceAccess(platform, reg == FUSB302_REG_FIFOS ? FUSB302_TRACE_TX
+                                                                : FUSB302_TRACE_WRITE,
+                            reg, buf, numRegs, !ok);
+    }
+    return ok;
+}
+
+static bool I2CRead(FUSB302_Platform_t *platform, int reg, uint8_t *buf, int numRegs) {
+    FUSB302_I2CPolicy_t *policy = platform->i2cPolicy;
+
+    if (PlatformRead(platform, reg, buf, numRegs, I2CTimeout(platform))) {
+        return true;
     }
 
-    if (ret < 0) {
+    if (!policy) {
         return false;
     }
+    policy->errors++;
 
-    return true;
+    // Retry idempotent reads only, with exponential backoff
+    if (!IsIdempotentRead(reg, numRegs)) {
+        return false;
+    }
+    uint32_t backoffUs = policy->retryDelayUs;
+    for (int i = 0; i < policy->readRetries; i++) {
+        if (backoffUs) {
+            platform->delayUs(backoffUs);
+            backoffUs *= 2;
+        }
+
+        policy->retries++;
+        if (PlatformRead(platform, reg, buf, numRegs, policy->timeout)) {
+            return true;
+        }
+        policy->errors++;
+    }
+
+    return false;
+}
+
+static bool I2CWrite(FUSB302_Platform_t *platform, int reg, const uint8_t *buf, int numRegs) {
+    // Writes are never retried (RESET, CONTROL0/1 flush and TX bits have side effects)
+    if (PlatformWrite(platform, reg, buf, numRegs, I2CTimeout(platform))) {
+        return true;
+    }
+
+    if (platform->i2cPolicy) {
+        platform->i2cPolicy->errors++;
+    }
+    return false;
+}
+
+void FUSB302_SetupI2CPolicy(FUSB302_I2CPolicy_t *policy, int timeout, uint8_t readRetries,
+                            uint32_t retryDelayUs) {
+    policy->timeout = timeout;
+    policy->readRetries = readRetries;
+    policy->retryDelayUs = retryDelayUs;
+    policy->errors = 0;
+    policy->retries = 0;
+}
+
+bool FUSB302_ReadControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
+    // Read register data
+    if (reg != FUSB302_REG_ALL) {
+        return I2CRead(platform, reg, &data->controlRegData[reg - FUSB302_REG_CONTROL_START], 1);
+    } else {
+        return I2CRead(platform, FUSB302_REG_CONTROL_START, data->controlRegData,
+                       FUSB302_REG_CONTROL_NUM);
+    }
 }
 
 bool FUSB302_ReadControlDataSeq(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg,
                                 int numRegs) {
-    return platform->i2cReadReg(FUSB302_I2C_ADDR, reg,
-                                &data->controlRegData[reg - FUSB302_REG_CONTROL_START], numRegs,
-                                I2C_TIMEOUT) >= 0;
+    return I2CRead(platform, reg, &data->controlRegData[reg - FUSB302_REG_CONTROL_START], numRegs);
 }
 
 bool FUSB302_WriteControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
     // Write register data
-    int ret;
     if (reg != FUSB302_REG_ALL) {
-        ret = platform->i2cWriteReg(FUSB302_I2C_ADDR, reg,
-                                    &data->controlRegData[reg - FUSB302_REG_CONTROL_START], 1,
-                                    I2C_TIMEOUT);
+        return I2CWrite(platform, reg, &data->controlRegData[reg - FUSB302_REG_CONTROL_START], 1);
     } else {
-        ret = platform->i2cWriteReg(FUSB302_I2C_ADDR, FUSB302_REG_CONTROL_START,
-                                    data->controlRegData, FUSB302_REG_CONTROL_NUM, I2C_TIMEOUT);
-    }
-
-    if (ret < 0) {
-        return false;
+        return I2CWrite(platform, FUSB302_REG_CONTROL_START, data->controlRegData,
+                        FUSB302_REG_CONTROL_NUM);
     }
-
-    return true;
 }
 
 bool FUSB302_WriteControlDataSeq(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg,
                                  int numRegs) {
-    return platform->i2cWriteReg(FUSB302_I2C_ADDR, reg,
-                                 &data->controlRegData[reg - FUSB302_REG_CONTROL_START], numRegs,
-                                 I2C_TIMEOUT) >= 0;
+    return I2CWrite(platform, reg, &data->controlRegData[reg - FUSB302_REG_CONTROL_START],
+                    numRegs);
 }
 
 void FUSB302_DebugPrintControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
@@ -72,28 +159,17 @@ void FUSB302_DebugPrintControlData(FUSB302_Platform_t *platform, FUSB302_Data_t
 }
 
 bool FUSB302_ReadStatusData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
-    int ret;
     if (reg != FUSB302_REG_ALL) {
-        ret = platform->i2cReadReg(FUSB302_I2C_ADDR, reg,
-                                   &data->statusRegData[reg - FUSB302_REG_STATUS_START], 1,
-                                   I2C_TIMEOUT);
+        return I2CRead(platform, reg, &data->statusRegData[reg - FUSB302_REG_STATUS_START], 1);
     } else {
-        ret = platform->i2cReadReg(FUSB302_I2C_ADDR, FUSB302_REG_STATUS_START, data->statusRegData,
-                                   FUSB302_REG_STATUS_NUM, I2C_TIMEOUT);
-    }
-
-    if (ret < 0) {
-        return false;
+        return I2CRead(platform, FUSB302_REG_STATUS_START, data->statusRegData,
+                       FUSB302_REG_STATUS_NUM);
     }
-
-    return true;
 }
 
 bool FUSB302_ReadStatusDataSeq(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg,
                                int numRegs) {
-    return platform->i2cReadReg(FUSB302_I2C_ADDR, reg,
-                                &data->statusRegData[reg - FUSB302_REG_STATUS_START], numRegs,
-                                I2C_TIMEOUT) >= 0;
+    return I2CRead(platform, reg, &data->statusRegData[reg - FUSB302_REG_STATUS_START], numRegs);
 }
 
 void FUSB302_DebugPrintStatusData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg) {
@@ -114,13 +190,11 @@ void FUSB302_DebugPrintStatusData(FUSB302_Platform_t *platform, FUSB302_Data_t *
 }
 
 bool FUSB302_ReadFIFO(FUSB302_Platform_t *platform, uint8_t *data, uint8_t length) {
-    return platform->i2cReadReg(FUSB302_I2C_ADDR, FUSB302_REG_FIFOS, data, length, I2C_TIMEOUT) >=
-           0;
+    return I2CRead(platform, FUSB302_REG_FIFOS, data, length);
 }
 
 bool FUSB302_WriteFIFO(FUSB302_Platform_t *platform, uint8_t *data, uint8_t length) {
-    return platform->i2cWriteReg(FUSB302_I2C_ADDR, FUSB302_REG_FIFOS, data, length, I2C_TIMEOUT) >=
-           0;
+    return I2CWrite(platform, FUSB302_REG_FIFOS, data, length);
 }
 
 uint8_t *FUSB302_GetRegPtr(FUSB302_Data_t *data, int reg) {
@@ -184,5 +258,73 @@ bool FUSB302_Reset(FUSB302_Platform_t *platform, FUSB302_Data_t *data) {
     FUSB302_SetDataBit(data, FUSB302_REG_RESET, FUSB302_SW_RESET, 1);
 
     // Write updated register
-    return FUSB302_WriteControlData(platform, data, FUSB302_REG_RESET);
+    bool ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_RESET);
+    FUSB302_SetDataBit(data, FUSB302_REG_RESET, FUSB302_SW_RESET, 0);
+
+    return ok;
+}
+
+bool FUSB302_ResetPD(FUSB302_Platform_t *platform, FUSB302_Data_t *data) {
+    // Reset just the PD logic for both the PD transmitter and receiver
+    FUSB302_SetDataBit(data, FUSB302_REG_RESET, FUSB302_PD_RESET, 1);
+    bool ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_RESET);
+    FUSB302_SetDataBit(data, FUSB302_REG_RESET, FUSB302_PD_RESET, 0);
+
+    return ok;
+}
+
+bool FUSB302_FlushFIFO(FUSB302_Platform_t *platform, FUSB302_Data_t *data) {
+    // Flush TX and RX FIFO with one write (CONTROL0 and CONTROL1 are adjacent)
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 1);
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 1);
+    bool ok = FUSB302_WriteControlDataSeq(platform, data, FUSB302_REG_CONTROL0, 2);
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 0);
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 0);
+
+    return ok;
+}
+
+bool FUSB302_SyncControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             int *numWritten) {
+    // Read chip control registers into a separate image
+    FUSB302_Data_t chip;
+    if (!FUSB302_ReadControlData(platform, &chip, FUSB302_REG_ALL)) {
+        return false;
+    }
+
+    bool ok = true;
+    *numWritten = 0;
+
+    // Write back differing registers, read-only and write/clear registers are skipped
+    int runStart = -1, runEnd = -1;
+    for (int reg = FUSB302_REG_CONTROL_START;
+         reg < FUSB302_REG_CONTROL_START + FUSB302_REG_CONTROL_NUM; reg++) {
+        if (reg == FUSB302_REG_DEVICE_ID || reg == FUSB302_REG_RESET) {
+            continue;
+        }
+        if (*FUSB302_GetRegPtr(data, reg) == *FUSB302_GetRegPtr(&chip, reg)) {
+            continue;
+        }
+
+        // Extend current run over a small gap, rewriting equal registers is cheaper than a new
+        // transfer
+        if (runStart >= 0 && reg - runEnd - 1 <= SYNC_MERGE_GAP) {
+            runEnd = reg;
+            continue;
+        }
+
+        if (runStart >= 0) {
+            ok &= FUSB302_WriteControlDataSeq(platform, data, runStart, runEnd - runStart + 1);
+            *numWritten += runEnd - runStart + 1;
+        }
+        runStart = reg;
+        runEnd = reg;
+    }
+
+    if (runStart >= 0) {
+        ok &= FUSB302_WriteControlDataSeq(platform, data, runStart, runEnd - runStart + 1);
+        *numWritten += runEnd - runStart + 1;
+    }
+
+    return ok;
 }
@@ -51,6 +51,23 @@ extern "C" {
 
 #define FUSB302_REG_FIFOS 0x43
 
+// Control register reset values
+#define FUSB302_RESET_SWITCHES0 0x03
+#define FUSB302_RESET_SWITCHES1 0x20
+#define FUSB302_RESET_MEASURE 0x31
+#define FUSB302_RESET_SLICE 0x60
+#define FUSB302_RESET_CONTROL0 0x24
+#define FUSB302_RESET_CONTROL1 0x00
+#define FUSB302_RESET_CONTROL2 0x02
+#define FUSB302_RESET_CONTROL3 0x06
+#define FUSB302_RESET_MASK 0x00
+#define FUSB302_RESET_POWER 0x01
+#define FUSB302_RESET_RESET 0x00
+#define FUSB302_RESET_OCREG 0x0F
+#define FUSB302_RESET_MASKA 0x00
+#define FUSB302_RESET_MASKB 0x00
+#define FUSB302_RESET_CONTROL4 0x00
+
 // FUSB302_REG_DEVICE_ID, all R
 #define FUSB302_VERSION_ID_BITS 0xF0
 #define FUSB302_VERSION_ID_OFFSET 4
@@ -86,6 +103,8 @@ extern "C" {
 #define FUSB302_MDAC_OFFSET 0
 #define FUSB302_MDAC_LSB_MV 42
 #define FUSB302_MDAC_ZERO_MV 42
+#define FUSB302_MDAC_VBUS_LSB_MV 420
+#define FUSB302_MDAC_VBUS_ZERO_MV 420
 
 // FUSB302_REG_SLICE, all R/W
 #define FUSB302_SDAC_HYS_BITS (0x3 << 6)
@@ -313,6 +332,27 @@ typedef enum FUSB302_CC_Orientation {
 typedef uint32_t FUSB302_CycleTime;
 typedef int32_t FUSB302_TimeDiffMs;
 
+// I2C timeout used when the platform has no I2C policy
+#define FUSB302_I2C_DEFAULT_TIMEOUT 1
+
+// Per-port I2C access policy. Only idempotent reads are retried: reads touching the interrupt
+// registers (cleared on read) or the FIFO are never repeated, neither are writes.
+typedef struct FUSB302_I2CPolicy {
+    int timeout;           // passed to the platform I2C callbacks
+    uint8_t readRetries;   // extra attempts for idempotent reads
+    uint32_t retryDelayUs; // delay before the first retry, doubled for every next one (0: none)
+
+    // Statistics
+    uint32_t errors;  // failed accesses, including failed retries
+    uint32_t retries; // retry attempts
+} FUSB302_I2CPolicy_t;
+
+// Message buffer pool (FUSB302Pool.h)
+typedef struct FUSB302_BufferPool FUSB302_BufferPool_t;
+
+// Binary access trace (FUSB302Trace.h)
+typedef struct FUSB302_Trace FUSB302_Trace_t;
+
 typedef struct FUSB302_Platform {
     int (*i2cWriteReg)(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
                        uint8_t wait);
@@ -322,6 +362,19 @@ typedef struct FUSB302_Platform {
     FUSB302_TimeDiffMs (*getTimeDiffMs)(FUSB302_CycleTime end, FUSB302_CycleTime start);
 
     FUSB302_CycleTime invalidCycleTime;
+
+    // Optional (may be 0): current cycle time, used for latency profiling
+    FUSB302_CycleTime (*getCycleTime)(void);
+
+    // Optional (may be 0): I2C timeout and retry policy of this port
+    FUSB302_I2CPolicy_t *i2cPolicy;
+
+    // Required: PD message buffers of this port (FUSB302_SetupBufferPool). There is no shared
+    // default pool any more, host monitoring setup fails without one.
+    FUSB302_BufferPool_t *bufferPool;
+
+    // Optional (may be 0): capture of all I2C accesses of this port
+    FUSB302_Trace_t *trace;
 } FUSB302_Platform_t;
 
 typedef struct FUSB302_Data {
@@ -329,6 +382,21 @@ typedef struct FUSB302_Data {
     uint8_t statusRegData[FUSB302_REG_STATUS_NUM];
 } FUSB302_Data_t;
 
+// Compile-time bus backend: with FUSB302_STATIC_BUS defined for the whole library, register
+// accesses of all layers call these two functions instead of platform->i2cReadReg / i2cWriteReg
+// (direct calls the compiler can inline, no indirect branches). The application defines them once
+// (FUSB302_DEFINE_STATIC_BUS in FUSB302.hpp). I2C policy, retries and trace work as before,
+// fault injection (FUSB302FaultInject.h) wraps the function pointers and does not apply.
+#ifdef FUSB302_STATIC_BUS
+int FUSB302_StaticI2CReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length,
+                             int timeout);
+int FUSB302_StaticI2CWriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data,
+                              uint8_t length, uint8_t wait);
+#endif
+
+void FUSB302_SetupI2CPolicy(FUSB302_I2CPolicy_t *policy, int timeout, uint8_t readRetries,
+                            uint32_t retryDelayUs);
+
 bool FUSB302_ReadControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg);
 bool FUSB302_ReadControlDataSeq(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int reg,
                                 int numRegs);
@@ -354,6 +422,10 @@ int FUSB302_GetDataValue(FUSB302_Data_t *data, int reg, int bitMask, int offset)
 void FUSB302_SetDataValue(FUSB302_Data_t *data, int reg, int bitMask, int offset, int value);
 
 bool FUSB302_Reset(FUSB302_Platform_t *platform, FUSB302_Data_t *data);
+bool FUSB302_ResetPD(FUSB302_Platform_t *platform, FUSB302_Data_t *data);
+bool FUSB302_FlushFIFO(FUSB302_Platform_t *platform, FUSB302_Data_t *data);
+bool FUSB302_SyncControlData(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             int *numWritten);
 
 #ifdef __cplusplus
 }
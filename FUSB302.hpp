@@ -0,0 +1,125 @@
+#ifndef FUSB302_HPP
+#define FUSB302_HPP
+
+// Header-only C++ facade over the register interface. Bus and timer are template parameters with
+// static member functions:
+//
+//   struct Bus {
+//       static bool read(uint8_t addr7bit, uint8_t reg, uint8_t *data, uint8_t length);
+//       static bool write(uint8_t addr7bit, uint8_t reg, const uint8_t *data, uint8_t length);
+//   };
+//   struct Timer {
+//       static void delayUs(uint32_t us);
+//   };
+//
+// Device owns the FUSB302_Platform_t and FUSB302_Data_t of one port and runs every access through
+// the C register layer (FUSB302.c), so the I2C policy, retries and trace hooks apply to it like to
+// all other layers, which take device.platform() and device.data(). Register accesses reach the
+// Bus through the platform function pointers set up by PlatformAdapter, or as direct calls when
+// the library is built with FUSB302_STATIC_BUS and the application defines the backend once:
+//
+//   FUSB302_DEFINE_STATIC_BUS(Bus, FUSB302_I2C_ADDR)
+
+#include <stdint.h>
+
+#include "FUSB302.h"
+
+namespace fusb302 {
+
+// FUSB302_Platform_t over static backends for the C API. debugPrint, getTimeDiffMs, bufferPool
+// and the optional fields are filled by the caller. Accesses go to Address.
+template <class Bus, class Timer = Bus, uint8_t Address = FUSB302_I2C_ADDR>
+struct PlatformAdapter {
+    static int i2cWriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
+                           uint8_t wait) {
+        (void)addr7bit;
+        (void)wait;
+        return Bus::write(Address, regNum, data, length) ? 0 : -1;
+    }
+
+    static int i2cReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length,
+                          int timeout) {
+        (void)addr7bit;
+        (void)timeout;
+        return Bus::read(Address, regNum, data, length) ? 0 : -1;
+    }
+
+    static void delayUs(uint32_t us) { Timer::delayUs(us); }
+
+    static void setup(FUSB302_Platform_t *platform) {
+        platform->i2cWriteReg = &i2cWriteReg;
+        platform->i2cReadReg = &i2cReadReg;
+        platform->delayUs = &delayUs;
+    }
+};
+
+template <class Bus, uint8_t Address = FUSB302_I2C_ADDR, class Timer = Bus> class Device {
+  public:
+    Device() : platform_(), data_() { PlatformAdapter<Bus, Timer, Address>::setup(&platform_); }
+
+    FUSB302_Platform_t *platform() { return &platform_; }
+    FUSB302_Data_t *data() { return &data_; }
+    const FUSB302_Data_t *data() const { return &data_; }
+
+    // Control registers (reg or FUSB302_REG_ALL)
+    bool readControl(int reg) { return FUSB302_ReadControlData(&platform_, &data_, reg); }
+    bool readControlSeq(int reg, int numRegs) {
+        return FUSB302_ReadControlDataSeq(&platform_, &data_, reg, numRegs);
+    }
+    bool writeControl(int reg) { return FUSB302_WriteControlData(&platform_, &data_, reg); }
+    bool writeControlSeq(int reg, int numRegs) {
+        return FUSB302_WriteControlDataSeq(&platform_, &data_, reg, numRegs);
+    }
+
+    // Status registers (reg or FUSB302_REG_ALL), interrupt registers are cleared on read
+    bool readStatus(int reg) { return FUSB302_ReadStatusData(&platform_, &data_, reg); }
+    bool readStatusSeq(int reg, int numRegs) {
+        return FUSB302_ReadStatusDataSeq(&platform_, &data_, reg, numRegs);
+    }
+
+    bool readFIFO(uint8_t *buf, uint8_t length) {
+        return FUSB302_ReadFIFO(&platform_, buf, length);
+    }
+    bool writeFIFO(const uint8_t *buf, uint8_t length) {
+        return FUSB302_WriteFIFO(&platform_, const_cast<uint8_t *>(buf), length);
+    }
+
+    // Register image access, same semantics as FUSB302_GetDataBit etc.
+    int getBit(int reg, int bitMask) { return FUSB302_GetDataBit(&data_, reg, bitMask); }
+    void setBit(int reg, int bitMask, int value) {
+        FUSB302_SetDataBit(&data_, reg, bitMask, value);
+    }
+    int getValue(int reg, int bitMask, int offset) {
+        return FUSB302_GetDataValue(&data_, reg, bitMask, offset);
+    }
+    void setValue(int reg, int bitMask, int offset, int value) {
+        FUSB302_SetDataValue(&data_, reg, bitMask, offset, value);
+    }
+
+    bool reset() { return FUSB302_Reset(&platform_, &data_); }
+    bool resetPD() { return FUSB302_ResetPD(&platform_, &data_); }
+    bool flushFIFO() { return FUSB302_FlushFIFO(&platform_, &data_); }
+
+    static void delayUs(uint32_t us) { Timer::delayUs(us); }
+
+  private:
+    FUSB302_Platform_t platform_;
+    FUSB302_Data_t data_;
+};
+
+} // namespace fusb302
+
+// Backend of a FUSB302_STATIC_BUS build, once per program at namespace scope
+#define FUSB302_DEFINE_STATIC_BUS(Bus, Address)                                                    \
+    extern "C" int FUSB302_StaticI2CReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data,       \
+                                            uint8_t length, int timeout) {                         \
+        return fusb302::PlatformAdapter<Bus, Bus, Address>::i2cReadReg(addr7bit, regNum, data,     \
+                                                                       length, timeout);           \
+    }                                                                                              \
+    extern "C" int FUSB302_StaticI2CWriteReg(uint8_t addr7bit, uint8_t regNum,                     \
+                                             const uint8_t *data, uint8_t length, uint8_t wait) {  \
+        return fusb302::PlatformAdapter<Bus, Bus, Address>::i2cWriteReg(addr7bit, regNum, data,    \
+                                                                        length, wait);             \
+    }
+
+#endif // FUSB302_HPP
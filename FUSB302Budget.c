@@ -0,0 +1,175 @@
+#include "FUSB302Budget.h"
+
+static FUSB302_HostCurrentMode_t CableMode(const FUSB302_Budget_t *budget,
+                                           const FUSB302_HostMonitoring_t *monitoring) {
+    // E-marked cable current caps the Rp (unknown: every Type-C cable carries 3 A)
+    FUSB302_HostCurrentMode_t mode = budget->maxMode;
+    uint16_t cableMa = monitoring->emarkerPresent ? monitoring->cableIdentity.vbusCurrentMa : 0;
+    if (cableMa && cableMa < FUSB302_GetHostCurrentMa(mode)) {
+        mode = cableMa >= 1500 ? FUSB302_HOST_CURRENT_MODE_1_5A : FUSB302_HOST_CURRENT_MODE_500MA;
+    }
+    return mode;
+}
+
+static uint32_t Max(uint32_t a, uint32_t b) {
+    return a > b ? a : b;
+}
+
+static uint32_t HeldMa(const FUSB302_BudgetPort_t *port) {
+    // Granted current and current still drawn after a downgrade
+    return Max(FUSB302_GetHostCurrentMa(port->grant), port->releaseMa);
+}
+
+static uint32_t CommittedMa(const FUSB302_BudgetPort_t *port) {
+    // Advertised Rp (a device may attach any time) and current still drawn after a downgrade
+    return Max(FUSB302_GetHostCurrentMa(port->monitoring->hostCurrentSetting), port->releaseMa);
+}
+
+static FUSB302_HostCurrentMode_t Fit(FUSB302_BudgetPort_t *port, FUSB302_HostCurrentMode_t want,
+                                     int32_t *remaining) {
+    // Highest mode from want down to the current grant that the headroom covers
+    uint32_t held = HeldMa(port);
+    for (int mode = want; mode > (int)port->grant; mode--) {
+        uint32_t ma = FUSB302_GetHostCurrentMa((FUSB302_HostCurrentMode_t)mode);
+        int32_t extra = ma > held ? (int32_t)(ma - held) : 0;
+        if (extra <= *remaining) {
+            *remaining -= extra;
+            return (FUSB302_HostCurrentMode_t)mode;
+        }
+    }
+    return port->grant;
+}
+
+uint32_t FUSB302_GetHostCurrentMa(FUSB302_HostCurrentMode_t hostCurrentMode) {
+    switch (hostCurrentMode) {
+    case FUSB302_HOST_CURRENT_MODE_3A:
+        return 3000;
+    case FUSB302_HOST_CURRENT_MODE_1_5A:
+        return 1500;
+    default:
+        return FUSB302_BUDGET_DEFAULT_MA;
+    }
+}
+
+void FUSB302_SetupBudget(FUSB302_Budget_t *budget, FUSB302_BudgetPort_t *ports, int numPorts,
+                         uint32_t limitMa, FUSB302_HostCurrentMode_t maxMode) {
+    budget->ports = ports;
+    budget->numPorts = numPorts;
+    budget->limitMa = limitMa;
+    budget->maxMode = maxMode;
+    budget->reservedMa = 0;
+    budget->committedMa = 0;
+    budget->upgrades = 0;
+    budget->downgrades = 0;
+
+    for (int i = 0; i < numPorts; i++) {
+        ports[i].monitoring = 0;
+        ports[i].grant = FUSB302_HOST_CURRENT_MODE_500MA;
+        ports[i].releaseMa = 0;
+    }
+}
+
+bool FUSB302_SetBudgetPort(FUSB302_Budget_t *budget, int port,
+                           FUSB302_HostMonitoring_t *monitoring) {
+    if (port < 0 || port >= budget->numPorts) {
+        return false;
+    }
+
+    budget->ports[port].monitoring = monitoring;
+    budget->ports[port].grant = monitoring->hostCurrentSetting;
+    budget->ports[port].releaseMa = 0;
+    return true;
+}
+
+void FUSB302_SetBudgetLimit(FUSB302_Budget_t *budget, uint32_t limitMa) {
+    budget->limitMa = limitMa;
+}
+
+void FUSB302_UpdateBudget(FUSB302_Platform_t *platform, FUSB302_Budget_t *budget,
+                          FUSB302_CycleTime time) {
+    // Headroom after default current and pending releases of every port, the headroom used by a
+    // port is HeldMa from here on
+    int32_t remaining = (int32_t)budget->limitMa;
+    budget->committedMa = 0;
+    for (int i = 0; i < budget->numPorts; i++) {
+        FUSB302_BudgetPort_t *port = &budget->ports[i];
+        if (!port->monitoring) {
+            continue;
+        }
+        if (port->releaseMa &&
+            platform->getTimeDiffMs(time, port->releaseTime) >= FUSB302_T_SINK_ADJ_MS) {
+            port->releaseMa = 0;
+        }
+        remaining -= (int32_t)Max(FUSB302_GetHostCurrentMa(FUSB302_HOST_CURRENT_MODE_500MA),
+                                  port->releaseMa);
+        budget->committedMa += CommittedMa(port);
+    }
+
+    // 1. Attached ports keep their grant while it fits, detached ports drop to default
+    for (int i = 0; i < budget->numPorts; i++) {
+        FUSB302_BudgetPort_t *port = &budget->ports[i];
+        FUSB302_HostCurrentMode_t grant = port->grant;
+        port->grant = FUSB302_HOST_CURRENT_MODE_500MA;
+        if (port->monitoring && FUSB302_IsDeviceAttached(port->monitoring)) {
+            FUSB302_HostCurrentMode_t cable = CableMode(budget, port->monitoring);
+            port->grant = Fit(port, grant < cable ? grant : cable, &remaining);
+        }
+    }
+
+    // 2. Upgrade attached ports, 3. pre-advertise the rest on detached ports
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < budget->numPorts; i++) {
+            FUSB302_BudgetPort_t *port = &budget->ports[i];
+            if (port->monitoring &&
+                FUSB302_IsDeviceAttached(port->monitoring) == (pass == 0)) {
+                port->grant = Fit(port, CableMode(budget, port->monitoring), &remaining);
+            }
+        }
+    }
+
+    budget->reservedMa = (uint32_t)((int32_t)budget->limitMa - remaining);
+}
+
+bool FUSB302_ApplyBudget(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                         FUSB302_Budget_t *budget, int port, FUSB302_CycleTime time) {
+    if (port < 0 || port >= budget->numPorts || !budget->ports[port].monitoring) {
+        return false;
+    }
+    FUSB302_BudgetPort_t *budgetPort = &budget->ports[port];
+    FUSB302_HostMonitoring_t *monitoring = budgetPort->monitoring;
+    FUSB302_HostCurrentMode_t current = monitoring->hostCurrentSetting;
+
+    // Nothing to do, or retry after debounce (MDAC threshold follows the Rp)
+    if (budgetPort->grant == current || FUSB302_IsHostDebouncing(monitoring)) {
+        return true;
+    }
+
+    // Upgrades wait until downgrades of other ports have released the current
+    uint32_t committed = CommittedMa(budgetPort);
+    uint32_t granted = Max(FUSB302_GetHostCurrentMa(budgetPort->grant), budgetPort->releaseMa);
+    if (budgetPort->grant > current && budget->committedMa - committed + granted > budget->limitMa) {
+        return true;
+    }
+
+    if (!FUSB302_SetHostCurrent(platform, data, monitoring, budgetPort->grant)) {
+        return false;
+    }
+
+    if (budgetPort->grant < current) {
+        // Sink may draw the old current for tSinkAdj
+        if (FUSB302_IsDeviceAttached(monitoring)) {
+            budgetPort->releaseMa = FUSB302_GetHostCurrentMa(current);
+            budgetPort->releaseTime = time;
+        }
+        budget->downgrades++;
+    } else {
+        budget->upgrades++;
+    }
+    budget->committedMa = budget->committedMa - committed + CommittedMa(budgetPort);
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Port %d Rp %d -> %d\r\n", port, current, budgetPort->grant);
+#endif
+
+    return true;
+}
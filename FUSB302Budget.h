@@ -0,0 +1,76 @@
+#ifndef FUSB302_BUDGET_H
+#define FUSB302_BUDGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FUSB302Host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Current budget of host ports on a shared supply. Every port always has USB default current,
+// attached ports keep what they were granted while it fits, then attached ports are upgraded and
+// the headroom left is pre-advertised on detached ports (seen by the next device on attach).
+// Cable current limits from the e-marker identity are honored.
+//
+// The budget owns the Rp setting of its ports (FUSB302_SetHostCurrent, one transfer). PD 3.0
+// SinkTxNG only caps it temporarily (FUSB302_SetHostCurrentCap), so a downgrade stays in place.
+// A port commits its Rp setting until a downgrade is applied, attached ports keep the old current
+// for tSinkAdj after that. Upgrades are applied only when the committed current leaves room, so
+// the supply is never overcommitted while ports change one by one.
+
+// Current reserved for USB default Rp (USB 3.x: 900 mA)
+#ifndef FUSB302_BUDGET_DEFAULT_MA
+#define FUSB302_BUDGET_DEFAULT_MA 900
+#endif
+
+// Sink adjusts its current to a lower Rp within tSinkAdj (max 60 ms)
+#ifndef FUSB302_T_SINK_ADJ_MS
+#define FUSB302_T_SINK_ADJ_MS 60
+#endif
+
+typedef struct FUSB302_BudgetPort {
+    FUSB302_HostMonitoring_t *monitoring; // 0: port not managed
+    FUSB302_HostCurrentMode_t grant;
+    uint32_t releaseMa; // current the sink may still draw after a downgrade (0: none)
+    FUSB302_CycleTime releaseTime;
+} FUSB302_BudgetPort_t;
+
+typedef struct FUSB302_Budget {
+    FUSB302_BudgetPort_t *ports;
+    int numPorts;
+    uint32_t limitMa;
+    FUSB302_HostCurrentMode_t maxMode; // highest Rp of any port
+
+    uint32_t committedMa; // advertised plus pending releases of all ports
+
+    // Statistics
+    uint32_t reservedMa; // granted plus pending releases, last update
+    uint32_t upgrades;
+    uint32_t downgrades;
+} FUSB302_Budget_t;
+
+void FUSB302_SetupBudget(FUSB302_Budget_t *budget, FUSB302_BudgetPort_t *ports, int numPorts,
+                         uint32_t limitMa, FUSB302_HostCurrentMode_t maxMode);
+// Port after FUSB302_SetupHostMonitoring (or resume), starts at the mode it was set up with
+bool FUSB302_SetBudgetPort(FUSB302_Budget_t *budget, int port,
+                           FUSB302_HostMonitoring_t *monitoring);
+// Supply derating, attached ports above the new limit are downgraded on the next update
+void FUSB302_SetBudgetLimit(FUSB302_Budget_t *budget, uint32_t limitMa);
+
+// Recomputes grants from the port states (no I/O), call after updating the ports
+void FUSB302_UpdateBudget(FUSB302_Platform_t *platform, FUSB302_Budget_t *budget,
+                          FUSB302_CycleTime time);
+// Applies the grant of one port (one register transfer if it changed)
+bool FUSB302_ApplyBudget(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                         FUSB302_Budget_t *budget, int port, FUSB302_CycleTime time);
+
+uint32_t FUSB302_GetHostCurrentMa(FUSB302_HostCurrentMode_t hostCurrentMode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_BUDGET_H
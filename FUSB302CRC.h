@@ -0,0 +1,46 @@
+#ifndef FUSB302_CRC_H
+#define FUSB302_CRC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// USB PD CRC-32 (polynomial 0x04C11DB7, reflected, init and final XOR 0xFFFFFFFF, sent LSB first
+// behind the packet). The FUSB302 generates (JAM_CRC) and checks the CRC of live traffic, this
+// module serves captures, models and optional packet verification.
+
+// Slicing-by-8: 8 KB of tables in RAM (built on first use or by FUSB302_SetupCRC) instead of the
+// 1 KB table in flash, about 4x faster on 64-bit hosts
+#ifndef FUSB302_CRC_SLICING
+#define FUSB302_CRC_SLICING 0
+#endif
+
+// Hardware CRC if the target supports it: ARMv8 CRC32 instructions, x86 PCLMULQDQ folding
+#ifndef FUSB302_CRC_HARDWARE
+#define FUSB302_CRC_HARDWARE 1
+#endif
+
+#define FUSB302_CRC_SIZE 4
+
+// Continues crc (0 to start) over len bytes, fastest implementation of this build
+uint32_t FUSB302_UpdateCRC(uint32_t crc, const uint8_t *data, uint32_t len);
+const char *FUSB302_GetCRCImplementation(void);
+
+// Individual implementations, same results
+uint32_t FUSB302_UpdateCRCTable(uint32_t crc, const uint8_t *data, uint32_t len);
+#if FUSB302_CRC_SLICING
+void FUSB302_SetupCRC(void); // builds the slicing tables, call before concurrent use
+uint32_t FUSB302_UpdateCRCSlicing(uint32_t crc, const uint8_t *data, uint32_t len);
+#endif
+
+// Packet as returned by FUSB302_ExtractPacket (header, data, CRC)
+bool FUSB302_VerifyPacketCRC(const uint8_t *packet, int packetLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_CRC_H
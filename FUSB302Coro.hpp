@@ -0,0 +1,398 @@
+#ifndef FUSB302_CORO_HPP
+#define FUSB302_CORO_HPP
+
+// C++20 coroutine facade (Linux). Driver operations of a port run on the port's own stack (fiber);
+// every platform->delayUs inside them suspends that fiber on a timer of the executor instead of
+// blocking the thread, so one thread drives many ports concurrently:
+//
+//   fusb302::coro::Executor executor;
+//   fusb302::coro::Port port(executor);
+//   platform.delayUs = fusb302::coro::Executor::delayUs;
+//
+//   fusb302::coro::Task<> Run(Port &port, ...) {
+//       co_await fusb302::coro::SetupHostMonitoring(port, &platform, &data, ...);
+//       for (;;) {
+//           co_await fusb302::coro::UpdateHostMonitoring(port, &platform, &data, ...);
+//           co_await executor.sleepUs(10000);
+//       }
+//   }
+//
+//   executor.spawn(Run(port, ...));
+//   executor.run();
+//
+// delayUs called outside a port (plain C use) sleeps as before.
+
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "FUSB302.h"
+#include "FUSB302DRP.h"
+#include "FUSB302Host.h"
+#include "FUSB302PD.h"
+#include "FUSB302Sink.h"
+#include "FUSB302Toggle.h"
+
+namespace fusb302::coro {
+
+#ifndef FUSB302_CORO_STACK_SIZE
+#define FUSB302_CORO_STACK_SIZE 16384
+#endif
+
+template <class T = void> class Task;
+
+namespace detail {
+
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <class P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        // Continue the awaiting coroutine, a spawned task just stops
+        std::coroutine_handle<> continuation = h.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+
+template <class T> struct Promise : PromiseBase {
+    T value{};
+
+    Task<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+};
+
+template <> struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+inline int64_t NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+} // namespace detail
+
+// Lazily started task, runs when awaited or spawned
+template <class T> class Task {
+  public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    bool await_ready() const { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+    T await_resume() {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(handle_.promise().value);
+        }
+    }
+
+  private:
+    friend class Executor;
+
+    Handle handle_;
+};
+
+template <class T> Task<T> detail::Promise<T>::get_return_object() {
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object() {
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+class Port;
+
+// Single-threaded executor, all timers share one timerfd armed for the earliest deadline
+class Executor {
+  public:
+    Executor() {
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (epollFd_ < 0 || timerFd_ < 0) {
+            std::abort();
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = timerFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &event);
+    }
+
+    ~Executor() {
+        close(timerFd_);
+        close(epollFd_);
+    }
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    struct SleepAwaiter {
+        Executor &executor;
+        uint32_t us;
+
+        bool await_ready() const { return us == 0; }
+        void await_suspend(std::coroutine_handle<> h) {
+            executor.addTimer(us, [h] { h.resume(); });
+        }
+        void await_resume() const {}
+    };
+
+    SleepAwaiter sleepUs(uint32_t us) { return SleepAwaiter{*this, us}; }
+
+    void spawn(Task<void> task) {
+        std::coroutine_handle<> handle = task.handle_;
+        tasks_.push_back(std::move(task));
+        handle.resume();
+    }
+
+    // Runs until no timer is pending
+    void run() {
+        while (!timers_.empty()) {
+            arm(timers_.top().deadline);
+
+            epoll_event event;
+            if (epoll_wait(epollFd_, &event, 1, -1) < 0) {
+                continue;
+            }
+            uint64_t expirations;
+            (void)read(timerFd_, &expirations, sizeof(expirations));
+
+            // Fire due timers, callbacks may add new ones
+            int64_t now = detail::NowNs();
+            while (!timers_.empty() && timers_.top().deadline <= now) {
+                std::function<void()> callback = timers_.top().callback;
+                timers_.pop();
+                callback();
+            }
+
+            reap();
+        }
+        reap();
+    }
+
+    void addTimer(uint32_t us, std::function<void()> callback) {
+        timers_.push(Timer{detail::NowNs() + (int64_t)us * 1000, seq_++, std::move(callback)});
+    }
+
+    // FUSB302_Platform_t::delayUs of ports driven by this executor
+    static void delayUs(uint32_t us);
+
+  private:
+    struct Timer {
+        int64_t deadline;
+        uint64_t seq; // FIFO order for equal deadlines
+        std::function<void()> callback;
+
+        bool operator>(const Timer &other) const {
+            return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+        }
+    };
+
+    void arm(int64_t deadline) {
+        itimerspec spec = {};
+        spec.it_value.tv_sec = deadline / 1000000000;
+        spec.it_value.tv_nsec = deadline % 1000000000;
+        timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    void reap() {
+        for (size_t i = 0; i < tasks_.size();) {
+            if (tasks_[i].done()) {
+                tasks_[i] = std::move(tasks_.back());
+                tasks_.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    int epollFd_;
+    int timerFd_;
+    uint64_t seq_ = 0;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::vector<Task<void>> tasks_;
+};
+
+// Fiber running the C calls of one FUSB302, one call at a time
+class Port {
+  public:
+    explicit Port(Executor &executor, size_t stackSize = FUSB302_CORO_STACK_SIZE)
+        : executor_(executor), stack_(stackSize) {}
+
+    Port(const Port &) = delete;
+    Port &operator=(const Port &) = delete;
+
+    struct CallAwaiter {
+        Port &port;
+        std::function<bool()> function;
+
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> continuation) {
+            port.start(std::move(function), continuation);
+            // Completed without waiting: continue right away
+            return !port.enter();
+        }
+        bool await_resume() const { return port.result_; }
+    };
+
+    // Runs function on the port fiber, e.g. co_await port.call([&] { return FUSB302_...(); })
+    CallAwaiter call(std::function<bool()> function) { return CallAwaiter{*this, std::move(function)}; }
+
+    bool busy() const { return busy_; }
+
+    static Port *current() { return current_; }
+
+  private:
+    friend class Executor;
+
+    void start(std::function<bool()> function, std::coroutine_handle<> continuation) {
+        if (busy_) {
+            std::abort(); // one call per port at a time
+        }
+        busy_ = true;
+        function_ = std::move(function);
+        continuation_ = continuation;
+
+        getcontext(&fiber_);
+        fiber_.uc_stack.ss_sp = stack_.data();
+        fiber_.uc_stack.ss_size = stack_.size();
+        fiber_.uc_link = nullptr;
+        uintptr_t self = (uintptr_t)this;
+        makecontext(&fiber_, (void (*)())&Entry, 2, (unsigned)(self & 0xFFFFFFFF),
+                    (unsigned)((uint64_t)self >> 32));
+    }
+
+    static void Entry(unsigned lo, unsigned hi) {
+        Port *port = (Port *)(((uint64_t)hi << 32) | lo);
+        port->result_ = port->function_();
+        port->busy_ = false;
+        setcontext(&port->caller_);
+    }
+
+    // Switches to the fiber until it finishes (true) or waits for a timer (false)
+    bool enter() {
+        Port *previous = current_;
+        current_ = this;
+        swapcontext(&caller_, &fiber_);
+        current_ = previous;
+        return !busy_;
+    }
+
+    void suspend(uint32_t us) {
+        executor_.addTimer(us, [this] {
+            if (enter()) {
+                continuation_.resume();
+            }
+        });
+        swapcontext(&fiber_, &caller_);
+    }
+
+    Executor &executor_;
+    std::vector<uint8_t> stack_;
+    ucontext_t fiber_;
+    ucontext_t caller_;
+    std::function<bool()> function_;
+    std::coroutine_handle<> continuation_;
+    bool result_ = false;
+    bool busy_ = false;
+
+    static inline thread_local Port *current_ = nullptr;
+};
+
+inline void Executor::delayUs(uint32_t us) {
+    Port *port = Port::current();
+    if (port) {
+        port->suspend(us);
+        return;
+    }
+
+    // Not on a port fiber: plain blocking delay
+    timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    nanosleep(&ts, nullptr);
+}
+
+// Public driver operations as tasks
+template <class... Args> Task<bool> SetupHostMonitoring(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_SetupHostMonitoring(args...); });
+}
+
+template <class... Args> Task<bool> UpdateHostMonitoring(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_UpdateHostMonitoring(args...); });
+}
+
+template <class... Args> Task<bool> HostCableDiscoverIdentity(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_HostCableDiscoverIdentity(args...); });
+}
+
+template <class... Args> Task<bool> ProtocolCableDiscoverIdentity(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_ProtocolCableDiscoverIdentity(args...); });
+}
+
+template <class... Args> Task<bool> SetupSinkMonitoring(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_SetupSinkMonitoring(args...); });
+}
+
+template <class... Args> Task<bool> UpdateSinkMonitoring(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_UpdateSinkMonitoring(args...); });
+}
+
+template <class... Args> Task<bool> SetupToggleMode(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_SetupToggleMode(args...); });
+}
+
+template <class... Args> Task<bool> SetupDRP(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_SetupDRP(args...); });
+}
+
+template <class... Args> Task<bool> UpdateDRP(Port &port, Args... args) {
+    co_return co_await port.call([=] { return FUSB302_UpdateDRP(args...); });
+}
+
+} // namespace fusb302::coro
+
+#endif // FUSB302_CORO_HPP
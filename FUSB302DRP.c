@@ -0,0 +1,342 @@
+#include "FUSB302DRP.h"
+#include "FUSB302Toggle.h"
+#include "FUSB302Trace.h"
+
+static FUSB302_ToggleResult_t GetResult(FUSB302_Data_t *data) {
+    // TOGSS is valid once I_TOGDONE is set (STATUS1A read in the same burst)
+    if (!FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_TOGDONE)) {
+        return FUSB302_TOGGLE_RESULT_NONE;
+    }
+
+    switch (FUSB302_GetDataValue(data, FUSB302_REG_STATUS1A, FUSB302_TOGSS_BITS,
+                                 FUSB302_TOGSS_OFFSET)) {
+    case FUSB302_TOGSS_STOP_SRC1:
+        return FUSB302_TOGGLE_RESULT_SRC_CC1;
+    case FUSB302_TOGSS_STOP_SRC2:
+        return FUSB302_TOGGLE_RESULT_SRC_CC2;
+    case FUSB302_TOGSS_STOP_SNK1:
+        return FUSB302_TOGGLE_RESULT_SNK_CC1;
+    case FUSB302_TOGSS_STOP_SNK2:
+        return FUSB302_TOGGLE_RESULT_SNK_CC2;
+    case FUSB302_TOGSS_AUDIO:
+        return FUSB302_TOGGLE_RESULT_AUDIO;
+    default:
+        return FUSB302_TOGGLE_RESULT_NONE;
+    }
+}
+
+static bool IsSourceResult(FUSB302_ToggleResult_t result) {
+    return result == FUSB302_TOGGLE_RESULT_SRC_CC1 || result == FUSB302_TOGGLE_RESULT_SRC_CC2;
+}
+
+static bool IsSinkResult(FUSB302_ToggleResult_t result) {
+    return result == FUSB302_TOGGLE_RESULT_SNK_CC1 || result == FUSB302_TOGGLE_RESULT_SNK_CC2;
+}
+
+static bool IsPartnerPresent(FUSB302_Data_t *data, bool source) {
+    if (source) {
+        // Rd pulls the measured CC below the MDAC level
+        return !FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
+    }
+
+    // Rp above vRd-Connect
+    return FUSB302_GetDataValue(data, FUSB302_REG_STATUS0, FUSB302_BC_LVL_BITS,
+                                FUSB302_BC_LVL_OFFSET) != FUSB302_BC_LVL_0_200MV;
+}
+
+static FUSB302_TimeDiffMs Remaining(FUSB302_Platform_t *platform, FUSB302_CycleTime time,
+                                    FUSB302_CycleTime start, FUSB302_TimeDiffMs ms) {
+    FUSB302_TimeDiffMs elapsed = platform->getTimeDiffMs(time, start);
+    return elapsed >= ms ? 0 : ms - elapsed;
+}
+
+static void SetState(FUSB302_Platform_t *platform, FUSB302_DRPState_t state, FUSB302_CycleTime time,
+                     FUSB302_DRP_t *drp) {
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: DRP state %d -> %d\r\n", drp->state, state);
+#else
+    (void)platform;
+#endif
+
+    drp->state = state;
+    drp->time = time;
+    drp->ccFound = false;
+}
+
+static bool Toggle(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_ToggleMode_t mode,
+                   FUSB302_DRPState_t state, FUSB302_CycleTime time, FUSB302_DRP_t *drp) {
+    SetState(platform, state, time, drp);
+    return FUSB302_StartToggleMode(platform, data, mode, drp->hostCurrentMode);
+}
+
+static bool Hold(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                 FUSB302_ToggleResult_t result, FUSB302_CycleTime time, FUSB302_DRP_t *drp) {
+    bool source = IsSourceResult(result);
+    FUSB302_CC_Orientation_t cc =
+        result == FUSB302_TOGGLE_RESULT_SRC_CC1 || result == FUSB302_TOGGLE_RESULT_SNK_CC1
+            ? FUSB302_CC_ORIENTATION_CC1
+            : FUSB302_CC_ORIENTATION_CC2;
+
+    // Stop toggle, keep the termination of the result and measure the found CC
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOGGLE, 0);
+    bool ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL2);
+
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1,
+                       source && cc == FUSB302_CC_ORIENTATION_CC1);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN2,
+                       source && cc == FUSB302_CC_ORIENTATION_CC2);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC1, 0);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC2, 0);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1,
+                       cc == FUSB302_CC_ORIENTATION_CC1);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2,
+                       cc == FUSB302_CC_ORIENTATION_CC2);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN1, !source);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN2, !source);
+    ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+
+    drp->ccFound = true;
+    drp->ccOrientation = cc;
+    drp->ccTime = time;
+
+    return ok;
+}
+
+static bool AttachSource(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                         FUSB302_CycleTime time, bool debounced, FUSB302_DRP_t *drp) {
+    // Host monitoring discovers orientation and cable on its first update
+    SetState(platform, FUSB302_DRP_STATE_ATTACHED_SRC, time, drp);
+    return FUSB302_StartHostMonitoring(platform, data, drp->hostCurrentMode, time, debounced,
+                                       drp->host);
+}
+
+static bool AttachSink(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_CycleTime time,
+                       FUSB302_DRP_t *drp) {
+    // Sink monitoring waits for VBUS
+    SetState(platform, FUSB302_DRP_STATE_ATTACHED_SNK, time, drp);
+    return FUSB302_StartSinkMonitoring(platform, data, time, drp->sink);
+}
+
+static FUSB302_TimeDiffMs TryTimeoutMs(FUSB302_DRPState_t state) {
+    return state == FUSB302_DRP_STATE_TRY_WAIT_SNK ? FUSB302_T_DRP_TRY_WAIT_MS
+                                                    : FUSB302_T_DRP_TRY_MS;
+}
+
+static bool UpdateTry(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_CycleTime time,
+                      FUSB302_ToggleResult_t result, FUSB302_DRP_t *drp) {
+    bool source =
+        drp->state == FUSB302_DRP_STATE_TRY_SRC || drp->state == FUSB302_DRP_STATE_TRY_WAIT_SRC;
+
+    if (drp->ccFound) {
+        if (!IsPartnerPresent(data, source)) {
+            // Lost during tTryCCDebounce, keep looking until the state times out
+            drp->ccFound = false;
+            return FUSB302_StartToggleMode(platform, data,
+                                           source ? FUSB302_TOGGLE_MODE_SRC
+                                                  : FUSB302_TOGGLE_MODE_SNK,
+                                           drp->hostCurrentMode);
+        }
+        if (platform->getTimeDiffMs(time, drp->ccTime) < FUSB302_T_TRY_CC_DEBOUNCE_MS) {
+            return true;
+        }
+        return source ? AttachSource(platform, data, time, true, drp)
+                      : AttachSink(platform, data, time, drp);
+    }
+
+    if (source ? IsSourceResult(result) : IsSinkResult(result)) {
+        // Source partner was debounced in AttachWait.SNK, sink monitoring waits for VBUS
+        if (drp->state == FUSB302_DRP_STATE_TRY_WAIT_SNK) {
+            return AttachSink(platform, data, time, drp);
+        }
+        return Hold(platform, data, result, time, drp);
+    }
+
+    if (platform->getTimeDiffMs(time, drp->time) < TryTimeoutMs(drp->state)) {
+        return true;
+    }
+
+    // Partner did not take the other role: back to the role it offered, then give up
+    switch (drp->state) {
+    case FUSB302_DRP_STATE_TRY_SRC:
+        drp->tryFallbacks++;
+        return Toggle(platform, data, FUSB302_TOGGLE_MODE_SNK, FUSB302_DRP_STATE_TRY_WAIT_SNK, time,
+                      drp);
+    case FUSB302_DRP_STATE_TRY_SNK:
+        drp->tryFallbacks++;
+        return Toggle(platform, data, FUSB302_TOGGLE_MODE_SRC, FUSB302_DRP_STATE_TRY_WAIT_SRC, time,
+                      drp);
+    default:
+        return Toggle(platform, data, FUSB302_TOGGLE_MODE_DRP, FUSB302_DRP_STATE_UNATTACHED, time,
+                      drp);
+    }
+}
+
+bool FUSB302_SetupDRP(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                      FUSB302_DRPPreference_t preference,
+                      FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                      FUSB302_HostMonitoring_t *host, FUSB302_SinkMonitoring_t *sink,
+                      FUSB302_DRP_t *drp) {
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_DRP_SETUP + hostCurrentMode, time);
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_ARG, preference);
+    }
+
+    // Source role runs host monitoring, which needs the message buffers of the port
+    if (!platform->bufferPool) {
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: No buffer pool, set platform->bufferPool\r\n");
+#endif
+        return false;
+    }
+
+    drp->state = FUSB302_DRP_STATE_UNATTACHED;
+    drp->preference = preference;
+    drp->hostCurrentMode = hostCurrentMode;
+    drp->time = time;
+    drp->ccFound = false;
+    drp->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+    drp->ccTime = time;
+    drp->host = host;
+    drp->sink = sink;
+    drp->tries = 0;
+    drp->tryFallbacks = 0;
+
+    // Reset FUSB302 and start DRP toggle
+    return FUSB302_SetupToggleMode(platform, data, FUSB302_TOGGLE_MODE_DRP, hostCurrentMode);
+}
+
+bool FUSB302_UpdateDRP(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_CycleTime time,
+                       FUSB302_DRP_t *drp) {
+    bool ok = true;
+
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_DRP_UPDATE, time);
+    }
+
+    // Attached: monitoring owns the chip until the partner is gone (a cable alone is unattached)
+    if (drp->state == FUSB302_DRP_STATE_ATTACHED_SRC) {
+        FUSB302_HostMonitoring_t *host = drp->host;
+        ok &= FUSB302_UpdateHostMonitoring(platform, data, time, host);
+        if (host->state != FUSB302_HOST_STATE_INIT && host->state != FUSB302_HOST_STATE_FAULT &&
+            !FUSB302_IsDeviceAttached(host) && !FUSB302_IsHostDebouncing(host)) {
+            ok &= Toggle(platform, data, FUSB302_TOGGLE_MODE_DRP, FUSB302_DRP_STATE_UNATTACHED,
+                         time, drp);
+        }
+        return ok;
+    }
+    if (drp->state == FUSB302_DRP_STATE_ATTACHED_SNK) {
+        ok &= FUSB302_UpdateSinkMonitoring(platform, data, time, drp->sink);
+        if (drp->sink->state == FUSB302_SINK_STATE_UNATTACHED) {
+            ok &= Toggle(platform, data, FUSB302_TOGGLE_MODE_DRP, FUSB302_DRP_STATE_UNATTACHED,
+                         time, drp);
+        }
+        return ok;
+    }
+
+    // Toggle result, interrupts and CC level in one burst (STATUS1A..INTERRUPT)
+    if (!FUSB302_ReadStatusDataSeq(platform, data, FUSB302_REG_STATUS1A,
+                                   FUSB302_REG_INTERRUPT - FUSB302_REG_STATUS1A + 1)) {
+        return false;
+    }
+    FUSB302_ToggleResult_t result = GetResult(data);
+
+    switch (drp->state) {
+    case FUSB302_DRP_STATE_UNATTACHED:
+        if (IsSourceResult(result)) {
+            // Try.SNK first needs Rd for tCCDebounce, host monitoring debounces otherwise
+            if (drp->preference == FUSB302_DRP_PREFER_SNK) {
+                SetState(platform, FUSB302_DRP_STATE_ATTACH_WAIT_SRC, time, drp);
+                ok &= Hold(platform, data, result, time, drp);
+            } else {
+                ok &= AttachSource(platform, data, time, false, drp);
+            }
+        } else if (IsSinkResult(result)) {
+            if (drp->preference == FUSB302_DRP_PREFER_SRC) {
+                SetState(platform, FUSB302_DRP_STATE_ATTACH_WAIT_SNK, time, drp);
+                ok &= Hold(platform, data, result, time, drp);
+            } else {
+                ok &= AttachSink(platform, data, time, drp);
+            }
+        } else if (result == FUSB302_TOGGLE_RESULT_AUDIO) {
+            // Audio accessories are not supported, keep toggling
+            ok &= Toggle(platform, data, FUSB302_TOGGLE_MODE_DRP, FUSB302_DRP_STATE_UNATTACHED,
+                         time, drp);
+        }
+        break;
+    case FUSB302_DRP_STATE_ATTACH_WAIT_SRC:
+    case FUSB302_DRP_STATE_ATTACH_WAIT_SNK: {
+        bool source = drp->state == FUSB302_DRP_STATE_ATTACH_WAIT_SRC;
+        if (!IsPartnerPresent(data, source)) {
+            ok &= Toggle(platform, data, FUSB302_TOGGLE_MODE_DRP, FUSB302_DRP_STATE_UNATTACHED,
+                         time, drp);
+        } else if (platform->getTimeDiffMs(time, drp->time) >= FUSB302_T_CC_DEBOUNCE_MS) {
+            // Offer only the preferred role, the toggle waits for the partner to follow
+            drp->tries++;
+            ok &= Toggle(platform, data, source ? FUSB302_TOGGLE_MODE_SNK : FUSB302_TOGGLE_MODE_SRC,
+                         source ? FUSB302_DRP_STATE_TRY_SNK : FUSB302_DRP_STATE_TRY_SRC, time,
+                         drp);
+        }
+        break;
+    }
+    case FUSB302_DRP_STATE_TRY_SRC:
+    case FUSB302_DRP_STATE_TRY_SNK:
+    case FUSB302_DRP_STATE_TRY_WAIT_SRC:
+    case FUSB302_DRP_STATE_TRY_WAIT_SNK:
+        ok &= UpdateTry(platform, data, time, result, drp);
+        break;
+    default:
+        return false;
+    }
+
+    return ok;
+}
+
+FUSB302_TimeDiffMs FUSB302_GetDRPTimeoutMs(FUSB302_Platform_t *platform, FUSB302_DRP_t *drp,
+                                           FUSB302_CycleTime time) {
+    switch (drp->state) {
+    case FUSB302_DRP_STATE_ATTACH_WAIT_SRC:
+    case FUSB302_DRP_STATE_ATTACH_WAIT_SNK:
+        return Remaining(platform, time, drp->time, FUSB302_T_CC_DEBOUNCE_MS);
+    case FUSB302_DRP_STATE_TRY_SRC:
+    case FUSB302_DRP_STATE_TRY_SNK:
+    case FUSB302_DRP_STATE_TRY_WAIT_SRC:
+    case FUSB302_DRP_STATE_TRY_WAIT_SNK:
+        if (drp->ccFound) {
+            return Remaining(platform, time, drp->ccTime, FUSB302_T_TRY_CC_DEBOUNCE_MS);
+        }
+        return Remaining(platform, time, drp->time, TryTimeoutMs(drp->state));
+    case FUSB302_DRP_STATE_ATTACHED_SRC: {
+        FUSB302_HostMonitoring_t *host = drp->host;
+        if (host->state == FUSB302_HOST_STATE_INIT || host->debounce.settled) {
+            return 0;
+        }
+        if (FUSB302_IsHostDebouncing(host)) {
+            return Remaining(platform, time, host->debounce.time,
+                             host->debounce.comp ? FUSB302_T_PD_DEBOUNCE_MS
+                                                 : FUSB302_T_CC_DEBOUNCE_MS);
+        }
+        return -1;
+    }
+    case FUSB302_DRP_STATE_ATTACHED_SNK:
+        if (drp->sink->state == FUSB302_SINK_STATE_INIT) {
+            return 0;
+        }
+        if (FUSB302_IsSinkDebouncing(drp->sink)) {
+            return Remaining(platform, time, drp->sink->rpTime, FUSB302_T_RP_VALUE_CHANGE_MS);
+        }
+        return -1;
+    case FUSB302_DRP_STATE_UNATTACHED:
+    default:
+        return -1;
+    }
+}
+
+bool FUSB302_IsDRPSource(FUSB302_DRP_t *drp) {
+    return drp->state == FUSB302_DRP_STATE_ATTACHED_SRC && FUSB302_IsDeviceAttached(drp->host);
+}
+
+bool FUSB302_IsDRPSink(FUSB302_DRP_t *drp) {
+    return drp->state == FUSB302_DRP_STATE_ATTACHED_SNK && FUSB302_IsSinkAttached(drp->sink);
+}
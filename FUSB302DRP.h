@@ -0,0 +1,91 @@
+#ifndef FUSB302_DRP_H
+#define FUSB302_DRP_H
+
+#include "FUSB302.h"
+#include "FUSB302Host.h"
+#include "FUSB302Sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dual-role port: the hardware toggle finds the partner, then the port is handed off to host
+// (source) or sink monitoring without reset. Try.SRC / Try.SNK restart the toggle in the preferred
+// role only, so the chip keeps looking for the partner while the driver just waits for I_TOGDONE
+// or the next timeout (FUSB302_GetDRPTimeoutMs), no polling.
+
+// Try.SRC / Try.SNK: time in the preferred role (tDRPTry 75..150 ms)
+#ifndef FUSB302_T_DRP_TRY_MS
+#define FUSB302_T_DRP_TRY_MS 75
+#endif
+// Partner must stay in the preferred role for tTryCCDebounce (10..20 ms)
+#ifndef FUSB302_T_TRY_CC_DEBOUNCE_MS
+#define FUSB302_T_TRY_CC_DEBOUNCE_MS 10
+#endif
+// TryWait.SNK: source partner back after a failed Try.SRC (tDRPTryWait 400..800 ms)
+#ifndef FUSB302_T_DRP_TRY_WAIT_MS
+#define FUSB302_T_DRP_TRY_WAIT_MS 400
+#endif
+
+typedef enum FUSB302_DRPPreference {
+    FUSB302_DRP_PREFER_NONE, // first role found by the toggle
+    FUSB302_DRP_PREFER_SRC,  // Try.SRC
+    FUSB302_DRP_PREFER_SNK,  // Try.SNK
+} FUSB302_DRPPreference_t;
+
+typedef enum FUSB302_DRPState {
+    FUSB302_DRP_STATE_UNATTACHED,      // DRP toggle, waiting for I_TOGDONE
+    FUSB302_DRP_STATE_ATTACH_WAIT_SRC, // Rd found, tCCDebounce before Try.SNK
+    FUSB302_DRP_STATE_ATTACH_WAIT_SNK, // Rp found, tCCDebounce before Try.SRC
+    FUSB302_DRP_STATE_TRY_SRC,         // SRC toggle, Rd within tDRPTry
+    FUSB302_DRP_STATE_TRY_SNK,         // SNK toggle, Rp within tDRPTry
+    FUSB302_DRP_STATE_TRY_WAIT_SRC,    // Try.SNK failed: SRC toggle, Rd within tDRPTry
+    FUSB302_DRP_STATE_TRY_WAIT_SNK,    // Try.SRC failed: SNK toggle, Rp within tDRPTryWait
+    FUSB302_DRP_STATE_ATTACHED_SRC,    // host monitoring
+    FUSB302_DRP_STATE_ATTACHED_SNK,    // sink monitoring
+} FUSB302_DRPState_t;
+
+typedef struct FUSB302_DRP {
+    FUSB302_DRPState_t state;
+    FUSB302_DRPPreference_t preference;
+    FUSB302_HostCurrentMode_t hostCurrentMode; // Rp while toggling and as source
+    FUSB302_CycleTime time;                    // state entry
+
+    // Partner found by the toggle in a timed state, stable since ccTime
+    bool ccFound;
+    FUSB302_CC_Orientation_t ccOrientation;
+    FUSB302_CycleTime ccTime;
+
+    // Monitoring after hand-off
+    FUSB302_HostMonitoring_t *host;
+    FUSB302_SinkMonitoring_t *sink;
+
+    // Statistics
+    uint32_t tries;         // Try.SRC / Try.SNK entered
+    uint32_t tryFallbacks;  // preferred role not accepted by the partner
+} FUSB302_DRP_t;
+
+// Fails without platform->bufferPool (host monitoring of the source role)
+bool FUSB302_SetupDRP(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                      FUSB302_DRPPreference_t preference,
+                      FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                      FUSB302_HostMonitoring_t *host, FUSB302_SinkMonitoring_t *sink,
+                      FUSB302_DRP_t *drp);
+
+// Call on FUSB302 interrupt and when FUSB302_GetDRPTimeoutMs has passed. Attached ports are
+// updated through here (host or sink monitoring), toggling restarts on detach.
+bool FUSB302_UpdateDRP(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_CycleTime time,
+                       FUSB302_DRP_t *drp);
+
+// Time until the next timed step (0: due), -1: only an interrupt advances the port
+FUSB302_TimeDiffMs FUSB302_GetDRPTimeoutMs(FUSB302_Platform_t *platform, FUSB302_DRP_t *drp,
+                                           FUSB302_CycleTime time);
+
+bool FUSB302_IsDRPSource(FUSB302_DRP_t *drp);
+bool FUSB302_IsDRPSink(FUSB302_DRP_t *drp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_DRP_H
@@ -0,0 +1,374 @@
+#include "FUSB302Discovery.h"
+#include "FUSB302Trace.h"
+
+// ID Header VDO: product type (UFP / cable plug) and modal operation support
+#define ID_HEADER_PRODUCT_TYPE(idh) (((idh) >> 27) & 0x7)
+#define ID_HEADER_MODAL_OPERATION(idh) (((idh) >> 26) & 0x1)
+
+// Discover SVIDs response carries up to 12 SVIDs, a full response means more may follow
+#define SVIDS_PER_RESPONSE 12
+
+static uint8_t RequestCommand(FUSB302_DiscoveryState_t state) {
+    switch (state) {
+    case FUSB302_DISCOVERY_STATE_IDENTITY:
+        return FUSB302_VDM_CMD_DISCOVER_IDENTITY;
+    case FUSB302_DISCOVERY_STATE_SVIDS:
+        return FUSB302_VDM_CMD_DISCOVER_SVIDS;
+    case FUSB302_DISCOVERY_STATE_MODES:
+        return FUSB302_VDM_CMD_DISCOVER_MODES;
+    case FUSB302_DISCOVERY_STATE_ENTER:
+        return FUSB302_VDM_CMD_ENTER_MODE;
+    default:
+        return 0;
+    }
+}
+
+static void ResetTarget(FUSB302_DiscoveryTarget_t *target) {
+    target->state = FUSB302_DISCOVERY_STATE_IDLE;
+    target->numIdentity = 0;
+    target->numSvids = 0;
+    for (int i = 0; i < FUSB302_DISCOVERY_MAX_SVIDS; i++) {
+        target->numModes[i] = 0;
+    }
+    target->svidIndex = 0;
+    target->modeEntered = 0;
+}
+
+static bool SendRequest(FUSB302_Platform_t *platform, FUSB302_CycleTime time,
+                        FUSB302_TxScheduler_t *scheduler, FUSB302_Discovery_t *discovery,
+                        FUSB302_DiscoveryState_t state) {
+    FUSB302_DiscoveryTarget_t *target = &discovery->targets[discovery->sop];
+    uint16_t svid = FUSB302_VDM_SVID_PD_SID;
+    uint8_t objectPosition = 0;
+
+    if (state == FUSB302_DISCOVERY_STATE_MODES) {
+        svid = target->svids[target->svidIndex];
+    } else if (state == FUSB302_DISCOVERY_STATE_ENTER) {
+        svid = discovery->enterSvid;
+        objectPosition = 1;
+    }
+
+    // Structured VDM header, version 1.0 (PD 2.0)
+    uint32_t vdm = ((uint32_t)svid << 16) | (1u << 15) | ((uint32_t)objectPosition << 8) |
+                   (FUSB302_VDM_CMDT_REQ << 6) | RequestCommand(state);
+
+    target->state = state;
+    discovery->waiting = true;
+    discovery->time = time;
+    discovery->waitMs = state == FUSB302_DISCOVERY_STATE_ENTER ? FUSB302_T_VDM_ENTER_MODE_MS
+                                                               : FUSB302_T_VDM_SENDER_RESPONSE_MS;
+
+#ifdef FUSB302_DEBUG_1
+    platform->debugPrint("FUSB302: VDM %08lX to SOP%d\r\n", (unsigned long)vdm, discovery->sop);
+#else
+    (void)platform;
+#endif
+
+    // Each request and its response are one AMS
+    FUSB302_BeginAMS(scheduler, FUSB302_TX_SENDER_DISCOVERY);
+    return FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_DISCOVERY, discovery->sop,
+                                FUSB302_PD_DATA_VENDOR_DEFINED, &vdm, 1, FUSB302_TX_PRIORITY_LOW);
+}
+
+static int FindSvid(const FUSB302_DiscoveryTarget_t *target, uint16_t svid) {
+    for (int i = 0; i < target->numSvids; i++) {
+        if (target->svids[i] == svid) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static FUSB302_DiscoveryState_t NextModesState(FUSB302_Discovery_t *discovery,
+                                               FUSB302_DiscoveryTarget_t *target, int from) {
+    if (discovery->enterSvid) {
+        // Only modes of the SVID to enter
+        int index = FindSvid(target, discovery->enterSvid);
+        if (from == 0 && index >= 0) {
+            target->svidIndex = index;
+            return FUSB302_DISCOVERY_STATE_MODES;
+        }
+    } else if (from < target->numSvids) {
+        target->svidIndex = from;
+        return FUSB302_DISCOVERY_STATE_MODES;
+    }
+
+    // Enter mode on the port partner once its modes are known
+    if (discovery->sop == FUSB302_SOP && discovery->enterSvid) {
+        int index = FindSvid(target, discovery->enterSvid);
+        if (index >= 0 && target->numModes[index] > 0 && !target->modeEntered) {
+            return FUSB302_DISCOVERY_STATE_ENTER;
+        }
+    }
+
+    return FUSB302_DISCOVERY_STATE_DONE;
+}
+
+// Next state after an ACK, updates the cache
+static FUSB302_DiscoveryState_t HandleAck(FUSB302_Discovery_t *discovery,
+                                          FUSB302_DiscoveryTarget_t *target,
+                                          const FUSB302_PDMessage_t *message) {
+    int numVdos = FUSB302_PD_HEADER_NUM_OBJECTS(message->header) - 1;
+    const uint32_t *vdos = &message->objects[1];
+
+    switch (target->state) {
+    case FUSB302_DISCOVERY_STATE_IDENTITY:
+        target->numIdentity = 0;
+        for (int i = 0; i < numVdos && i < FUSB302_DISCOVERY_MAX_IDENTITY_VDOS; i++) {
+            target->identity[target->numIdentity++] = vdos[i];
+        }
+
+        // No SVIDs without modal operation
+        if (!numVdos || !ID_HEADER_MODAL_OPERATION(vdos[0])) {
+            return FUSB302_DISCOVERY_STATE_DONE;
+        }
+        return FUSB302_DISCOVERY_STATE_SVIDS;
+    case FUSB302_DISCOVERY_STATE_SVIDS: {
+        // Two SVIDs per VDO, high half first, 0x0000 terminates the list
+        int count = 0;
+        bool end = false;
+        for (int i = 0; i < numVdos * 2 && !end; i++) {
+            uint16_t svid = (i & 1) ? (vdos[i / 2] & 0xFFFF) : (vdos[i / 2] >> 16);
+            if (!svid) {
+                end = true;
+            } else if (target->numSvids < FUSB302_DISCOVERY_MAX_SVIDS) {
+                target->svids[target->numSvids++] = svid;
+                count++;
+            }
+        }
+
+        if (!end && count == SVIDS_PER_RESPONSE &&
+            target->numSvids < FUSB302_DISCOVERY_MAX_SVIDS) {
+            return FUSB302_DISCOVERY_STATE_SVIDS;
+        }
+        return NextModesState(discovery, target, 0);
+    }
+    case FUSB302_DISCOVERY_STATE_MODES: {
+        int index = target->svidIndex;
+        target->numModes[index] = 0;
+        for (int i = 0; i < numVdos && i < FUSB302_DISCOVERY_MAX_MODES; i++) {
+            target->modes[index][target->numModes[index]++] = vdos[i];
+        }
+        return NextModesState(discovery, target, discovery->enterSvid ? 1 : index + 1);
+    }
+    case FUSB302_DISCOVERY_STATE_ENTER:
+        target->modeEntered = FUSB302_VDM_HEADER_OBJECT_POSITION(message->objects[0]);
+        return FUSB302_DISCOVERY_STATE_DONE;
+    default:
+        return FUSB302_DISCOVERY_STATE_DONE;
+    }
+}
+
+static bool SelectTarget(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                         FUSB302_HostMonitoring_t *monitoring, FUSB302_Discovery_t *discovery,
+                         bool sopAllowed, FUSB302_SOP_t *sop) {
+    FUSB302_DiscoveryTarget_t *cable = &discovery->targets[FUSB302_SOP_PRIME];
+    bool ok = true;
+
+    // Cable first: its capabilities limit the modes the port partner may enter. Replies reach us
+    // only with a device attached (FUSB302Source), host monitoring pings a cable alone.
+    if (FUSB302_IsActiveCableAttached(monitoring) && FUSB302_IsDeviceAttached(monitoring) &&
+        cable->state == FUSB302_DISCOVERY_STATE_IDLE) {
+        *sop = FUSB302_SOP_PRIME;
+        return true;
+    }
+
+    // Far end plug of active cables, SOP'' detection is only needed meanwhile
+    bool activeCable = cable->state == FUSB302_DISCOVERY_STATE_DONE && cable->numIdentity &&
+                       ID_HEADER_PRODUCT_TYPE(cable->identity[0]) ==
+                           FUSB302_PD_PRODUCT_TYPE_ACTIVE_CABLE;
+    bool sop2Pending =
+        activeCable && discovery->targets[FUSB302_SOP_DOUBLE_PRIME].state ==
+                           FUSB302_DISCOVERY_STATE_IDLE;
+    if (FUSB302_GetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_ENSOP2) != sop2Pending) {
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_ENSOP2, sop2Pending);
+        ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL1);
+    }
+    if (sop2Pending) {
+        *sop = FUSB302_SOP_DOUBLE_PRIME;
+        return ok;
+    }
+
+    if (sopAllowed && FUSB302_IsDeviceAttached(monitoring) &&
+        discovery->targets[FUSB302_SOP].state == FUSB302_DISCOVERY_STATE_IDLE) {
+        *sop = FUSB302_SOP;
+        return ok;
+    }
+
+    *sop = FUSB302_SOP_OTHER;
+    return ok;
+}
+
+void FUSB302_SetupDiscovery(FUSB302_Discovery_t *discovery, uint16_t enterSvid) {
+    for (int sop = 0; sop < FUSB302_PROTOCOL_NUM_SOP; sop++) {
+        ResetTarget(&discovery->targets[sop]);
+    }
+    discovery->enterSvid = enterSvid;
+    discovery->attached = false;
+    discovery->sop = FUSB302_SOP;
+    discovery->waiting = false;
+    discovery->time = 0;
+    discovery->waitMs = 0;
+    discovery->retries = 0;
+    discovery->busyRetries = 0;
+}
+
+bool FUSB302_UpdateDiscovery(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                             FUSB302_TxScheduler_t *scheduler, FUSB302_Discovery_t *discovery,
+                             const FUSB302_PDMessage_t *message, bool sopAllowed) {
+    bool ok = true;
+
+    // Mark the call for replay, with the inputs from the application
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_DISCOVERY_UPDATE, time);
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_ARG,
+                          (uint32_t)discovery->enterSvid << 16 | (message ? 2 : 0) | sopAllowed);
+        if (message) {
+            FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_ARG,
+                              (uint32_t)message->sop << 16 | message->header);
+            for (int i = 0; i < FUSB302_PD_HEADER_NUM_OBJECTS(message->header); i++) {
+                FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_ARG, message->objects[i]);
+            }
+        }
+    }
+
+    monitoring->cableDiscovery = true;
+
+    // Cache is valid for one attach
+    bool attached =
+        FUSB302_IsDeviceAttached(monitoring) || FUSB302_IsActiveCableAttached(monitoring);
+    if (!attached) {
+        if (discovery->attached) {
+            FUSB302_SetupDiscovery(discovery, discovery->enterSvid);
+        }
+        return true;
+    }
+    discovery->attached = true;
+
+    // Hard reset exits all modes and drops the request in flight, discover and enter again
+    if (FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_HARDRST)) {
+        FUSB302_SetupDiscovery(discovery, discovery->enterSvid);
+        discovery->attached = true;
+        return true;
+    }
+
+    FUSB302_DiscoveryTarget_t *target = &discovery->targets[discovery->sop];
+    FUSB302_DiscoveryState_t next = target->state;
+
+    if (discovery->waiting && message && message->sop == discovery->sop &&
+        FUSB302_PD_HEADER_TYPE(message->header) == FUSB302_PD_DATA_VENDOR_DEFINED &&
+        FUSB302_PD_HEADER_NUM_OBJECTS(message->header) > 0 &&
+        !FUSB302_PD_HEADER_EXTENDED(message->header)) {
+        uint32_t vdm = message->objects[0];
+        uint8_t cmdType = FUSB302_VDM_HEADER_CMD_TYPE(vdm);
+
+        // A request of the port partner is no response, ours stays in flight
+        if (FUSB302_VDM_HEADER_STRUCTURED(vdm) && cmdType != FUSB302_VDM_CMDT_REQ &&
+            FUSB302_VDM_HEADER_CMD(vdm) == RequestCommand(target->state)) {
+            discovery->waiting = false;
+            discovery->retries = 0;
+            discovery->waitMs = 0;
+
+            switch (cmdType) {
+            case FUSB302_VDM_CMDT_ACK: {
+                // Cable type sets the VCONN over-current limit of host monitoring
+                FUSB302_PDIdentity_t identity;
+                if (discovery->sop == FUSB302_SOP_PRIME &&
+                    FUSB302_ParseDiscoverIdentityReply(message, &identity)) {
+                    ok &= FUSB302_SetHostCableIdentity(platform, data, monitoring, &identity);
+                }
+
+                discovery->busyRetries = 0;
+                next = HandleAck(discovery, target, message);
+                break;
+            }
+            case FUSB302_VDM_CMDT_BUSY:
+                // Repeat same request after tVDMBusy
+                if (discovery->busyRetries++ < FUSB302_DISCOVERY_BUSY_RETRIES) {
+                    discovery->time = time;
+                    discovery->waitMs = FUSB302_T_VDM_BUSY_MS;
+                } else {
+                    discovery->busyRetries = 0;
+                    next = FUSB302_DISCOVERY_STATE_DONE;
+                }
+                break;
+            case FUSB302_VDM_CMDT_NAK:
+            default:
+                // Not supported, keep what is known
+                next = FUSB302_DISCOVERY_STATE_DONE;
+                break;
+            }
+        }
+    } else if (discovery->waiting && FUSB302_GetTxResult(scheduler, FUSB302_TX_SENDER_DISCOVERY) ==
+                                         FUSB302_TX_RESULT_PENDING) {
+        // Response timer starts with GoodCRC
+        discovery->time = time;
+    } else if (discovery->waiting &&
+               (FUSB302_GetTxResult(scheduler, FUSB302_TX_SENDER_DISCOVERY) ==
+                    FUSB302_TX_RESULT_FAILED ||
+                platform->getTimeDiffMs(time, discovery->time) >= discovery->waitMs)) {
+        // No GoodCRC or no response
+        discovery->waiting = false;
+        if (discovery->retries++ < FUSB302_DISCOVERY_RETRIES) {
+            discovery->time = time;
+            discovery->waitMs = 0;
+        } else {
+            discovery->retries = 0;
+            next = FUSB302_DISCOVERY_STATE_FAILED;
+        }
+    }
+
+    if (discovery->waiting) {
+        return ok;
+    }
+    FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_DISCOVERY);
+
+    if (next != target->state &&
+        (next == FUSB302_DISCOVERY_STATE_DONE || next == FUSB302_DISCOVERY_STATE_FAILED)) {
+        target->state = next;
+
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: Discovery SOP%d %s (SVIDs %d, mode %d)\r\n",
+                             discovery->sop,
+                             next == FUSB302_DISCOVERY_STATE_DONE ? "done" : "failed",
+                             target->numSvids, target->modeEntered);
+#endif
+    } else if (next != FUSB302_DISCOVERY_STATE_IDLE && next != FUSB302_DISCOVERY_STATE_DONE &&
+               next != FUSB302_DISCOVERY_STATE_FAILED) {
+        // Next request at once after a response, repeated request after timeout or busy backoff
+        if (platform->getTimeDiffMs(time, discovery->time) < discovery->waitMs) {
+            return ok;
+        }
+        return SendRequest(platform, time, scheduler, discovery, next) && ok;
+    }
+
+    // Start next target
+    FUSB302_SOP_t sop;
+    ok &= SelectTarget(platform, data, monitoring, discovery, sopAllowed, &sop);
+    if (sop == FUSB302_SOP_OTHER) {
+        return ok;
+    }
+
+    discovery->sop = sop;
+    discovery->retries = 0;
+    discovery->busyRetries = 0;
+    return SendRequest(platform, time, scheduler, discovery, FUSB302_DISCOVERY_STATE_IDENTITY) &&
+           ok;
+}
+
+bool FUSB302_IsDiscoveryBusy(FUSB302_Discovery_t *discovery) {
+    FUSB302_DiscoveryState_t state = discovery->targets[discovery->sop].state;
+    return state != FUSB302_DISCOVERY_STATE_IDLE && state != FUSB302_DISCOVERY_STATE_DONE &&
+           state != FUSB302_DISCOVERY_STATE_FAILED;
+}
+
+const FUSB302_DiscoveryTarget_t *FUSB302_GetDiscoveryResult(FUSB302_Discovery_t *discovery,
+                                                            FUSB302_SOP_t sop) {
+    if (sop >= FUSB302_PROTOCOL_NUM_SOP) {
+        return 0;
+    }
+
+    return &discovery->targets[sop];
+}
@@ -0,0 +1,119 @@
+#ifndef FUSB302_DISCOVERY_H
+#define FUSB302_DISCOVERY_H
+
+#include "FUSB302.h"
+#include "FUSB302Host.h"
+#include "FUSB302PD.h"
+#include "FUSB302Tx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Structured VDM commands
+#define FUSB302_VDM_CMD_DISCOVER_IDENTITY 1
+#define FUSB302_VDM_CMD_DISCOVER_SVIDS 2
+#define FUSB302_VDM_CMD_DISCOVER_MODES 3
+#define FUSB302_VDM_CMD_ENTER_MODE 4
+
+// Structured VDM command types
+#define FUSB302_VDM_CMDT_REQ 0
+#define FUSB302_VDM_CMDT_ACK 1
+#define FUSB302_VDM_CMDT_NAK 2
+#define FUSB302_VDM_CMDT_BUSY 3
+
+#define FUSB302_VDM_SVID_PD_SID 0xFF00
+#define FUSB302_VDM_SVID_DISPLAYPORT 0xFF01
+
+#define FUSB302_VDM_HEADER_SVID(vdm) (((vdm) >> 16) & 0xFFFF)
+#define FUSB302_VDM_HEADER_STRUCTURED(vdm) (((vdm) >> 15) & 0x1)
+#define FUSB302_VDM_HEADER_OBJECT_POSITION(vdm) (((vdm) >> 8) & 0x7)
+#define FUSB302_VDM_HEADER_CMD_TYPE(vdm) (((vdm) >> 6) & 0x3)
+#define FUSB302_VDM_HEADER_CMD(vdm) ((vdm) & 0x1F)
+
+// VDM response timers and retries
+#ifndef FUSB302_T_VDM_SENDER_RESPONSE_MS
+#define FUSB302_T_VDM_SENDER_RESPONSE_MS 27 // tVDMSenderResponse 24..30 ms
+#endif
+#ifndef FUSB302_T_VDM_BUSY_MS
+#define FUSB302_T_VDM_BUSY_MS 50 // tVDMBusy
+#endif
+#ifndef FUSB302_T_VDM_ENTER_MODE_MS
+#define FUSB302_T_VDM_ENTER_MODE_MS 45 // tVDMWaitModeEntry 40..50 ms
+#endif
+#ifndef FUSB302_DISCOVERY_RETRIES
+#define FUSB302_DISCOVERY_RETRIES 2
+#endif
+#ifndef FUSB302_DISCOVERY_BUSY_RETRIES
+#define FUSB302_DISCOVERY_BUSY_RETRIES 5 // BUSY responses per request, then done like NAK
+#endif
+
+// Cache size per target
+#ifndef FUSB302_DISCOVERY_MAX_SVIDS
+#define FUSB302_DISCOVERY_MAX_SVIDS 8
+#endif
+#ifndef FUSB302_DISCOVERY_MAX_MODES
+#define FUSB302_DISCOVERY_MAX_MODES 4
+#endif
+#define FUSB302_DISCOVERY_MAX_IDENTITY_VDOS 6
+
+typedef enum FUSB302_DiscoveryState {
+    FUSB302_DISCOVERY_STATE_IDLE,     // not started for this attach
+    FUSB302_DISCOVERY_STATE_IDENTITY, // Discover Identity sent
+    FUSB302_DISCOVERY_STATE_SVIDS,    // Discover SVIDs sent
+    FUSB302_DISCOVERY_STATE_MODES,    // Discover Modes sent (for svidIndex)
+    FUSB302_DISCOVERY_STATE_ENTER,    // Enter Mode sent
+    FUSB302_DISCOVERY_STATE_DONE,     // results complete (possibly partial after NAK)
+    FUSB302_DISCOVERY_STATE_FAILED,   // no response
+} FUSB302_DiscoveryState_t;
+
+// Cached results of one SOP* target, valid until detach
+typedef struct FUSB302_DiscoveryTarget {
+    FUSB302_DiscoveryState_t state;
+    uint32_t identity[FUSB302_DISCOVERY_MAX_IDENTITY_VDOS]; // ID Header, Cert Stat, Product, ...
+    uint8_t numIdentity;
+    uint16_t svids[FUSB302_DISCOVERY_MAX_SVIDS];
+    uint8_t numSvids;
+    uint32_t modes[FUSB302_DISCOVERY_MAX_SVIDS][FUSB302_DISCOVERY_MAX_MODES];
+    uint8_t numModes[FUSB302_DISCOVERY_MAX_SVIDS];
+    uint8_t svidIndex;     // SVID of the running Discover Modes
+    uint8_t modeEntered;   // object position of entered mode, 0: none
+} FUSB302_DiscoveryTarget_t;
+
+typedef struct FUSB302_Discovery {
+    FUSB302_DiscoveryTarget_t targets[FUSB302_PROTOCOL_NUM_SOP]; // SOP, SOP', SOP''
+    uint16_t enterSvid; // mode to enter on SOP (first mode of this SVID), 0: discovery only
+
+    bool attached;
+    FUSB302_SOP_t sop;         // target of the request in flight
+    bool waiting;              // request in flight
+    FUSB302_CycleTime time;    // request sent or busy backoff start
+    FUSB302_TimeDiffMs waitMs; // response timeout or busy backoff
+    uint8_t retries;           // requests without response
+    uint8_t busyRetries;       // BUSY responses to the request
+} FUSB302_Discovery_t;
+
+void FUSB302_SetupDiscovery(FUSB302_Discovery_t *discovery, uint16_t enterSvid);
+
+// Call right after FUSB302_UpdateTxScheduler (and FUSB302_UpdateSource, if used). message is the
+// message received in this cycle and not handled elsewhere (0: none). Cable plugs (SOP', SOP'')
+// are discovered as soon as a device is attached through an active cable, the port partner (SOP)
+// once sopAllowed is set (explicit contract). The next request is queued in the same call that
+// receives a response, the response timer starts when the scheduler reports GoodCRC. Takes the
+// cable Discover Identity over from host monitoring (monitoring->cableDiscovery), set it before
+// the first update after a debounced FUSB302_StartHostMonitoring. Requests of the port partner
+// are not answered. A hard reset restarts discovery of all targets.
+bool FUSB302_UpdateDiscovery(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                             FUSB302_TxScheduler_t *scheduler, FUSB302_Discovery_t *discovery,
+                             const FUSB302_PDMessage_t *message, bool sopAllowed);
+
+bool FUSB302_IsDiscoveryBusy(FUSB302_Discovery_t *discovery);
+const FUSB302_DiscoveryTarget_t *FUSB302_GetDiscoveryResult(FUSB302_Discovery_t *discovery,
+                                                            FUSB302_SOP_t sop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_DISCOVERY_H
@@ -0,0 +1,159 @@
+#ifdef __linux__
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "FUSB302Export.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Fields compared to detect a change (time and changes follow from publishing)
+#define COMPARED_WORDS (offsetof(FUSB302_PortStatus_t, time) / sizeof(uint32_t))
+#define CHANGES_WORD (offsetof(FUSB302_PortStatus_t, changes) / sizeof(uint32_t))
+
+void FUSB302_SetupExport(FUSB302_ExportRegion_t *region, int numPorts) {
+    memset((void *)region, 0, FUSB302_EXPORT_REGION_SIZE(numPorts));
+    region->version = FUSB302_EXPORT_VERSION;
+    region->numPorts = (uint16_t)numPorts;
+    region->slotSize = sizeof(FUSB302_PortStatusSlot_t);
+
+    // Header complete before readers accept the region
+    atomic_store_explicit(&region->magic, FUSB302_EXPORT_MAGIC, memory_order_release);
+}
+
+FUSB302_PortStatusSlot_t *FUSB302_GetExportSlot(FUSB302_ExportRegion_t *region, int port) {
+    return port >= 0 && port < region->numPorts ? &region->ports[port] : 0;
+}
+
+void FUSB302_ExportHostStatus(FUSB302_PortStatusSlot_t *slot,
+                              const FUSB302_HostMonitoring_t *monitoring, FUSB302_CycleTime time) {
+    uint32_t words[FUSB302_PORT_STATUS_WORDS];
+    FUSB302_PortStatus_t status;
+    status.state = monitoring->state;
+    status.hostCurrentMode = monitoring->hostCurrentMode;
+    status.ccOrientation = monitoring->ccOrientation;
+    status.emarkerPresent = monitoring->emarkerPresent;
+    status.emarkerVid = monitoring->emarkerPresent ? monitoring->cableIdentity.vid : 0;
+    status.emarkerProductType =
+        monitoring->emarkerPresent ? monitoring->cableIdentity.productType : 0;
+    status.ocpFaults = monitoring->counters.ocpFaults;
+    status.overTempFaults = monitoring->counters.overTempFaults;
+    status.softResets = monitoring->counters.softResets;
+    status.hardResets = monitoring->counters.hardResets;
+    status.lastFaultTime = monitoring->counters.lastFaultTime;
+    status.time = time;
+    status.changes = atomic_load_explicit(&slot->words[CHANGES_WORD], memory_order_relaxed) + 1;
+    memcpy(words, &status, sizeof(words));
+
+    // Only writer of the slot, own values need no seqlock. Unchanged ports cost one compare.
+    bool changed = atomic_load_explicit(&slot->sequence, memory_order_relaxed) == 0;
+    for (unsigned i = 0; i < COMPARED_WORDS && !changed; i++) {
+        changed = atomic_load_explicit(&slot->words[i], memory_order_relaxed) != words[i];
+    }
+    if (!changed) {
+        return;
+    }
+
+    // Sequence odd while writing, readers retry
+    uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (unsigned i = 0; i < FUSB302_PORT_STATUS_WORDS; i++) {
+        atomic_store_explicit(&slot->words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+}
+
+bool FUSB302_IsExportValid(const FUSB302_ExportRegion_t *region) {
+    return atomic_load_explicit(&region->magic, memory_order_acquire) == FUSB302_EXPORT_MAGIC &&
+           region->version == FUSB302_EXPORT_VERSION &&
+           region->slotSize == sizeof(FUSB302_PortStatusSlot_t);
+}
+
+bool FUSB302_ReadPortStatus(const FUSB302_ExportRegion_t *region, int port,
+                            FUSB302_PortStatus_t *status) {
+    if (port < 0 || port >= region->numPorts) {
+        return false;
+    }
+    const FUSB302_PortStatusSlot_t *slot = &region->ports[port];
+
+    uint32_t words[FUSB302_PORT_STATUS_WORDS];
+    for (int retry = 0; retry < FUSB302_EXPORT_READ_RETRIES; retry++) {
+        uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+        for (unsigned i = 0; i < FUSB302_PORT_STATUS_WORDS; i++) {
+            words[i] = atomic_load_explicit(&slot->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence) {
+            memcpy(status, words, sizeof(*status));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#ifdef __linux__
+FUSB302_ExportRegion_t *FUSB302_CreateExportFile(const char *path, int numPorts) {
+    size_t size = FUSB302_EXPORT_REGION_SIZE(numPorts);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+
+    FUSB302_ExportRegion_t *region = (FUSB302_ExportRegion_t *)map;
+    FUSB302_SetupExport(region, numPorts);
+    return region;
+}
+
+const FUSB302_ExportRegion_t *FUSB302_OpenExportFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(FUSB302_ExportRegion_t)) {
+        close(fd);
+        return 0;
+    }
+
+    void *map = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+
+    // Header and file size must agree before any slot is read
+    const FUSB302_ExportRegion_t *region = (const FUSB302_ExportRegion_t *)map;
+    if (!FUSB302_IsExportValid(region) ||
+        (size_t)st.st_size < FUSB302_EXPORT_REGION_SIZE(region->numPorts)) {
+        munmap(map, (size_t)st.st_size);
+        return 0;
+    }
+    return region;
+}
+
+void FUSB302_CloseExportFile(const FUSB302_ExportRegion_t *region) {
+    munmap((void *)region, FUSB302_EXPORT_REGION_SIZE(region->numPorts));
+}
+#endif
@@ -0,0 +1,97 @@
+#ifndef FUSB302_EXPORT_H
+#define FUSB302_EXPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FUSB302Host.h"
+
+// Words read concurrently, atomic in C and C++
+#ifdef __cplusplus
+#include <atomic>
+typedef std::atomic<uint32_t> FUSB302_ExportWord_t;
+#else
+#include <stdatomic.h>
+typedef _Atomic uint32_t FUSB302_ExportWord_t;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-port status in shared memory for local monitoring tools. The driver loop is the only writer,
+// it publishes a port only when its state or counters change. Readers poll the mapping with a
+// seqlock (no syscalls, no locks shared with the writer).
+
+#define FUSB302_EXPORT_MAGIC 0x46555342 // "FUSB"
+#define FUSB302_EXPORT_VERSION 1
+
+// Reader attempts while the writer is inside an update
+#ifndef FUSB302_EXPORT_READ_RETRIES
+#define FUSB302_EXPORT_READ_RETRIES 1000
+#endif
+
+// Published values, fixed-width for readers built separately
+typedef struct FUSB302_PortStatus {
+    uint32_t state; // FUSB302_HostState_t
+    uint32_t hostCurrentMode;
+    uint32_t ccOrientation;
+    uint32_t emarkerPresent;
+    uint32_t emarkerVid;
+    uint32_t emarkerProductType;
+    uint32_t ocpFaults;
+    uint32_t overTempFaults;
+    uint32_t softResets;
+    uint32_t hardResets;
+    uint32_t lastFaultTime;
+    uint32_t time;    // cycle time of the last change
+    uint32_t changes; // published changes
+} FUSB302_PortStatus_t;
+
+#define FUSB302_PORT_STATUS_WORDS (sizeof(FUSB302_PortStatus_t) / sizeof(uint32_t))
+
+// One cache line per port, ports do not share lines
+struct FUSB302_PortStatusSlot {
+    FUSB302_ExportWord_t sequence; // odd while the writer is updating
+    FUSB302_ExportWord_t words[FUSB302_PORT_STATUS_WORDS];
+    uint32_t reserved[16 - 1 - FUSB302_PORT_STATUS_WORDS];
+};
+
+typedef struct FUSB302_ExportRegion {
+    FUSB302_ExportWord_t magic; // written last, region valid once set
+    uint16_t version;
+    uint16_t numPorts;
+    uint32_t slotSize;
+    uint32_t reserved[13];
+    FUSB302_PortStatusSlot_t ports[];
+} FUSB302_ExportRegion_t;
+
+#define FUSB302_EXPORT_REGION_SIZE(numPorts)                                                       \
+    (sizeof(FUSB302_ExportRegion_t) + (numPorts) * sizeof(FUSB302_PortStatusSlot_t))
+
+// Writer: region of FUSB302_EXPORT_REGION_SIZE(numPorts) bytes
+void FUSB302_SetupExport(FUSB302_ExportRegion_t *region, int numPorts);
+FUSB302_PortStatusSlot_t *FUSB302_GetExportSlot(FUSB302_ExportRegion_t *region, int port);
+
+// Publishes the port if state or counters changed (called by FUSB302_UpdateHostMonitoring when
+// monitoring->statusExport is set)
+void FUSB302_ExportHostStatus(FUSB302_PortStatusSlot_t *slot,
+                              const FUSB302_HostMonitoring_t *monitoring, FUSB302_CycleTime time);
+
+// Reader: consistent copy of one port, false if the region is invalid or the writer kept updating
+bool FUSB302_IsExportValid(const FUSB302_ExportRegion_t *region);
+bool FUSB302_ReadPortStatus(const FUSB302_ExportRegion_t *region, int port,
+                            FUSB302_PortStatus_t *status);
+
+#ifdef __linux__
+// Shared memory file (for example /dev/shm/fusb302): writer creates it, readers map it read-only
+FUSB302_ExportRegion_t *FUSB302_CreateExportFile(const char *path, int numPorts);
+const FUSB302_ExportRegion_t *FUSB302_OpenExportFile(const char *path);
+void FUSB302_CloseExportFile(const FUSB302_ExportRegion_t *region);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_EXPORT_H
@@ -0,0 +1,109 @@
+#include "FUSB302FaultInject.h"
+
+typedef enum Fault {
+    FAULT_NONE,
+    FAULT_NACK,
+    FAULT_TIMEOUT,
+    FAULT_CORRUPT,
+} Fault_t;
+
+static FUSB302_FaultInjector_t *activeInjector;
+
+static uint32_t NextRandom(FUSB302_FaultInjector_t *injector) {
+    // Numerical Recipes LCG, upper bits are the most random ones
+    injector->seed = injector->seed * 1664525u + 1013904223u;
+    return injector->seed >> 16;
+}
+
+static Fault_t PickFault(FUSB302_FaultInjector_t *injector, bool read) {
+    injector->accesses++;
+
+    uint32_t roll = NextRandom(injector) % 1000;
+    if (roll < injector->nackPermille) {
+        injector->nacks++;
+        return FAULT_NACK;
+    }
+    roll -= injector->nackPermille;
+    if (roll < injector->timeoutPermille) {
+        injector->timeouts++;
+        return FAULT_TIMEOUT;
+    }
+    roll -= injector->timeoutPermille;
+    if (read && roll < injector->corruptPermille) {
+        injector->corruptions++;
+        return FAULT_CORRUPT;
+    }
+
+    return FAULT_NONE;
+}
+
+static int WriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
+                    uint8_t wait) {
+    FUSB302_FaultInjector_t *injector = activeInjector;
+
+    switch (PickFault(injector, false)) {
+    case FAULT_NACK:
+        return -1;
+    case FAULT_TIMEOUT:
+        injector->target.delayUs((uint32_t)wait * 1000);
+        return -1;
+    default:
+        return injector->target.i2cWriteReg(addr7bit, regNum, data, length, wait);
+    }
+}
+
+static int ReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length, int timeout) {
+    FUSB302_FaultInjector_t *injector = activeInjector;
+
+    Fault_t fault = PickFault(injector, true);
+    switch (fault) {
+    case FAULT_NACK:
+        return -1;
+    case FAULT_TIMEOUT:
+        injector->target.delayUs((uint32_t)timeout * 1000);
+        return -1;
+    default:
+        break;
+    }
+
+    int ret = injector->target.i2cReadReg(addr7bit, regNum, data, length, timeout);
+    if (ret >= 0 && injector->failReads && regNum == injector->failReg) {
+        injector->failReads--;
+        injector->aborts++;
+        return -1;
+    }
+    if (ret >= 0 && fault == FAULT_CORRUPT && length > 0) {
+        uint32_t bit = NextRandom(injector) % (length * 8u);
+        data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+
+    return ret;
+}
+
+void FUSB302_SetupFaultInjector(FUSB302_FaultInjector_t *injector, FUSB302_Platform_t *platform,
+                                uint32_t seed) {
+    injector->target = *platform;
+    injector->nackPermille = 0;
+    injector->timeoutPermille = 0;
+    injector->corruptPermille = 0;
+    injector->seed = seed;
+    injector->failReg = 0;
+    injector->failReads = 0;
+    injector->accesses = 0;
+    injector->nacks = 0;
+    injector->timeouts = 0;
+    injector->corruptions = 0;
+    injector->aborts = 0;
+
+    platform->i2cWriteReg = WriteReg;
+    platform->i2cReadReg = ReadReg;
+    activeInjector = injector;
+}
+
+void FUSB302_RemoveFaultInjector(FUSB302_FaultInjector_t *injector, FUSB302_Platform_t *platform) {
+    platform->i2cWriteReg = injector->target.i2cWriteReg;
+    platform->i2cReadReg = injector->target.i2cReadReg;
+    if (activeInjector == injector) {
+        activeInjector = 0;
+    }
+}
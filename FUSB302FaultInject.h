@@ -0,0 +1,44 @@
+#ifndef FUSB302_FAULT_INJECT_H
+#define FUSB302_FAULT_INJECT_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// I2C fault injection for testing the I2C policy against a real or simulated bus. Platform
+// callbacks have no context, so a single injector is active at a time.
+typedef struct FUSB302_FaultInjector {
+    FUSB302_Platform_t target; // wrapped platform
+
+    // Fault probabilities per access, in 1/1000
+    uint16_t nackPermille;    // access fails immediately
+    uint16_t timeoutPermille; // access fails after the I2C timeout (ms) has elapsed
+    uint16_t corruptPermille; // read succeeds, one bit of the received data is flipped
+
+    uint32_t seed;
+
+    // Targeted fault: the next failReads reads starting at failReg reach the chip (registers are
+    // cleared on read) but report failure, like a transfer aborted mid-burst
+    uint8_t failReg;
+    uint8_t failReads;
+
+    // Statistics
+    uint32_t accesses;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t corruptions;
+    uint32_t aborts;
+} FUSB302_FaultInjector_t;
+
+// Wrap the I2C callbacks of platform with the injector and make it the active one
+void FUSB302_SetupFaultInjector(FUSB302_FaultInjector_t *injector, FUSB302_Platform_t *platform,
+                                uint32_t seed);
+void FUSB302_RemoveFaultInjector(FUSB302_FaultInjector_t *injector, FUSB302_Platform_t *platform);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_FAULT_INJECT_H
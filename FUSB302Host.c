@@ -1,6 +1,76 @@
+#include <string.h>
+
 #include "FUSB302.h"
+#include "FUSB302Export.h"
 #include "FUSB302Host.h"
 #include "FUSB302PD.h"
+#include "FUSB302Recovery.h"
+#include "FUSB302Trace.h"
+
+// Enable host pullups (note: both pullups seem to be internally connected ~300R), measure CC1,
+// disable host powerdowns
+#define HOST_SWITCHES0 (FUSB302_PU_EN2 | FUSB302_PU_EN1 | FUSB302_MEAS_CC1)
+
+// Setup bits used for constructing the GoodCRC acknowledge packet: Source if SOP, SRC, auto GoodCRC
+#define HOST_SWITCHES1                                                                             \
+    (FUSB302_RESET_SWITCHES1 | FUSB302_POWERROLE | FUSB302_DATAROLE | FUSB302_AUTOCRC)
+
+// Setup comparator to measure CC against MDAC: 6'b10_0101 (1.596 V), 6'b11_1101 (2.604 V) for 3A
+#define HOST_MDAC_DEFAULT 0b100101
+#define HOST_MDAC_3A 0b111101
+#define HOST_MEASURE(mdac)                                                                         \
+    ((FUSB302_RESET_MEASURE & ~(FUSB302_MEAS_VBUS | FUSB302_MDAC_BITS)) |                          \
+     ((mdac) << FUSB302_MDAC_OFFSET))
+
+// Enable interrupts to host, setup host current
+#define HOST_CONTROL0(hostCur)                                                                     \
+    ((FUSB302_RESET_CONTROL0 & ~(FUSB302_INT_MASK | FUSB302_HOST_CUR_BITS)) |                      \
+     ((hostCur) << FUSB302_HOST_CUR_OFFSET))
+
+// Enable SOP' (SOP prime) packet detection for cable communication
+#define HOST_CONTROL1 (FUSB302_RESET_CONTROL1 | FUSB302_ENSOP1)
+
+// Enable AUTO_RETRY and set N_RETRIES
+#define HOST_CONTROL3                                                                              \
+    ((FUSB302_RESET_CONTROL3 & ~FUSB302_N_RETRIES_BITS) | FUSB302_AUTO_RETRY |                     \
+     (FUSB302_N_RETRIES_3 << FUSB302_N_RETRIES_OFFSET))
+
+// Mask all interupts except selected
+#define HOST_MASK                                                                                  \
+    (0xFF & ~(FUSB302_M_COMP_CHNG | FUSB302_M_BC_LVL | FUSB302_M_CRC_CHK | FUSB302_M_COLLISION |  \
+              FUSB302_M_ACTIVITY))
+#define HOST_MASKA                                                                                 \
+    (0xFF & ~(FUSB302_M_OCP_TEMP | FUSB302_M_HARDRST | FUSB302_M_SOFTRST | FUSB302_M_TXSENT |     \
+              FUSB302_M_RETRYFAIL))
+#define HOST_MASKB FUSB302_M_GCRCSENT
+
+// Setup power
+#define HOST_POWER                                                                                 \
+    (FUSB302_PWR_INT_OSC | FUSB302_PWR_MEAS_BLOCK | FUSB302_PWR_RECV_CUR |                         \
+     FUSB302_PWR_BANDGAP_WAKE)
+
+#define HOST_IMAGE(hostCur, mdac)                                                                  \
+    {                                                                                              \
+        0x00, /* DEVICE_ID, read only */                                                           \
+        HOST_SWITCHES0, HOST_SWITCHES1, HOST_MEASURE(mdac), FUSB302_RESET_SLICE,                   \
+        HOST_CONTROL0(hostCur), HOST_CONTROL1, FUSB302_RESET_CONTROL2, HOST_CONTROL3, HOST_MASK,   \
+        HOST_POWER, FUSB302_RESET_RESET, FUSB302_RESET_OCREG, HOST_MASKA, HOST_MASKB,              \
+        FUSB302_RESET_CONTROL4                                                                     \
+    }
+
+// Complete control register image after host monitoring setup, per host current mode
+static const uint8_t hostImage[][FUSB302_REG_CONTROL_NUM] = {
+    [FUSB302_HOST_CURRENT_MODE_500MA] = HOST_IMAGE(FUSB302_HOST_CUR_DEF_USB, HOST_MDAC_DEFAULT),
+    [FUSB302_HOST_CURRENT_MODE_1_5A] = HOST_IMAGE(FUSB302_HOST_CUR_1_5A, HOST_MDAC_DEFAULT),
+    [FUSB302_HOST_CURRENT_MODE_3A] = HOST_IMAGE(FUSB302_HOST_CUR_3A, HOST_MDAC_3A),
+};
+
+// CC level above the 3A MDAC threshold (open), BC_LVL alone cannot tell it from Rd at 3A
+#define HOST_BC_LVL_OPEN_3A 4
+
+#define SNAPSHOT_MAGIC0 'F'
+#define SNAPSHOT_MAGIC1 'H'
+#define SNAPSHOT_VERSION 2
 
 static bool DiscoverAttachment(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                                FUSB302_HostCurrentMode_t hostCurrentMode,
@@ -27,6 +97,7 @@ static bool DiscoverAttachment(FUSB302_Platform_t *platform, FUSB302_Data_t *dat
     ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0);
     uint8_t bc_lvl_cc1 =
         FUSB302_GetDataValue(data, FUSB302_REG_STATUS0, FUSB302_BC_LVL_BITS, FUSB302_BC_LVL_OFFSET);
+    uint8_t comp_cc1 = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
 
     // Set switches for CC2 measure only (no pull-up for CC1 since pull-ups are connected)
     FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1, 0);
@@ -41,6 +112,7 @@ static bool DiscoverAttachment(FUSB302_Platform_t *platform, FUSB302_Data_t *dat
     ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0);
     uint8_t bc_lvl_cc2 =
         FUSB302_GetDataValue(data, FUSB302_REG_STATUS0, FUSB302_BC_LVL_BITS, FUSB302_BC_LVL_OFFSET);
+    uint8_t comp_cc2 = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
 
     // Check error
     if (!ok) {
@@ -66,6 +138,11 @@ static bool DiscoverAttachment(FUSB302_Platform_t *platform, FUSB302_Data_t *dat
         expectedBcLvl_Rd = FUSB302_BC_LVL_1230MV_MORE; // 1.68 V
         expectedBcLvl_Ra = FUSB302_BC_LVL_200_660MV;   // 0.33 V
         expectedBcLvl_Ra_alt = expectedBcLvl_Ra;       // no alternative
+
+        // Rd and open both read 1.23 V or more, COMP against the 3A MDAC (2.604 V) separates them
+        expectedBcLvl_Nc = HOST_BC_LVL_OPEN_3A;
+        bc_lvl_cc1 = comp_cc1 ? HOST_BC_LVL_OPEN_3A : bc_lvl_cc1;
+        bc_lvl_cc2 = comp_cc2 ? HOST_BC_LVL_OPEN_3A : bc_lvl_cc2;
         break;
     }
 
@@ -115,13 +192,71 @@ static bool DiscoverAttachment(FUSB302_Platform_t *platform, FUSB302_Data_t *dat
     return true;
 }
 
+static bool ConfigureProtection(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                const FUSB302_PDIdentity_t *cableIdentity) {
+    uint8_t prevOcReg = *FUSB302_GetRegPtr(data, FUSB302_REG_OCREG);
+
+    if (cableIdentity && cableIdentity->productType == FUSB302_PD_PRODUCT_TYPE_PASSIVE_CABLE) {
+        // Passive cable, only the emarker is powered from VCONN: 80 mA
+        FUSB302_SetDataBit(data, FUSB302_REG_OCREG, FUSB302_OCP_RANGE, 0);
+        FUSB302_SetDataValue(data, FUSB302_REG_OCREG, FUSB302_OCP_CUR_BITS,
+                             FUSB302_OCP_CUR_OFFSET, FUSB302_OCP_CUR_MAX_RANGE);
+    } else {
+        // Active or not yet identified cable, up to 1 W VCONN power: 300 mA
+        FUSB302_SetDataBit(data, FUSB302_REG_OCREG, FUSB302_OCP_RANGE, 1);
+        FUSB302_SetDataValue(data, FUSB302_REG_OCREG, FUSB302_OCP_CUR_BITS,
+                             FUSB302_OCP_CUR_OFFSET, FUSB302_OCP_CUR_3_8_MAX_RANGE);
+    }
+
+    // Write only on change
+    if (*FUSB302_GetRegPtr(data, FUSB302_REG_OCREG) == prevOcReg) {
+        return true;
+    }
+
+    return FUSB302_WriteControlData(platform, data, FUSB302_REG_OCREG);
+}
+
+static bool HandleProtectionFault(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring) {
+    // Drop VCONN first: single SWITCHES0 write right after the status read reporting the fault
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC1, 0);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC2, 0);
+    bool ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+    FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_VCONN_OFF);
+    FUSB302_ProfileRecord(platform, monitoring->profile, FUSB302_LATENCY_FAULT_TO_VCONN_OFF,
+                          FUSB302_PHASE_STATUS_READ, FUSB302_PHASE_VCONN_OFF);
+
+    // Count fault by source (STATUS1 was read in the same burst as the interrupt)
+    uint8_t ocp = FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_OCP);
+    uint8_t ovrTemp = FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_OVRTEMP);
+    if (ovrTemp) {
+        monitoring->counters.overTempFaults++;
+    }
+    if (ocp || !ovrTemp) {
+        monitoring->counters.ocpFaults++;
+    }
+    monitoring->counters.lastFaultTime = time;
+
+    // Stay in safe state until detach if VCONN was provided
+    if (FUSB302_IsActiveCableAttached(monitoring)) {
+        monitoring->state = FUSB302_HOST_STATE_FAULT;
+        monitoring->emarkerPresent = false;
+    }
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: VCONN fault (OCP=%d, OVRTEMP=%d), VCONN off\r\n", ocp, ovrTemp);
+#endif
+
+    return ok;
+}
+
 static bool ConfigureState(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                            FUSB302_HostState_t state, FUSB302_CC_Orientation_t ccOrientation) {
     bool ok = true;
 
     switch (state) {
     case FUSB302_HOST_STATE_ATTACHED_DEVICE:
-        // Set switches for monitoring of active CC channel
+        // Set switches for monitoring of active CC channel, BMC for PD communication with device
         if (ccOrientation == FUSB302_CC_ORIENTATION_CC1) {
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1, 1);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN2, 0);
@@ -131,7 +266,7 @@ static bool ConfigureState(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2, 0);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN1, 0);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN2, 0);
-            FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC1, 0);
+            FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC1, 1);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC2, 0);
         } else if (ccOrientation == FUSB302_CC_ORIENTATION_CC2) {
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1, 0);
@@ -143,7 +278,7 @@ static bool ConfigureState(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN1, 0);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN2, 0);
             FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC1, 0);
-            FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC2, 0);
+            FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC2, 1);
         } else {
             return false;
         }
@@ -179,11 +314,33 @@ static bool ConfigureState(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
         } else {
             return false;
         }
+
+        // Setup VCONN over-current protection before enabling VCONN
+        ok &= ConfigureProtection(platform, data, 0);
+
         ok &= FUSB302_WriteControlDataSeq(platform, data, FUSB302_REG_SWITCHES0, 2);
 
         // Wait for VCONN to stabilize
         platform->delayUs(10000);
 
+        break;
+    case FUSB302_HOST_STATE_FAULT:
+        // Keep pull-ups without VCONN, monitor cable (Ra) side of CC to detect detach
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1, 1);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN2, 1);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC1, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC2, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1,
+                           ccOrientation != FUSB302_CC_ORIENTATION_CC1);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2,
+                           ccOrientation == FUSB302_CC_ORIENTATION_CC1);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN1, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN2, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC1, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_TXCC2, 0);
+        ok &= FUSB302_WriteControlDataSeq(platform, data, FUSB302_REG_SWITCHES0, 2);
+
+        platform->delayUs(1000);
         break;
     case FUSB302_HOST_STATE_INIT:
     case FUSB302_HOST_STATE_DETACHED:
@@ -212,108 +369,134 @@ static bool ConfigureState(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
     return ok;
 }
 
-bool FUSB302_SetupHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
-                                 FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
-                                 FUSB302_HostMonitoring_t *monitoring) {
-    // Reset FUSB302
-    if (!FUSB302_Reset(platform, data)) {
-        return false;
+static const uint8_t *HostImage(FUSB302_HostCurrentMode_t hostCurrentMode) {
+    if (hostCurrentMode > FUSB302_HOST_CURRENT_MODE_3A) {
+        return hostImage[FUSB302_HOST_CURRENT_MODE_500MA];
     }
 
-    platform->delayUs(10000);
+    return hostImage[hostCurrentMode];
+}
 
-    // Read control data
-    if (!FUSB302_ReadControlData(platform, data, FUSB302_REG_ALL)) {
-        return false;
+static void InitMonitoring(FUSB302_Platform_t *platform, FUSB302_HostCurrentMode_t hostCurrentMode,
+                           FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring) {
+    monitoring->state = FUSB302_HOST_STATE_INIT;
+    monitoring->hostCurrentMode = hostCurrentMode;
+    monitoring->hostCurrentSetting = hostCurrentMode;
+    monitoring->hostCurrentCap = FUSB302_HOST_CURRENT_MODE_3A;
+    monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+    monitoring->emarkerPresent = false;
+    monitoring->time = time;
+    monitoring->debounce.active = false;
+    monitoring->debounce.comp = 0;
+    monitoring->debounce.settled = false;
+    monitoring->debounce.time = time;
+    monitoring->integrityTime = time;
+    FUSB302_ProtocolHardReset(&monitoring->protocol);
+    monitoring->protocol.duplicates = 0;
+    monitoring->protocol.unchunked = 0;
+    monitoring->counters.ocpFaults = 0;
+    monitoring->counters.overTempFaults = 0;
+    monitoring->counters.softResets = 0;
+    monitoring->counters.hardResets = 0;
+    monitoring->counters.chipResets = 0;
+    monitoring->counters.lastFaultTime = platform->invalidCycleTime;
+    monitoring->profile = 0;
+    monitoring->statusExport = 0;
+    monitoring->cableDiscovery = false;
+}
+
+static bool CheckBufferPool(FUSB302_Platform_t *platform) {
+    // PD messages (emarker discovery) need the message buffers of the port
+    if (platform->bufferPool) {
+        return true;
     }
 
-    // Enable host pullups (note: both pullups seem to be internally connected ~300R)
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1, 1);
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN2, 1);
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: No buffer pool, set platform->bufferPool\r\n");
+#endif
 
-    // Setup current CC to measure
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1, 1);
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2, 0);
+    return false;
+}
 
-    // Disable host powerdowns
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN1, 0);
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PDWN2, 0);
+static bool CheckChipReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                           FUSB302_CycleTime time, bool lostInterrupts,
+                           FUSB302_HostMonitoring_t *monitoring, bool *restored) {
+    *restored = false;
+
+    // Check when the update would act on the chip (interrupts, debounce, emarker ping), otherwise
+    // once per interval
+    bool active = lostInterrupts || monitoring->debounce.active ||
+                  monitoring->state == FUSB302_HOST_STATE_ATTACHED_CABLE ||
+                  *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTA) ||
+                  *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTB) ||
+                  *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPT);
+    if (!active && platform->getTimeDiffMs(time, monitoring->integrityTime) <
+                       FUSB302_HOST_INTEGRITY_CHECK_MS) {
+        return true;
+    }
+    monitoring->integrityTime = time;
 
-    // Setup bits used for constructing the GoodCRC acknowledge packet
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_POWERROLE, 1); // 1: Source if SOP
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_DATAROLE, 1);  // 1: SRC
-    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES1, FUSB302_AUTOCRC, 1);   // 1: auto GoodCRC ack
+    if (!FUSB302_CheckChipReset(platform, data, restored)) {
+        return false;
+    }
+    if (!*restored) {
+        return true;
+    }
+    monitoring->counters.chipResets++;
 
-    // Setup comparator to measure CC
-    FUSB302_SetDataBit(data, FUSB302_REG_MEASURE, FUSB302_MEAS_VBUS, 0);
+    // Interrupts of the reset chip and of the restore itself are meaningless, read the burst again
+    // to clear them and resample CC with the restored switches
+    platform->delayUs(1000);
+    bool ok = FUSB302_ReadStatusDataSeq(platform, data, FUSB302_REG_INTERRUPTA,
+                                        FUSB302_REG_INTERRUPT - FUSB302_REG_INTERRUPTA + 1);
+    *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTA) = 0;
+    *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTB) = 0;
+    *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPT) = 0;
 
-    // Setup Measure Block DAC data input
-    if (hostCurrentMode != FUSB302_HOST_CURRENT_MODE_3A) {
-        // 6'b10_0101 (1.596 V)
-        uint8_t mdacValue = 0b100101;
-        FUSB302_SetDataValue(data, FUSB302_REG_MEASURE, FUSB302_MDAC_BITS, FUSB302_MDAC_OFFSET,
-                             mdacValue);
-    } else {
-        // 6'b11_1101 (2.604 V)
-        uint8_t mdacValue = 0b111101;
-        FUSB302_SetDataValue(data, FUSB302_REG_MEASURE, FUSB302_MDAC_BITS, FUSB302_MDAC_OFFSET,
-                             mdacValue);
-    }
+    return ok;
+}
 
-    // Enable interrupts to host
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_INT_MASK, 0);
+bool FUSB302_SetupHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                                 FUSB302_HostMonitoring_t *monitoring) {
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_HOST_SETUP + hostCurrentMode, time);
+    }
 
-    // Setup host current
-    int hostCurValue;
-    switch (hostCurrentMode) {
-    case FUSB302_HOST_CURRENT_MODE_500MA:
-        hostCurValue = FUSB302_HOST_CUR_DEF_USB;
-        break;
-    case FUSB302_HOST_CURRENT_MODE_1_5A:
-        hostCurValue = FUSB302_HOST_CUR_1_5A;
-        break;
-    case FUSB302_HOST_CURRENT_MODE_3A:
-        hostCurValue = FUSB302_HOST_CUR_3A;
-        break;
-    default:
-        hostCurValue = FUSB302_HOST_CUR_DEF_USB;
-        break;
+    if (!CheckBufferPool(platform)) {
+        return false;
     }
 
-    FUSB302_SetDataValue(data, FUSB302_REG_CONTROL0, FUSB302_HOST_CUR_BITS, FUSB302_HOST_CUR_OFFSET,
-                         hostCurValue);
+    // Reset FUSB302
+    if (!FUSB302_Reset(platform, data)) {
+        return false;
+    }
 
-    // Enable SOP' (SOP prime) packet detection for cable communication
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_ENSOP1, 1);
+    platform->delayUs(10000);
 
-    // Enable AUTO_RETRY and set N_RETRIES
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL3, FUSB302_AUTO_RETRY, 1);
-    FUSB302_SetDataValue(data, FUSB302_REG_CONTROL3, FUSB302_N_RETRIES_BITS,
-                         FUSB302_N_RETRIES_OFFSET, FUSB302_N_RETRIES_3);
+    return FUSB302_StartHostMonitoring(platform, data, hostCurrentMode, time, false, monitoring);
+}
 
-    // Mask all interupts except selected
-    FUSB302_SetDataValue(data, FUSB302_REG_MASK, 0xFF, 0,
-                         ~(FUSB302_M_COMP_CHNG | FUSB302_M_BC_LVL | FUSB302_M_CRC_CHK));
-    FUSB302_SetDataValue(data, FUSB302_REG_MASKA, 0xFF, 0, 0xFF);
-    FUSB302_SetDataValue(data, FUSB302_REG_MASKA, 0x01, 0, 0x01);
+bool FUSB302_StartHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                                 bool debounced, FUSB302_HostMonitoring_t *monitoring) {
+    if (!CheckBufferPool(platform)) {
+        return false;
+    }
 
-    // Setup power
-    FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_MEAS_BLOCK, 1);
-    FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_RECV_CUR, 1);
-    FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_BANDGAP_WAKE, 1);
-    FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_INT_OSC, 1);
+    // Setup host monitoring configuration (complete image, previous configuration is overwritten)
+    memcpy(data->controlRegData, HostImage(hostCurrentMode), FUSB302_REG_CONTROL_NUM);
 
     // Write control registers
     if (!FUSB302_WriteControlData(platform, data, FUSB302_REG_ALL)) {
         return false;
     }
 
-    // Set initial monitoring state
-    monitoring->state = FUSB302_HOST_STATE_INIT;
-    monitoring->hostCurrentMode = hostCurrentMode;
-    monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
-    monitoring->emarkerPresent = false;
-    monitoring->time = time;
+    // Set initial monitoring state, a debounced attach is committed on the first update
+    InitMonitoring(platform, hostCurrentMode, time, monitoring);
+    monitoring->debounce.active = debounced;
+    monitoring->debounce.settled = debounced;
 
 #ifdef FUSB302_DEBUG
     platform->debugPrint("FUSB302: Host monitoring started\r\n");
@@ -324,29 +507,111 @@ bool FUSB302_SetupHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *d
 
 bool FUSB302_UpdateHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                                   FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring) {
-    // Read interrupt status registr
-    if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_INTERRUPT)) {
-        return false;
+    bool ok = true;
+
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_HOST_UPDATE, time);
     }
 
-    bool ok = true;
+    // Read interrupt and status registers in one burst (INTERRUPTA..INTERRUPT)
+    FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_STATUS_READ);
+    bool lostInterrupts = false;
+    if (!FUSB302_ReadStatusDataSeq(platform, data, FUSB302_REG_INTERRUPTA,
+                                   FUSB302_REG_INTERRUPT - FUSB302_REG_INTERRUPTA + 1)) {
+        // The burst is not retried (interrupts are cleared on read). Resample the level bits instead
+        // (idempotent reads): CC level, OCP/OVRTEMP and received PD resets
+        if (!FUSB302_ReadStatusDataSeq(platform, data, FUSB302_REG_STATUS0,
+                                       FUSB302_REG_STATUS1 - FUSB302_REG_STATUS0 + 1) ||
+            !FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0A)) {
+            return false;
+        }
+        *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTA) = 0;
+        *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPTB) = 0;
+        *FUSB302_GetRegPtr(data, FUSB302_REG_INTERRUPT) = 0;
+        lostInterrupts = true;
+
+        // Faults and resets lost with the burst are handled from the level bits
+        FUSB302_SetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_OCP_TEMP,
+                           FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_OCP) ||
+                               FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_OVRTEMP));
+        FUSB302_SetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_HARDRST,
+                           FUSB302_GetDataBit(data, FUSB302_REG_STATUS0A, FUSB302_HARDRST));
+        FUSB302_SetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_SOFTRST,
+                           FUSB302_GetDataBit(data, FUSB302_REG_STATUS0A, FUSB302_SOFTRST));
+        ok = false;
+    }
+
+    // Check for a chip reset before acting on the burst
+    bool chipRestored = false;
+    ok &= CheckChipReset(platform, data, time, lostInterrupts, monitoring, &chipRestored);
+    lostInterrupts |= chipRestored;
 
     // Save prev state
     FUSB302_HostState_t prevState = monitoring->state;
+
+    // Check VCONN over-current / over-temperature first
+    uint8_t i_ocp_temp = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_OCP_TEMP);
+    if (i_ocp_temp && monitoring->state != FUSB302_HOST_STATE_FAULT) {
+        ok &= HandleProtectionFault(platform, data, time, monitoring);
+    }
+
+    // Check PD resets from port partner, recover protocol layer only
+    uint8_t i_hardrst = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_HARDRST);
+    uint8_t i_softrst = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_SOFTRST);
+    if (i_hardrst) {
+        monitoring->counters.hardResets++;
+        FUSB302_ProtocolHardReset(&monitoring->protocol);
+        ok &= FUSB302_Recover(platform, data, FUSB302_RECOVERY_REGISTERS);
+    } else if (i_softrst) {
+        monitoring->counters.softResets++;
+        FUSB302_ProtocolSoftReset(&monitoring->protocol, FUSB302_SOP);
+        ok &= FUSB302_Recover(platform, data, FUSB302_RECOVERY_PROTOCOL);
+    }
+
     bool prevActiveCable = FUSB302_IsActiveCableAttached(monitoring);
 
     // Check COMP and BC_LVL interrupt
     uint8_t i_comp_chng = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_COMP_CHNG);
     uint8_t i_bc_lvl = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_BC_LVL);
-    if (i_comp_chng || i_bc_lvl || monitoring->state == FUSB302_HOST_STATE_INIT) {
-        // Read STATUS0 register
-        if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0)) {
-            return false;
+    bool ccStable = false;
+    uint8_t comp = 0;
+    if (i_comp_chng || i_bc_lvl || lostInterrupts ||
+        monitoring->state == FUSB302_HOST_STATE_INIT || monitoring->debounce.active) {
+        // Check COMP value (STATUS0 was read in the same burst)
+        comp = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
+
+        // Restart debounce on every CC edge
+        if (!monitoring->debounce.active) {
+            FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_EVENT);
+        }
+        if (!monitoring->debounce.active || i_comp_chng || i_bc_lvl ||
+            comp != monitoring->debounce.comp) {
+            // Edges from switching to host monitoring do not cancel a debounced attach
+            monitoring->debounce.settled &= comp == monitoring->debounce.comp;
+            monitoring->debounce.active = true;
+            monitoring->debounce.comp = comp;
+            monitoring->debounce.time = time;
+        }
+
+        // Commit only when stable: tPDDebounce for removal (high level), tCCDebounce otherwise
+        FUSB302_TimeDiffMs debounceMs = comp ? FUSB302_T_PD_DEBOUNCE_MS : FUSB302_T_CC_DEBOUNCE_MS;
+        if (monitoring->debounce.settled ||
+            platform->getTimeDiffMs(time, monitoring->debounce.time) >= debounceMs) {
+            monitoring->debounce.active = false;
+            monitoring->debounce.settled = false;
+            ccStable = true;
         }
+    }
 
-        // Check COMP value
-        uint8_t comp = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
-        if (comp) {
+    if (ccStable) {
+        if (monitoring->state == FUSB302_HOST_STATE_FAULT) {
+            // Cable side of CC is monitored in fault state, high level means cable removed
+            if (comp) {
+                monitoring->state = FUSB302_HOST_STATE_DETACHED;
+                monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+            }
+        } else if (comp) {
             // 1: Measured CC* input is higher than reference level driven from the MDAC.
             if (prevActiveCable) {
                 monitoring->state = FUSB302_HOST_STATE_ATTACHED_CABLE;
@@ -359,24 +624,34 @@ bool FUSB302_UpdateHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *
 
             if (prevActiveCable) {
                 monitoring->state = FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE;
+            } else if (monitoring->state == FUSB302_HOST_STATE_ATTACHED_DEVICE) {
+                // Same device still attached, nothing to reconfigure
             } else {
                 // Discover CC orientation and cable type
                 ok &= DiscoverAttachment(platform, data, monitoring->hostCurrentMode,
                                          &monitoring->ccOrientation, &monitoring->state);
+                FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_DISCOVERED);
             }
         }
     }
 
-    // For active cable, ping emarker to update state
-    if (prevActiveCable) {
-        ok &= FUSB302_HostCableDiscoverIdentity(platform, data, monitoring->ccOrientation, true,
-                                                &monitoring->emarkerPresent, 0);
+    // For active cable alone, ping emarker to update state (with a device, detach is seen on CC;
+    // pinging would also flush SOP messages from the device). After a chip reset, VCONN settles
+    // until the next update.
+    if (prevActiveCable && monitoring->state == FUSB302_HOST_STATE_ATTACHED_CABLE &&
+        !chipRestored) {
+        ok &= FUSB302_ProtocolCableDiscoverIdentity(platform, data, &monitoring->protocol,
+                                                    monitoring->ccOrientation, true,
+                                                    &monitoring->emarkerPresent, 0);
 
         if (!monitoring->emarkerPresent) {
+            FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_EVENT);
             monitoring->state = FUSB302_HOST_STATE_DETACHED;
             monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
 
+#ifdef FUSB302_DEBUG
             platform->debugPrint("FUSB302: Emarker not present, active cable detached\r\n");
+#endif
         }
     }
 
@@ -389,13 +664,47 @@ bool FUSB302_UpdateHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *
 
         ok &= ConfigureState(platform, data, monitoring->state, monitoring->ccOrientation);
 
-        // Check if emarker is present
-        if (FUSB302_IsActiveCableAttached(monitoring)) {
-            ok &= FUSB302_HostCableDiscoverIdentity(platform, data, monitoring->ccOrientation, false,
-                                                    &monitoring->emarkerPresent, &monitoring->cableIdentity);
+        // New port partner or cable starts a new MessageID sequence
+        FUSB302_ProtocolHardReset(&monitoring->protocol);
+
+        FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_CONFIGURED);
+        if (FUSB302_IsDeviceAttached(monitoring) || FUSB302_IsActiveCableAttached(monitoring)) {
+            FUSB302_ProfileRecord(platform, monitoring->profile,
+                                  FUSB302_LATENCY_ATTACH_TO_CONFIGURED, FUSB302_PHASE_EVENT,
+                                  FUSB302_PHASE_CONFIGURED);
+        } else if (monitoring->state == FUSB302_HOST_STATE_DETACHED) {
+            FUSB302_ProfileRecord(platform, monitoring->profile, FUSB302_LATENCY_DETACH_TO_IDLE,
+                                  FUSB302_PHASE_EVENT, FUSB302_PHASE_CONFIGURED);
+        }
+
+        // Check if emarker is present, with a device FUSB302Discovery may ask instead
+        bool discoveryPending = monitoring->cableDiscovery && FUSB302_IsDeviceAttached(monitoring);
+        if (FUSB302_IsActiveCableAttached(monitoring) && discoveryPending && !prevActiveCable) {
+            // New cable, not identified until FUSB302_SetHostCableIdentity
+            monitoring->emarkerPresent = false;
+            ok &= ConfigureProtection(platform, data, 0);
+        } else if (FUSB302_IsActiveCableAttached(monitoring) && !discoveryPending) {
+            FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_IDENTITY_START);
+            ok &= FUSB302_ProtocolCableDiscoverIdentity(platform, data, &monitoring->protocol,
+                                                        monitoring->ccOrientation, false,
+                                                        &monitoring->emarkerPresent,
+                                                        &monitoring->cableIdentity);
+            FUSB302_ProfileMark(platform, monitoring->profile, FUSB302_PHASE_IDENTITY_DONE);
+            FUSB302_ProfileRecord(platform, monitoring->profile, FUSB302_LATENCY_DISCOVER_IDENTITY,
+                                  FUSB302_PHASE_IDENTITY_START, FUSB302_PHASE_IDENTITY_DONE);
+
+            // Narrow VCONN over-current limit to the identified cable type
+            if (monitoring->emarkerPresent) {
+                ok &= ConfigureProtection(platform, data, &monitoring->cableIdentity);
+            }
         }
     }
 
+    // Publish changes to monitoring tools
+    if (monitoring->statusExport) {
+        FUSB302_ExportHostStatus(monitoring->statusExport, monitoring, time);
+    }
+
     // Check error
     if (!ok) {
         return false;
@@ -404,6 +713,301 @@ bool FUSB302_UpdateHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *
     return true;
 }
 
+static uint8_t SnapshotChecksum(const uint8_t *snapshot, int len) {
+    uint8_t sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum = (uint8_t)((sum << 1) | (sum >> 7)) ^ snapshot[i];
+    }
+
+    return sum;
+}
+
+static bool LoadSnapshot(const uint8_t *snapshot, int snapshotLen,
+                         FUSB302_HostMonitoring_t *restored) {
+    if (!snapshot || snapshotLen < FUSB302_HOST_SNAPSHOT_SIZE) {
+        return false;
+    }
+
+    if (snapshot[0] != SNAPSHOT_MAGIC0 || snapshot[1] != SNAPSHOT_MAGIC1 ||
+        snapshot[2] != SNAPSHOT_VERSION ||
+        snapshot[FUSB302_HOST_SNAPSHOT_SIZE - 1] !=
+            SnapshotChecksum(snapshot, FUSB302_HOST_SNAPSHOT_SIZE - 1)) {
+        return false;
+    }
+
+    restored->state = (FUSB302_HostState_t)snapshot[3];
+    restored->ccOrientation = (FUSB302_CC_Orientation_t)snapshot[4];
+    restored->emarkerPresent = snapshot[5] != 0;
+    restored->cableIdentity.vid = snapshot[6] | (snapshot[7] << 8);
+    restored->cableIdentity.productType = snapshot[8];
+    restored->cableIdentity.vbusCurrentMa = snapshot[9] * 100;
+
+    return true;
+}
+
+static uint8_t RuntimeBits(int reg) {
+    // Bits changed at runtime by this driver: TX CC selection, SOP'' detection (discovery), automatic
+    // PD resets (FUSB302_SetupAutoReset), self-clearing hard reset command
+    switch (reg) {
+    case FUSB302_REG_SWITCHES1:
+        return FUSB302_TXCC1 | FUSB302_TXCC2;
+    case FUSB302_REG_CONTROL1:
+        return FUSB302_ENSOP2 | FUSB302_ENSOP2DB;
+    case FUSB302_REG_CONTROL3:
+        return FUSB302_AUTO_SOFTRESET | FUSB302_AUTO_HARDRESET | FUSB302_SEND_HARD_RESET;
+    default:
+        return 0;
+    }
+}
+
+static bool CheckHostConfig(FUSB302_Data_t *chip, FUSB302_HostCurrentMode_t hostCurrentMode) {
+    const uint8_t *image = HostImage(hostCurrentMode);
+
+    // CC switches and VCONN limit depend on the attach state and are not checked
+    for (int reg = FUSB302_REG_SWITCHES1;
+         reg < FUSB302_REG_CONTROL_START + FUSB302_REG_CONTROL_NUM; reg++) {
+        if (reg == FUSB302_REG_RESET || reg == FUSB302_REG_OCREG) {
+            continue;
+        }
+
+        uint8_t mask = (uint8_t)~RuntimeBits(reg);
+        if ((image[reg - FUSB302_REG_CONTROL_START] & mask) !=
+            (*FUSB302_GetRegPtr(chip, reg) & mask)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool DeriveHostState(FUSB302_Data_t *data, FUSB302_HostState_t *state,
+                            FUSB302_CC_Orientation_t *ccOrientation) {
+    int pu1 = FUSB302_GetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN1);
+    int pu2 = FUSB302_GetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_PU_EN2);
+    int vconn1 = FUSB302_GetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC1);
+    int vconn2 = FUSB302_GetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC2);
+
+    if (pu1 && pu2 && !vconn1 && !vconn2) {
+        // Both pullups: detached (or fault, resolved by snapshot)
+        *state = FUSB302_HOST_STATE_DETACHED;
+        *ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+    } else if (pu1 && !pu2 && !vconn1) {
+        *state = vconn2 ? FUSB302_HOST_STATE_ATTACHED_CABLE : FUSB302_HOST_STATE_ATTACHED_DEVICE;
+        *ccOrientation = FUSB302_CC_ORIENTATION_CC1;
+    } else if (pu2 && !pu1 && !vconn2) {
+        *state = vconn1 ? FUSB302_HOST_STATE_ATTACHED_CABLE : FUSB302_HOST_STATE_ATTACHED_DEVICE;
+        *ccOrientation = FUSB302_CC_ORIENTATION_CC2;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool FindHostConfig(FUSB302_Data_t *chip, FUSB302_HostCurrentMode_t *hostCurrentMode) {
+    // Setup mode first, Rp may have been changed at runtime (FUSB302_SetHostCurrent)
+    if (CheckHostConfig(chip, *hostCurrentMode)) {
+        return true;
+    }
+    for (int mode = FUSB302_HOST_CURRENT_MODE_500MA; mode <= FUSB302_HOST_CURRENT_MODE_3A; mode++) {
+        if (CheckHostConfig(chip, (FUSB302_HostCurrentMode_t)mode)) {
+            *hostCurrentMode = (FUSB302_HostCurrentMode_t)mode;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FUSB302_SaveHostSnapshot(const FUSB302_HostMonitoring_t *monitoring, uint8_t *snapshot,
+                              int snapshotSize, int *snapshotLen) {
+    if (snapshotSize < FUSB302_HOST_SNAPSHOT_SIZE) {
+        return false;
+    }
+
+    snapshot[0] = SNAPSHOT_MAGIC0;
+    snapshot[1] = SNAPSHOT_MAGIC1;
+    snapshot[2] = SNAPSHOT_VERSION;
+    snapshot[3] = (uint8_t)monitoring->state;
+    snapshot[4] = (uint8_t)monitoring->ccOrientation;
+    snapshot[5] = monitoring->emarkerPresent ? 1 : 0;
+    snapshot[6] = monitoring->cableIdentity.vid & 0xFF;
+    snapshot[7] = monitoring->cableIdentity.vid >> 8;
+    snapshot[8] = monitoring->cableIdentity.productType;
+    snapshot[9] = (uint8_t)(monitoring->cableIdentity.vbusCurrentMa / 100);
+    snapshot[10] = SnapshotChecksum(snapshot, FUSB302_HOST_SNAPSHOT_SIZE - 1);
+
+    *snapshotLen = FUSB302_HOST_SNAPSHOT_SIZE;
+
+    return true;
+}
+
+bool FUSB302_ResumeHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                                  const uint8_t *snapshot, int snapshotLen,
+                                  FUSB302_HostMonitoring_t *monitoring) {
+    if (!CheckBufferPool(platform)) {
+        return false;
+    }
+
+    // Read live control image, no reset
+    if (!FUSB302_ReadControlData(platform, data, FUSB302_REG_ALL)) {
+        return false;
+    }
+
+    // Chip must still be configured for host monitoring (not reset or reconfigured meanwhile)
+    if (!FindHostConfig(data, &hostCurrentMode)) {
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: Warm start rejected, configuration mismatch\r\n");
+#endif
+        return false;
+    }
+
+    // Derive attach state from CC switches
+    FUSB302_HostState_t state;
+    FUSB302_CC_Orientation_t ccOrientation;
+    if (!DeriveHostState(data, &state, &ccOrientation)) {
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: Warm start rejected, unexpected CC switches\r\n");
+#endif
+        return false;
+    }
+
+    InitMonitoring(platform, hostCurrentMode, time, monitoring);
+
+    // Prefer snapshot when it agrees with the chip
+    FUSB302_HostMonitoring_t restored;
+    bool snapshotValid = LoadSnapshot(snapshot, snapshotLen, &restored);
+    bool ok = true;
+
+    switch (state) {
+    case FUSB302_HOST_STATE_ATTACHED_DEVICE:
+        monitoring->state = state;
+        monitoring->ccOrientation = ccOrientation;
+        break;
+    case FUSB302_HOST_STATE_ATTACHED_CABLE:
+        if (snapshotValid && FUSB302_IsActiveCableAttached(&restored) &&
+            restored.ccOrientation == ccOrientation) {
+            monitoring->state = restored.state;
+            monitoring->ccOrientation = ccOrientation;
+            monitoring->emarkerPresent = restored.emarkerPresent;
+            monitoring->cableIdentity = restored.cableIdentity;
+        } else {
+            // No snapshot: check device presence on CC and query emarker again (VCONN stays on)
+            ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0);
+            uint8_t comp = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
+            monitoring->state = comp ? FUSB302_HOST_STATE_ATTACHED_CABLE
+                                     : FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE;
+            monitoring->ccOrientation = ccOrientation;
+            ok &= FUSB302_ProtocolCableDiscoverIdentity(platform, data, &monitoring->protocol,
+                                                        ccOrientation, false,
+                                                        &monitoring->emarkerPresent,
+                                                        &monitoring->cableIdentity);
+        }
+        break;
+    case FUSB302_HOST_STATE_DETACHED:
+    default:
+        if (snapshotValid && restored.state == FUSB302_HOST_STATE_FAULT &&
+            (restored.ccOrientation == FUSB302_CC_ORIENTATION_CC1 ||
+             restored.ccOrientation == FUSB302_CC_ORIENTATION_CC2)) {
+            // VCONN stays off until the cable is removed, re-arm detach detection on the cable side
+            monitoring->state = FUSB302_HOST_STATE_FAULT;
+            monitoring->ccOrientation = restored.ccOrientation;
+            ok &= ConfigureState(platform, data, monitoring->state, monitoring->ccOrientation);
+        } else {
+            // Re-evaluate CC level on next update (no VCONN to interrupt)
+            monitoring->state = FUSB302_HOST_STATE_INIT;
+        }
+        break;
+    }
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Host monitoring resumed, state=%d (CC = %d, snapshot=%d)\r\n",
+                         monitoring->state, monitoring->ccOrientation, snapshotValid);
+#endif
+
+    return ok;
+}
+
+static bool WriteHostCurrent(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_HostMonitoring_t *monitoring) {
+    // Advertise the setting, lowered by a temporary cap
+    FUSB302_HostCurrentMode_t hostCurrentMode = monitoring->hostCurrentSetting;
+    if (monitoring->hostCurrentCap < hostCurrentMode) {
+        hostCurrentMode = monitoring->hostCurrentCap;
+    }
+    if (hostCurrentMode == monitoring->hostCurrentMode) {
+        return true;
+    }
+
+    // Take Rp current and detach threshold from the image of the new mode
+    const uint8_t *image = HostImage(hostCurrentMode);
+    uint8_t measure = image[FUSB302_REG_MEASURE - FUSB302_REG_CONTROL_START];
+    uint8_t control0 = image[FUSB302_REG_CONTROL0 - FUSB302_REG_CONTROL_START];
+    FUSB302_SetDataValue(data, FUSB302_REG_MEASURE, FUSB302_MDAC_BITS, FUSB302_MDAC_OFFSET,
+                         (measure & FUSB302_MDAC_BITS) >> FUSB302_MDAC_OFFSET);
+    FUSB302_SetDataValue(data, FUSB302_REG_CONTROL0, FUSB302_HOST_CUR_BITS,
+                         FUSB302_HOST_CUR_OFFSET,
+                         (control0 & FUSB302_HOST_CUR_BITS) >> FUSB302_HOST_CUR_OFFSET);
+
+    // Change both in one transfer (MEASURE..CONTROL0), so COMP does not see a false detach
+    if (!FUSB302_WriteControlDataSeq(platform, data, FUSB302_REG_MEASURE,
+                                     FUSB302_REG_CONTROL0 - FUSB302_REG_MEASURE + 1)) {
+        return false;
+    }
+
+    monitoring->hostCurrentMode = hostCurrentMode;
+
+    return true;
+}
+
+bool FUSB302_SetHostCurrent(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            FUSB302_HostMonitoring_t *monitoring,
+                            FUSB302_HostCurrentMode_t hostCurrentMode) {
+    if (hostCurrentMode > FUSB302_HOST_CURRENT_MODE_3A) {
+        return false;
+    }
+
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_HOST_CURRENT, hostCurrentMode);
+    }
+
+    monitoring->hostCurrentSetting = hostCurrentMode;
+
+    return WriteHostCurrent(platform, data, monitoring);
+}
+
+bool FUSB302_SetHostCurrentCap(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                               FUSB302_HostMonitoring_t *monitoring,
+                               FUSB302_HostCurrentMode_t hostCurrentCap) {
+    if (hostCurrentCap > FUSB302_HOST_CURRENT_MODE_3A) {
+        return false;
+    }
+
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_HOST_CURRENT_CAP, hostCurrentCap);
+    }
+
+    monitoring->hostCurrentCap = hostCurrentCap;
+
+    return WriteHostCurrent(platform, data, monitoring);
+}
+
+bool FUSB302_SetHostCableIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_HostMonitoring_t *monitoring,
+                                  const FUSB302_PDIdentity_t *identity) {
+    if (!FUSB302_IsActiveCableAttached(monitoring)) {
+        return false;
+    }
+
+    monitoring->emarkerPresent = true;
+    monitoring->cableIdentity = *identity;
+
+    return ConfigureProtection(platform, data, identity);
+}
+
 bool FUSB302_IsDeviceAttached(FUSB302_HostMonitoring_t *monitoring) {
     return monitoring->state == FUSB302_HOST_STATE_ATTACHED_DEVICE ||
            monitoring->state == FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE;
@@ -413,3 +1017,7 @@ bool FUSB302_IsActiveCableAttached(FUSB302_HostMonitoring_t *monitoring) {
     return monitoring->state == FUSB302_HOST_STATE_ATTACHED_CABLE ||
            monitoring->state == FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE;
 }
+
+bool FUSB302_IsHostDebouncing(FUSB302_HostMonitoring_t *monitoring) {
+    return monitoring->debounce.active;
+}
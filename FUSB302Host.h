@@ -3,6 +3,7 @@
 
 #include "FUSB302.h"
 #include "FUSB302PD.h"
+#include "FUSB302Profile.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,25 +16,104 @@ typedef enum FUSB302_HostState {
     FUSB302_HOST_STATE_ATTACHED_CABLE,
     FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE,
     FUSB302_HOST_STATE_UNKNOWN,
+    FUSB302_HOST_STATE_FAULT, // VCONN over-current or over-temperature, VCONN off until detach
 } FUSB302_HostState_t;
 
+// Type-C CC debounce times: tCCDebounce (100..200 ms) for attach, tPDDebounce (10..20 ms) for detach
+#ifndef FUSB302_T_CC_DEBOUNCE_MS
+#define FUSB302_T_CC_DEBOUNCE_MS 100
+#endif
+#ifndef FUSB302_T_PD_DEBOUNCE_MS
+#define FUSB302_T_PD_DEBOUNCE_MS 10
+#endif
+
+// Interval of the chip reset check (one register read), restored before a detach could debounce
+#ifndef FUSB302_HOST_INTEGRITY_CHECK_MS
+#define FUSB302_HOST_INTEGRITY_CHECK_MS FUSB302_T_PD_DEBOUNCE_MS
+#endif
+
+typedef struct FUSB302_HostDebounce {
+    bool active;
+    uint8_t comp;           // raw COMP level waiting to become stable
+    bool settled;           // attach already debounced by the caller, commit on next update
+    FUSB302_CycleTime time; // time of last raw CC change
+} FUSB302_HostDebounce_t;
+
+typedef struct FUSB302_HostCounters {
+    uint32_t ocpFaults;
+    uint32_t overTempFaults;
+    uint32_t softResets;
+    uint32_t hardResets;
+    uint32_t chipResets; // brownouts detected and restored from the shadow image
+    FUSB302_CycleTime lastFaultTime;
+} FUSB302_HostCounters_t;
+
+// Shared memory status export (FUSB302Export.h)
+typedef struct FUSB302_PortStatusSlot FUSB302_PortStatusSlot_t;
+
 typedef struct FUSB302_HostMonitoring {
     FUSB302_HostState_t state;
-    FUSB302_HostCurrentMode_t hostCurrentMode;
+    FUSB302_HostCurrentMode_t hostCurrentMode;    // advertised Rp
+    FUSB302_HostCurrentMode_t hostCurrentSetting; // Rp set up or by FUSB302_SetHostCurrent
+    FUSB302_HostCurrentMode_t hostCurrentCap;     // temporary limit (SinkTxNG), 3A: none
     FUSB302_CC_Orientation_t ccOrientation;
     bool emarkerPresent;
     FUSB302_PDIdentity_t cableIdentity;
     FUSB302_CycleTime time;
+    FUSB302_HostDebounce_t debounce;
+    FUSB302_CycleTime integrityTime; // last chip reset check
+    FUSB302_Protocol_t protocol; // PD MessageID state of the port (SOP*)
+    FUSB302_HostCounters_t counters;
+    FUSB302_Profile_t *profile; // optional latency profile, set after setup (0: disabled)
+    FUSB302_PortStatusSlot_t *statusExport; // optional status export, set after setup (0: disabled)
+    bool cableDiscovery; // SOP' Discover Identity with a device attached left to FUSB302Discovery
 } FUSB302_HostMonitoring_t;
 
+// Serialized monitoring state for warm start (keep in retained RAM or a file)
+#define FUSB302_HOST_SNAPSHOT_SIZE 11
+
+// Setup, start and resume fail without platform->bufferPool (emarker discovery sends PD messages)
 bool FUSB302_SetupHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                                  FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
                                  FUSB302_HostMonitoring_t *monitoring);
+// Switches to host monitoring without reset (for example from a DRP toggle result). debounced: the
+// caller has seen Rd for tCCDebounce, the first update discovers the attachment without waiting.
+bool FUSB302_StartHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                                 bool debounced, FUSB302_HostMonitoring_t *monitoring);
+// VCONN over-current / over-temperature is handled first: VCONN is off two I2C transfers (status
+// burst, SWITCHES0 write) after the update starts, so at most one update period (or interrupt
+// latency) plus two transfers after the chip flags the fault. A failed burst adds the two status
+// reads the fault is then taken from. FUSB302_LATENCY_FAULT_TO_VCONN_OFF records the driver part.
 bool FUSB302_UpdateHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                                   FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring);
 
+bool FUSB302_SaveHostSnapshot(const FUSB302_HostMonitoring_t *monitoring, uint8_t *snapshot,
+                              int snapshotSize, int *snapshotLen);
+bool FUSB302_ResumeHostMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_HostCurrentMode_t hostCurrentMode, FUSB302_CycleTime time,
+                                  const uint8_t *snapshot, int snapshotLen,
+                                  FUSB302_HostMonitoring_t *monitoring);
+
+// Change Rp current setting while attached (owned by the application or FUSB302Budget)
+bool FUSB302_SetHostCurrent(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            FUSB302_HostMonitoring_t *monitoring,
+                            FUSB302_HostCurrentMode_t hostCurrentMode);
+// Temporary cap on top of the setting (PD 3.0 SinkTxNG, FUSB302Tx), 3A removes it. Rp is the
+// lower of both, releasing the cap never raises Rp above the setting.
+bool FUSB302_SetHostCurrentCap(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                               FUSB302_HostMonitoring_t *monitoring,
+                               FUSB302_HostCurrentMode_t hostCurrentCap);
+
+// Cable identity found by FUSB302Discovery (cableDiscovery set), narrows the VCONN over-current
+// limit like the identity found by host monitoring itself
+bool FUSB302_SetHostCableIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_HostMonitoring_t *monitoring,
+                                  const FUSB302_PDIdentity_t *identity);
+
 bool FUSB302_IsDeviceAttached(FUSB302_HostMonitoring_t *monitoring);
 bool FUSB302_IsActiveCableAttached(FUSB302_HostMonitoring_t *monitoring);
+bool FUSB302_IsHostDebouncing(FUSB302_HostMonitoring_t *monitoring);
 
 #ifdef __cplusplus
 }
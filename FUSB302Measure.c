@@ -0,0 +1,206 @@
+#include "FUSB302Measure.h"
+
+#define MDAC_MAX (FUSB302_MDAC_BITS >> FUSB302_MDAC_OFFSET)
+#define MDAC_STEPS 6
+
+static bool CompareMdac(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int mdac,
+                        bool *above) {
+    // Set MDAC reference level and let the comparator settle
+    FUSB302_SetDataValue(data, FUSB302_REG_MEASURE, FUSB302_MDAC_BITS, FUSB302_MDAC_OFFSET, mdac);
+    if (!FUSB302_WriteControlData(platform, data, FUSB302_REG_MEASURE)) {
+        return false;
+    }
+
+    platform->delayUs(FUSB302_MEASURE_SETTLE_US);
+
+    // 1: Measured input is higher than reference level driven from the MDAC
+    if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0)) {
+        return false;
+    }
+    *above = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_COMP);
+
+    return true;
+}
+
+static bool SearchMdac(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int *mdac) {
+    // Successive approximation, MSB first
+    int code = 0;
+    bool found = false;
+    for (int bit = MDAC_STEPS - 1; bit >= 0; bit--) {
+        int trial = code | (1 << bit);
+
+        bool above;
+        if (!CompareMdac(platform, data, trial, &above)) {
+            return false;
+        }
+
+        if (above) {
+            code = trial;
+            found = true;
+        }
+    }
+
+    // Every trial below: code 0 is not covered by the trials, probe it like TrackMdac does
+    if (!found) {
+        bool above;
+        if (!CompareMdac(platform, data, 0, &above)) {
+            return false;
+        }
+        code = above ? 0 : -1;
+    }
+    *mdac = code;
+
+    return true;
+}
+
+static bool TrackMdac(FUSB302_Platform_t *platform, FUSB302_Data_t *data, int *mdac) {
+    int code = *mdac < 0 ? 0 : *mdac;
+
+    bool above;
+    if (!CompareMdac(platform, data, code, &above)) {
+        return false;
+    }
+
+    if (above) {
+        // Input is at or above previous result, walk up until the comparator flips
+        for (int step = 0; step < FUSB302_MEASURE_TRACK_MAX_STEPS; step++) {
+            if (code == MDAC_MAX) {
+                *mdac = code;
+                return true;
+            }
+            if (!CompareMdac(platform, data, code + 1, &above)) {
+                return false;
+            }
+            if (!above) {
+                *mdac = code;
+                return true;
+            }
+            code++;
+        }
+    } else {
+        // Input is below previous result, walk down until the comparator flips
+        for (int step = 0; step < FUSB302_MEASURE_TRACK_MAX_STEPS; step++) {
+            code--;
+            if (code < 0) {
+                *mdac = -1;
+                return true;
+            }
+            if (!CompareMdac(platform, data, code, &above)) {
+                return false;
+            }
+            if (above) {
+                *mdac = code;
+                return true;
+            }
+        }
+    }
+
+    // Input moved too far since the previous result, start over
+    return SearchMdac(platform, data, mdac);
+}
+
+static int MdacToMv(FUSB302_MeasureInput_t input, int mdac) {
+    if (mdac < 0) {
+        return 0;
+    }
+
+    if (input == FUSB302_MEASURE_INPUT_VBUS) {
+        return FUSB302_MDAC_VBUS_ZERO_MV + mdac * FUSB302_MDAC_VBUS_LSB_MV;
+    } else {
+        return FUSB302_MDAC_ZERO_MV + mdac * FUSB302_MDAC_LSB_MV;
+    }
+}
+
+static bool MeasureMdac(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                        FUSB302_MeasureInput_t input, bool track, int *mdac) {
+    bool ok = true;
+
+    // Save current measure setup (used by host monitoring for detach detection)
+    uint8_t switches0 = *FUSB302_GetRegPtr(data, FUSB302_REG_SWITCHES0);
+    uint8_t measure = *FUSB302_GetRegPtr(data, FUSB302_REG_MEASURE);
+
+    // Select comparator input, MEASURE register is written by the first compare step
+    switch (input) {
+    case FUSB302_MEASURE_INPUT_VBUS:
+        FUSB302_SetDataBit(data, FUSB302_REG_MEASURE, FUSB302_MEAS_VBUS, 1);
+        break;
+    case FUSB302_MEASURE_INPUT_CC1:
+        FUSB302_SetDataBit(data, FUSB302_REG_MEASURE, FUSB302_MEAS_VBUS, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1, 1);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2, 0);
+        break;
+    case FUSB302_MEASURE_INPUT_CC2:
+        FUSB302_SetDataBit(data, FUSB302_REG_MEASURE, FUSB302_MEAS_VBUS, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1, 0);
+        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2, 1);
+        break;
+    default:
+        return false;
+    }
+
+    bool switchesChanged = *FUSB302_GetRegPtr(data, FUSB302_REG_SWITCHES0) != switches0;
+    if (switchesChanged) {
+        ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+    }
+
+    // Run measurement
+    if (ok) {
+        if (track) {
+            ok &= TrackMdac(platform, data, mdac);
+        } else {
+            ok &= SearchMdac(platform, data, mdac);
+        }
+    }
+
+    // Restore measure setup (a COMP interrupt may be left pending, it is harmless for monitoring)
+    *FUSB302_GetRegPtr(data, FUSB302_REG_MEASURE) = measure;
+    ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_MEASURE);
+
+    if (switchesChanged) {
+        *FUSB302_GetRegPtr(data, FUSB302_REG_SWITCHES0) = switches0;
+        ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+    }
+
+    return ok;
+}
+
+bool FUSB302_MeasureVoltage(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            FUSB302_MeasureInput_t input, int *voltageMv) {
+    int mdac;
+    if (!MeasureMdac(platform, data, input, false, &mdac)) {
+        return false;
+    }
+
+    *voltageMv = MdacToMv(input, mdac);
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Measured input %d = %d mV (MDAC=%d)\r\n", input, *voltageMv,
+                         mdac);
+#endif
+
+    return true;
+}
+
+void FUSB302_SetupMeasureTracking(FUSB302_MeasureTracking_t *tracking,
+                                  FUSB302_MeasureInput_t input) {
+    tracking->input = input;
+    tracking->valid = false;
+    tracking->mdac = -1;
+    tracking->voltageMv = 0;
+}
+
+bool FUSB302_UpdateMeasureTracking(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                   FUSB302_MeasureTracking_t *tracking) {
+    // First measurement is a full search, next ones continue from the previous result
+    int mdac = tracking->mdac;
+    if (!MeasureMdac(platform, data, tracking->input, tracking->valid, &mdac)) {
+        tracking->valid = false;
+        return false;
+    }
+
+    tracking->mdac = mdac;
+    tracking->voltageMv = MdacToMv(tracking->input, mdac);
+    tracking->valid = true;
+
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef FUSB302_MEASURE_H
+#define FUSB302_MEASURE_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Comparator settle time after an MDAC or input change
+#ifndef FUSB302_MEASURE_SETTLE_US
+#define FUSB302_MEASURE_SETTLE_US 250
+#endif
+
+// Maximum number of single MDAC steps in tracking mode before falling back to a full search
+#ifndef FUSB302_MEASURE_TRACK_MAX_STEPS
+#define FUSB302_MEASURE_TRACK_MAX_STEPS 3
+#endif
+
+typedef enum FUSB302_MeasureInput {
+    FUSB302_MEASURE_INPUT_VBUS,
+    FUSB302_MEASURE_INPUT_CC1,
+    FUSB302_MEASURE_INPUT_CC2,
+} FUSB302_MeasureInput_t;
+
+typedef struct FUSB302_MeasureTracking {
+    FUSB302_MeasureInput_t input;
+    bool valid;
+    int mdac; // last MDAC code below the input, -1 if below the lowest threshold
+    int voltageMv;
+} FUSB302_MeasureTracking_t;
+
+bool FUSB302_MeasureVoltage(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            FUSB302_MeasureInput_t input, int *voltageMv);
+
+void FUSB302_SetupMeasureTracking(FUSB302_MeasureTracking_t *tracking,
+                                  FUSB302_MeasureInput_t input);
+bool FUSB302_UpdateMeasureTracking(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                   FUSB302_MeasureTracking_t *tracking);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_MEASURE_H
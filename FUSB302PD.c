@@ -1,24 +1,27 @@
 #include "FUSB302PD.h"
+#include "FUSB302CRC.h"
+#include "FUSB302Pool.h"
 
 #define GET_BITS(val, hi, lo) (((val) >> (lo)) & ((1u << ((hi) - (lo) + 1)) - 1))
 
-// #define FUSB302_DEBUG_1
+// Pool buffer layout for transmission: TX FIFO fill, then packed message
+#define TX_PACKED_OFFSET FUSB302_PD_TX_FIFO_SIZE
 
-static bool ParseDiscoverIdentityReply(const uint8_t *pkt, int pktLen, FUSB302_PDIdentity_t *id) {
-    if (pktLen < 6)
-        return false;
+#if FUSB302_POOL_BUFFER_SIZE < TX_PACKED_OFFSET + FUSB302_PD_MAX_MESSAGE_LEN
+#error "FUSB302_POOL_BUFFER_SIZE too small for TX FIFO fill and packed message"
+#endif
 
-    // --- PD header ---
-    uint16_t header = pkt[0] | (pkt[1] << 8);
-    int numObj = (header >> 12) & 0x7;
+// #define FUSB302_DEBUG_1
 
+bool FUSB302_ParseDiscoverIdentityReply(const FUSB302_PDMessage_t *message,
+                                        FUSB302_PDIdentity_t *id) {
     // Must be at least VDM header + ID Header VDO
-    if (numObj < 2)
+    if (FUSB302_PD_HEADER_TYPE(message->header) != FUSB302_PD_DATA_VENDOR_DEFINED ||
+        FUSB302_PD_HEADER_NUM_OBJECTS(message->header) < 2)
         return false;
 
     // --- VDM header (Obj 0) ---
-    uint32_t vdm =
-        (uint32_t)pkt[2] | (uint32_t)pkt[3] << 8 | (uint32_t)pkt[4] << 16 | (uint32_t)pkt[5] << 24;
+    uint32_t vdm = message->objects[0];
 
     uint16_t svid = GET_BITS(vdm, 31, 16);
     uint8_t cmd = GET_BITS(vdm, 4, 0);
@@ -29,50 +32,211 @@ static bool ParseDiscoverIdentityReply(const uint8_t *pkt, int pktLen, FUSB302_P
         return false;
 
     // --- ID Header VDO (Obj 1) ---
-    uint32_t idh =
-        (uint32_t)pkt[6] | (uint32_t)pkt[7] << 8 | (uint32_t)pkt[8] << 16 | (uint32_t)pkt[9] << 24;
+    uint32_t idh = message->objects[1];
 
-    uint16_t vid = GET_BITS(idh, 31, 16);
+    uint16_t vid = GET_BITS(idh, 15, 0);
+    uint8_t productType = GET_BITS(idh, 29, 27);
 
     id->vid = vid;
-
-    // TODO: parse objects
+    id->productType = productType;
+    id->vbusCurrentMa = 0;
+
+    // --- Cable VDO (Obj 4) of passive and active cables, VBUS current handling ---
+    if ((productType == FUSB302_PD_PRODUCT_TYPE_PASSIVE_CABLE ||
+         productType == FUSB302_PD_PRODUCT_TYPE_ACTIVE_CABLE) &&
+        FUSB302_PD_HEADER_NUM_OBJECTS(message->header) >= 5) {
+        uint8_t vbusCurrent = GET_BITS(message->objects[4], 6, 5);
+        if (vbusCurrent == 1) {
+            id->vbusCurrentMa = 3000;
+        } else if (vbusCurrent == 2) {
+            id->vbusCurrentMa = 5000;
+        }
+    }
 
     return true;
 }
 
-bool FUSB302_SendPacket(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_SOP_t sop,
-                        uint8_t *packedData, int packedDataLen, uint8_t *txBuffer,
-                        int txBufferSize) {
-    uint8_t txLen = 0;
-
-    if (sop == FUSB302_SOP_PRIME) {
-        // SOP' token sequence for cable communication
-        txBuffer[txLen++] = FUSB302_TOKEN_SOP1; // SOP1
-        txBuffer[txLen++] = FUSB302_TOKEN_SOP1; // SOP1
-        txBuffer[txLen++] = FUSB302_TOKEN_SOP3; // SOP3
-        txBuffer[txLen++] = FUSB302_TOKEN_SOP3; // SOP3
-    } else {
-        // TODO: implement
-        return false;
+// Packed message as header bytes followed by a body (payload sent without copying)
+typedef struct TxStream {
+    FUSB302_SOP_t sop;
+    const uint8_t *head;
+    int headLen;
+    const uint8_t *body;
+    int bodyLen;
+} TxStream_t;
+
+static const uint8_t sopTokens[FUSB302_PROTOCOL_NUM_SOP][4] = {
+    // SOP: port partner communication
+    {FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP2},
+    // SOP': cable communication
+    {FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP3, FUSB302_TOKEN_SOP3},
+    // SOP'': far end cable plug communication
+    {FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP3, FUSB302_TOKEN_SOP1, FUSB302_TOKEN_SOP3},
+};
+
+static int GetStreamDataLen(const TxStream_t *stream) {
+    // Packed data plus one PACKSYM per 30 bytes
+    int len = stream->headLen + stream->bodyLen;
+    return len + (len + FUSB302_PD_PACKSYM_MAX_LEN - 1) / FUSB302_PD_PACKSYM_MAX_LEN;
+}
+
+static int GetStreamLen(const TxStream_t *stream) {
+    // SOP tokens, PACKSYM runs, JAM_CRC, EOP, TXOFF
+    return 4 + GetStreamDataLen(stream) + 3;
+}
+
+static uint8_t GetStreamToken(const TxStream_t *stream, int pos) {
+    if (pos < 4) {
+        return sopTokens[stream->sop][pos];
+    }
+    pos -= 4;
+
+    int dataLen = GetStreamDataLen(stream);
+    if (pos >= dataLen) {
+        // JAM_CRC token - hardware will calculate and insert CRC, then EOP and TXOFF (turn off
+        // transmitter after EOP)
+        static const uint8_t tail[3] = {FUSB302_TOKEN_JAM_CRC, FUSB302_TOKEN_EOP,
+                                        FUSB302_TOKEN_TXOFF};
+        return tail[pos - dataLen];
     }
 
-    // PACKSYM token with 2 bytes
+    // PACKSYM runs, all full except the last one
     // PACKSYM encoding: 0x80 | number_of_bytes (N must be 2-30)
-    txBuffer[txLen++] = FUSB302_TOKEN_PACKSYM | packedDataLen;
+    int run = pos / (FUSB302_PD_PACKSYM_MAX_LEN + 1);
+    int offset = pos % (FUSB302_PD_PACKSYM_MAX_LEN + 1);
+    int index = run * FUSB302_PD_PACKSYM_MAX_LEN;
+    if (offset == 0) {
+        int runLen = stream->headLen + stream->bodyLen - index;
+        if (runLen > FUSB302_PD_PACKSYM_MAX_LEN) {
+            runLen = FUSB302_PD_PACKSYM_MAX_LEN;
+        }
+        return FUSB302_TOKEN_PACKSYM | runLen;
+    }
+
+    index += offset - 1;
+    return index < stream->headLen ? stream->head[index] : stream->body[index - stream->headLen];
+}
+
+static void EmitTokens(const TxStream_t *stream, int pos, uint8_t *tokens, int len) {
+    for (int i = 0; i < len; i++) {
+        tokens[i] = GetStreamToken(stream, pos + i);
+    }
+}
+
+// I2C transfer time: device address, register address, restart and address for reads, data
+#define I2C_WRITE_US(len) (((len) + 2) * FUSB302_PD_I2C_BYTE_US)
+#define I2C_READ_US(len) (((len) + 3) * FUSB302_PD_I2C_BYTE_US)
+
+static int GetFIFOFree(uint32_t elapsedUs, int written) {
+    // Tokens drained by the PHY since TX_START
+    int drained = 0;
+    if (elapsedUs > FUSB302_PD_TX_PREAMBLE_US) {
+        drained = (int)((elapsedUs - FUSB302_PD_TX_PREAMBLE_US) / FUSB302_PD_TX_BYTE_US);
+    }
+    if (drained > written) {
+        drained = written;
+    }
+    return FUSB302_PD_TX_FIFO_SIZE - (written - drained);
+}
+
+static bool StreamFIFO(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                       const TxStream_t *stream, uint8_t *tokens) {
+    // Fill TX FIFO and start transmitter with TX_START (a TXON token could land inside a PACKSYM
+    // run that continues in the next refill)
+    int tokensLen = GetStreamLen(stream);
+    int written = FUSB302_PD_TX_FIFO_SIZE;
+    EmitTokens(stream, 0, tokens, written);
+    if (!FUSB302_WriteFIFO(platform, tokens, written)) {
+        return false;
+    }
+
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_START, 1);
+    bool ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL0);
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_START, 0);
+    if (!ok) {
+        return false;
+    }
+
+    // Time since TX_START, counted from delays and transfers
+    uint32_t elapsedUs = 0;
+    int stalls = 0;
+    while (written < tokensLen) {
+        int remaining = tokensLen - written;
+        int wanted = remaining < FUSB302_PD_TX_REFILL_LEN ? remaining : FUSB302_PD_TX_REFILL_LEN;
+
+        // Wait only until the refill fits, the rest of the time goes to the transfers
+        int free = GetFIFOFree(elapsedUs, written);
+        if (free < wanted) {
+            uint32_t waitUs = (uint32_t)(wanted - free) * FUSB302_PD_TX_BYTE_US;
+            if (elapsedUs < FUSB302_PD_TX_PREAMBLE_US) {
+                waitUs += FUSB302_PD_TX_PREAMBLE_US - elapsedUs;
+            }
+            platform->delayUs(waitUs);
+            elapsedUs += waitUs;
+            free = GetFIFOFree(elapsedUs, written);
+        }
+
+        if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS1)) {
+            return false;
+        }
+        elapsedUs += I2C_READ_US(1);
+
+        if (FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_TX_EMPTY)) {
+            // Underrun, message went out truncated (no valid CRC), drop the rest
+            break;
+        }
+        if (FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_TX_FULL)) {
+            // Drained less than estimated (preamble still on the wire or slower bus), the FIFO
+            // is full now
+            if (++stalls > FUSB302_PD_TX_FIFO_SIZE / FUSB302_PD_TX_REFILL_LEN + 1) {
+                break;
+            }
+            elapsedUs = FUSB302_PD_TX_PREAMBLE_US +
+                        (uint32_t)(written - FUSB302_PD_TX_FIFO_SIZE) * FUSB302_PD_TX_BYTE_US;
+            continue;
+        }
+
+        // Everything that fits, bounded by the pool buffer the tokens are generated into
+        int len = free < remaining ? free : remaining;
+        if (len > FUSB302_PD_TX_FIFO_SIZE) {
+            len = FUSB302_PD_TX_FIFO_SIZE;
+        }
+        EmitTokens(stream, written, tokens, len);
+        if (!FUSB302_WriteFIFO(platform, tokens, len)) {
+            return false;
+        }
+        elapsedUs += I2C_WRITE_US(len);
+        written += len;
+        stalls = 0;
+    }
 
-    for (int i = 0; i < packedDataLen; i++) {
-        txBuffer[txLen++] = packedData[i];
+    if (written < tokensLen) {
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: TX FIFO underrun at %d of %d\r\n", written, tokensLen);
+#endif
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 1);
+        ok = FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL0);
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 0);
+#ifdef FUSB302_DEBUG
+        if (!ok) {
+            platform->debugPrint("FUSB302: TX FIFO flush failed\r\n");
+        }
+#endif
+        return false;
     }
 
-    // JAM_CRC token - hardware will calculate and insert CRC
-    txBuffer[txLen++] = FUSB302_TOKEN_JAM_CRC;
+    return true;
+}
 
-    // EOP token
-    txBuffer[txLen++] = FUSB302_TOKEN_EOP;
+static bool SendStream(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                       const TxStream_t *stream, uint8_t *txBuffer) {
+    int txLen = GetStreamLen(stream);
+    if (txLen + 1 > FUSB302_PD_TX_FIFO_SIZE) {
+        // Does not fit the TX FIFO together with TXON, start after first fill
+        return StreamFIFO(platform, data, stream, txBuffer);
+    }
 
-    // TXOFF token - turn off transmitter after EOP
-    txBuffer[txLen++] = FUSB302_TOKEN_TXOFF;
+    EmitTokens(stream, 0, txBuffer, txLen);
 
     // TXON token - start transmitter (MUST be last!)
     // Per datasheet: "It is preferred that the TxFIFO is first written with data
@@ -87,6 +251,125 @@ bool FUSB302_SendPacket(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB
     return true;
 }
 
+bool FUSB302_SendPacket(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_SOP_t sop,
+                        uint8_t *packedData, int packedDataLen, uint8_t *txBuffer,
+                        int txBufferSize) {
+    // Leave room for all tokens and TXON, or one TX FIFO fill when streamed (same bound as
+    // SendStream)
+    int needed = FUSB302_PD_TX_BUFFER_SIZE(packedDataLen);
+    if (needed > FUSB302_PD_TX_FIFO_SIZE) {
+        needed = FUSB302_PD_TX_FIFO_SIZE;
+    }
+    if (sop >= FUSB302_PROTOCOL_NUM_SOP || packedDataLen < 2 ||
+        packedDataLen > FUSB302_PD_MAX_UNCHUNKED_MESSAGE_LEN || needed > txBufferSize) {
+        return false;
+    }
+
+    TxStream_t stream = {sop, packedData, packedDataLen, 0, 0};
+    return SendStream(platform, data, &stream, txBuffer);
+}
+
+uint16_t FUSB302_BuildHeader(FUSB302_SOP_t sop, uint8_t messageType, int numDataObjects,
+                             uint8_t messageId) {
+    uint16_t header = (uint16_t)((numDataObjects & 0x7) << 12) | (uint16_t)((messageId & 0x7) << 9) |
+                      (FUSB302_PD_SPEC_REV << 6) | (messageType & 0x1F);
+
+    // Port power role Source and data role DFP for SOP, cable plug 0 (from DFP/UFP) otherwise
+    if (sop == FUSB302_SOP) {
+        header |= (1 << 8) | (1 << 5);
+    }
+
+    return header;
+}
+
+bool FUSB302_ReadMessage(FUSB302_Platform_t *platform, FUSB302_SOP_t *sop, uint8_t *message,
+                         int messageSize, uint8_t *extendedData, int *messageLen) {
+    // Read SOP token and PD header first to get the message length
+    uint8_t head[3];
+    if (!FUSB302_ReadFIFO(platform, head, sizeof(head))) {
+        return false;
+    }
+
+    switch (head[0] & FUSB302_RXTOKEN_BITMASK) {
+    case FUSB302_RXTOKEN_SOP:
+        *sop = FUSB302_SOP;
+        break;
+    case FUSB302_RXTOKEN_SOP1:
+        *sop = FUSB302_SOP_PRIME;
+        break;
+    case FUSB302_RXTOKEN_SOP2:
+        *sop = FUSB302_SOP_DOUBLE_PRIME;
+        break;
+    case FUSB302_RXTOKEN_SOP1DB:
+    case FUSB302_RXTOKEN_SOP2DB:
+        *sop = FUSB302_SOP_OTHER;
+        break;
+    default:
+        // Not at a packet boundary (FIFO empty or out of sync)
+        return false;
+    }
+
+    uint16_t header = head[1] | (head[2] << 8);
+    int len = 2 + FUSB302_PD_HEADER_NUM_OBJECTS(header) * 4;
+    if (len > messageSize) {
+        return false;
+    }
+
+    message[0] = head[1];
+    message[1] = head[2];
+
+    // Unchunked extended message has no data objects, length is in the extended header. Its data
+    // goes to extendedData (up to FUSB302_PD_MAX_EXTENDED_LEN), without it the data is skipped.
+    if (FUSB302_PD_HEADER_EXTENDED(header) && len == 2) {
+        if (messageSize <= 4 || !FUSB302_ReadFIFO(platform, &message[2], 2)) {
+            return false;
+        }
+
+        int dataSize = FUSB302_PD_EXT_HEADER_DATA_SIZE(message[2] | (message[3] << 8));
+        if (dataSize > FUSB302_PD_MAX_EXTENDED_LEN) {
+            return false;
+        }
+
+        // Read in pieces of the message buffer size (FIFO reads are limited to 255 bytes)
+        for (int offset = 0; offset < dataSize;) {
+            int n = dataSize - offset;
+            if (n > messageSize - 4) {
+                n = messageSize - 4;
+            }
+            uint8_t *dst = extendedData ? &extendedData[offset] : &message[4];
+            if (!FUSB302_ReadFIFO(platform, dst, n)) {
+                return false;
+            }
+            offset += n;
+        }
+
+        uint8_t crc[4];
+        if (!FUSB302_ReadFIFO(platform, crc, sizeof(crc))) {
+            return false;
+        }
+        *messageLen = 4 + dataSize;
+
+        return true;
+    }
+
+    // Read data objects and CRC in one transfer if the CRC fits behind the message, CRC was
+    // checked by the FUSB302
+    if (len + 4 <= messageSize) {
+        if (!FUSB302_ReadFIFO(platform, &message[2], len - 2 + 4)) {
+            return false;
+        }
+    } else {
+        uint8_t crc[4];
+        if (!FUSB302_ReadFIFO(platform, &message[2], len - 2) ||
+            !FUSB302_ReadFIFO(platform, crc, sizeof(crc))) {
+            return false;
+        }
+    }
+    *messageLen = len;
+
+    return true;
+}
+
 bool FUSB302_ReadBuffer(FUSB302_Platform_t *platform, FUSB302_Data_t *data, uint8_t *rxBuffer,
                         int rxBufferSize, int *rxLen) {
     bool ok = true;
@@ -146,12 +429,26 @@ bool FUSB302_ExtractPacket(const uint8_t *rxBuffer, int rxBufferLen, int rxBuffe
 
         // 3. Calculate total message size
         int pdBytes = 2 + numDataObjects * 4 + 4; // header + data objs + CRC
+        if (FUSB302_PD_HEADER_EXTENDED(header) && numDataObjects == 0) {
+            // Unchunked extended message: extended header + data size bytes
+            if (i + 5 > rxBufferLen)
+                return false;
+            uint16_t extHeader = ((uint16_t)rxBuffer[idx + 3] << 8) | (uint16_t)rxBuffer[idx + 2];
+            pdBytes = 4 + FUSB302_PD_EXT_HEADER_DATA_SIZE(extHeader) + 4;
+        }
         int totalBytes = 1 + pdBytes;             // + SOP token
 
         // 4. Check if buffer contains full packet
         if (i + totalBytes > rxBufferLen)
             return false;
 
+#if FUSB302_PD_VERIFY_CRC
+        // 5. Check CRC, continue the search behind the SOP token of a corrupt packet
+        if (!FUSB302_VerifyPacketCRC(&rxBuffer[idx], pdBytes)) {
+            continue;
+        }
+#endif
+
         *packetStart = i + 1; // Skip SOP token
         *packetLen = totalBytes - 1;
         return true;
@@ -160,44 +457,361 @@ bool FUSB302_ExtractPacket(const uint8_t *rxBuffer, int rxBufferLen, int rxBuffe
     return false;
 }
 
-bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
-                                       FUSB302_CC_Orientation_t ccOrientation, bool checkOnly,
-                                       bool *emarkerPresent, FUSB302_PDIdentity_t *identity) {
-    bool ok = true;
+void FUSB302_ProtocolSoftReset(FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop) {
+    if (sop < FUSB302_PROTOCOL_NUM_SOP) {
+        protocol->txMessageId[sop] = 0;
+        protocol->rxMessageId[sop] = -1;
+    }
+}
 
-    // Flush TX FIFO before sending
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 1);
-    ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL0);
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_TX_FLUSH, 0);
+void FUSB302_ProtocolHardReset(FUSB302_Protocol_t *protocol) {
+    for (int sop = 0; sop < FUSB302_PROTOCOL_NUM_SOP; sop++) {
+        FUSB302_ProtocolSoftReset(protocol, (FUSB302_SOP_t)sop);
+    }
+    protocol->specRevision = FUSB302_PD_SPEC_REV;
+}
 
-    // Flush RX FIFO
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 1);
-    ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL1);
-    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 0);
+void FUSB302_ProtocolCableReset(FUSB302_Protocol_t *protocol) {
+    FUSB302_ProtocolSoftReset(protocol, FUSB302_SOP_PRIME);
+    FUSB302_ProtocolSoftReset(protocol, FUSB302_SOP_DOUBLE_PRIME);
+}
 
-    // Read interrupt register to clear any pending interrupts
-    ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_INTERRUPT);
+bool FUSB302_ProtocolSend(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                          FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop, uint8_t messageType,
+                          const uint32_t *objects, int numObjects) {
+    if (sop >= FUSB302_PROTOCOL_NUM_SOP || numObjects > FUSB302_PD_MAX_DATA_OBJECTS) {
+        return false;
+    }
+
+    uint8_t *buffer = FUSB302_AcquireBuffer(platform);
+    if (!buffer) {
+        return false;
+    }
 
-    // Build packet
-    uint8_t packedData[6];
+    uint8_t *packedData = &buffer[TX_PACKED_OFFSET];
     int packedDataLen = 0;
 
-    /*
-     * PD Header (16-bit, little-endian)
-     *
-     * Message Type   = 0xF (Vendor Defined)
-     * Num Data Obj   = 1
-     * Power Role     = Source (1)
-     * Data Role      = DFP (1)
-     * Spec Revision  = 2.0 (01b)
-     *
-     * Header = 0x12EF → bytes EF 12
-     */
-    packedData[packedDataLen++] = 0xEF; // PD Header LSB
-    packedData[packedDataLen++] = 0x12; // PD Header MSB
+    uint16_t header =
+        FUSB302_BuildHeader(sop, messageType, numObjects, protocol->txMessageId[sop]);
+    if (sop == FUSB302_SOP) {
+        header = (header & ~(0x3 << 6)) | (protocol->specRevision << 6);
+    }
+    packedData[packedDataLen++] = header & 0xFF;
+    packedData[packedDataLen++] = header >> 8;
+
+    for (int i = 0; i < numObjects; i++) {
+        packedData[packedDataLen++] = objects[i] & 0xFF;
+        packedData[packedDataLen++] = (objects[i] >> 8) & 0xFF;
+        packedData[packedDataLen++] = (objects[i] >> 16) & 0xFF;
+        packedData[packedDataLen++] = objects[i] >> 24;
+    }
+
+    // Hardware retries with the same MessageID (AUTO_RETRY), counter advances on success and
+    // failure alike
+    protocol->txMessageId[sop] = (protocol->txMessageId[sop] + 1) & 0x7;
+
+    bool ok = FUSB302_SendPacket(platform, data, sop, packedData, packedDataLen, buffer,
+                                 TX_PACKED_OFFSET);
+    FUSB302_ReleaseBuffer(platform, buffer);
+
+    return ok;
+}
+
+static uint16_t BuildExtendedHeader(FUSB302_SOP_t sop, uint8_t messageType, int numDataObjects,
+                                    uint8_t messageId) {
+    // Extended messages exist from PD 3.0 on
+    uint16_t header = FUSB302_BuildHeader(sop, messageType, numDataObjects, messageId);
+    return (header & ~(0x3 << 6)) | (FUSB302_PD_SPEC_REV_3_0 << 6) | (1u << 15);
+}
+
+bool FUSB302_ProtocolSendExtended(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop,
+                                  uint8_t messageType, const uint8_t *payload, int dataSize,
+                                  bool chunked, int chunkNumber) {
+    if (sop >= FUSB302_PROTOCOL_NUM_SOP || dataSize < 0 || dataSize > FUSB302_PD_MAX_EXTENDED_LEN) {
+        return false;
+    }
+
+    // Chunk data or whole data
+    int offset = 0, len = dataSize;
+    if (chunked) {
+        offset = chunkNumber * FUSB302_PD_MAX_CHUNK_LEN;
+        if (chunkNumber < 0 || (offset >= dataSize && chunkNumber > 0)) {
+            return false;
+        }
+        len = dataSize - offset;
+        if (len > FUSB302_PD_MAX_CHUNK_LEN) {
+            len = FUSB302_PD_MAX_CHUNK_LEN;
+        }
+    }
+
+    uint8_t *buffer = FUSB302_AcquireBuffer(platform);
+    if (!buffer) {
+        return false;
+    }
+
+    // Chunks are copied behind the headers and padded to whole data objects, unchunked messages
+    // have none and are streamed straight from the payload
+    uint8_t *packedData = &buffer[TX_PACKED_OFFSET];
+    int packedDataLen = 4;
+    int numObjects = 0;
+    if (chunked) {
+        for (int i = 0; i < len; i++) {
+            packedData[packedDataLen++] = payload[offset + i];
+        }
+        numObjects = (packedDataLen - 2 + 3) / 4;
+        while (packedDataLen < 2 + numObjects * 4) {
+            packedData[packedDataLen++] = 0;
+        }
+    }
+
+    uint16_t header =
+        BuildExtendedHeader(sop, messageType, numObjects, protocol->txMessageId[sop]);
+    uint16_t extHeader = (uint16_t)(((chunked ? 1u : 0u) << 15) | ((chunkNumber & 0xF) << 11) |
+                                    (dataSize & 0x1FF));
+
+    packedData[0] = header & 0xFF;
+    packedData[1] = header >> 8;
+    packedData[2] = extHeader & 0xFF;
+    packedData[3] = extHeader >> 8;
+
+    protocol->txMessageId[sop] = (protocol->txMessageId[sop] + 1) & 0x7;
+
+    TxStream_t stream = {sop, packedData, packedDataLen, chunked ? 0 : payload,
+                         chunked ? 0 : len};
+    bool ok = SendStream(platform, data, &stream, buffer);
+    FUSB302_ReleaseBuffer(platform, buffer);
+
+    return ok;
+}
+
+static uint8_t GetMessageByte(const FUSB302_PDMessage_t *message, int index) {
+    // Data object bytes after the PD header, little-endian
+    return (message->objects[index / 4] >> ((index % 4) * 8)) & 0xFF;
+}
+
+static uint16_t GetExtendedHeader(const FUSB302_PDMessage_t *message) {
+    return message->objects[0] & 0xFFFF;
+}
+
+bool FUSB302_GetChunkRequest(const FUSB302_PDMessage_t *message, int *chunkNumber) {
+    if (!FUSB302_PD_HEADER_EXTENDED(message->header) ||
+        FUSB302_PD_HEADER_NUM_OBJECTS(message->header) < 1) {
+        return false;
+    }
+
+    uint16_t extHeader = GetExtendedHeader(message);
+    if (!FUSB302_PD_EXT_HEADER_CHUNKED(extHeader) ||
+        !FUSB302_PD_EXT_HEADER_REQUEST_CHUNK(extHeader)) {
+        return false;
+    }
+
+    *chunkNumber = FUSB302_PD_EXT_HEADER_CHUNK_NUMBER(extHeader);
+    return true;
+}
+
+bool FUSB302_ProtocolSendChunkRequest(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                      FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop,
+                                      uint8_t messageType, int chunkNumber) {
+    if (sop >= FUSB302_PROTOCOL_NUM_SOP || chunkNumber < 0 || chunkNumber > 0xF) {
+        return false;
+    }
+
+    uint8_t *buffer = FUSB302_AcquireBuffer(platform);
+    if (!buffer) {
+        return false;
+    }
+
+    // Chunk Request: extended header only (Data Size 0), padded to one data object
+    uint8_t *packedData = &buffer[TX_PACKED_OFFSET];
+    uint16_t header = BuildExtendedHeader(sop, messageType, 1, protocol->txMessageId[sop]);
+    uint16_t extHeader = (uint16_t)((1u << 15) | ((chunkNumber & 0xF) << 11) | (1u << 10));
+
+    packedData[0] = header & 0xFF;
+    packedData[1] = header >> 8;
+    packedData[2] = extHeader & 0xFF;
+    packedData[3] = extHeader >> 8;
+    packedData[4] = 0;
+    packedData[5] = 0;
+
+    protocol->txMessageId[sop] = (protocol->txMessageId[sop] + 1) & 0x7;
+
+    bool ok = FUSB302_SendPacket(platform, data, sop, packedData, 6, buffer, TX_PACKED_OFFSET);
+    FUSB302_ReleaseBuffer(platform, buffer);
+
+    return ok;
+}
+
+bool FUSB302_ProtocolReceiveExtended(FUSB302_Protocol_t *protocol,
+                                     const FUSB302_PDMessage_t *message,
+                                     FUSB302_ExtendedMessage_t *extended, bool *complete,
+                                     int *nextChunk) {
+    *complete = false;
+    *nextChunk = -1;
+
+    int numObjects = FUSB302_PD_HEADER_NUM_OBJECTS(message->header);
+    if (!FUSB302_PD_HEADER_EXTENDED(message->header)) {
+        return false;
+    }
+
+    // Unchunked message, its data was kept by FUSB302_ProtocolReceive
+    if (numObjects == 0) {
+        const FUSB302_ExtendedMessage_t *unchunked = protocol->unchunked;
+        if (!unchunked || unchunked->sop != message->sop ||
+            unchunked->messageType != FUSB302_PD_HEADER_TYPE(message->header) ||
+            unchunked->dataSize != FUSB302_PD_EXT_HEADER_DATA_SIZE(GetExtendedHeader(message))) {
+            return false;
+        }
+        if (extended != unchunked) {
+            *extended = *unchunked;
+        }
+        *complete = true;
+        return true;
+    }
+
+    uint16_t extHeader = GetExtendedHeader(message);
+    int dataSize = FUSB302_PD_EXT_HEADER_DATA_SIZE(extHeader);
+    int chunkNumber = FUSB302_PD_EXT_HEADER_CHUNK_NUMBER(extHeader);
+    uint8_t type = FUSB302_PD_HEADER_TYPE(message->header);
+    if (!FUSB302_PD_EXT_HEADER_CHUNKED(extHeader) ||
+        FUSB302_PD_EXT_HEADER_REQUEST_CHUNK(extHeader) || dataSize > FUSB302_PD_MAX_EXTENDED_LEN) {
+        return false;
+    }
+
+    if (chunkNumber == 0) {
+        // First chunk starts a new message
+        extended->sop = message->sop;
+        extended->messageType = type;
+        extended->dataSize = dataSize;
+        extended->received = 0;
+    } else if (extended->sop != message->sop || extended->messageType != type ||
+               extended->dataSize != dataSize ||
+               extended->received != chunkNumber * FUSB302_PD_MAX_CHUNK_LEN) {
+        // Not the chunk we asked for
+        return false;
+    }
+
+    int len = extended->dataSize - extended->received;
+    if (len > FUSB302_PD_MAX_CHUNK_LEN) {
+        len = FUSB302_PD_MAX_CHUNK_LEN;
+    }
+    if (len > numObjects * 4 - 2) {
+        return false;
+    }
+
+    for (int i = 0; i < len; i++) {
+        extended->data[extended->received + i] = GetMessageByte(message, 2 + i);
+    }
+    extended->received += len;
+
+    if (extended->received >= extended->dataSize) {
+        *complete = true;
+        return true;
+    }
+
+    *nextChunk = chunkNumber + 1;
+    return true;
+}
+
+bool FUSB302_ProtocolReceive(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_Protocol_t *protocol, FUSB302_PDMessage_t *message,
+                             bool *received) {
+    bool ok = true;
+
+    *received = false;
+
+    if (FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_RX_EMPTY)) {
+        return ok;
+    }
+
+    uint8_t *buffer = FUSB302_AcquireBuffer(platform);
+    if (!buffer) {
+        return false;
+    }
+
+    while (ok && !FUSB302_GetDataBit(data, FUSB302_REG_STATUS1, FUSB302_RX_EMPTY)) {
+        int len = 0;
+        FUSB302_ExtendedMessage_t *target = protocol->unchunked;
+        bool valid = FUSB302_ReadMessage(platform, &message->sop, buffer, FUSB302_POOL_BUFFER_SIZE,
+                                         target ? target->data : 0, &len);
+        ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS1);
+
+        if (!valid) {
+            // Lost packet boundary, drop the rest
+            FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 1);
+            ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL1);
+            FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 0);
+            break;
+        }
+
+        message->header = buffer[0] | (buffer[1] << 8);
+        int numObjects = FUSB302_PD_HEADER_NUM_OBJECTS(message->header);
+        uint8_t type = FUSB302_PD_HEADER_TYPE(message->header);
+        bool extended = FUSB302_PD_HEADER_EXTENDED(message->header);
+        bool unchunked = extended && numObjects == 0;
+        if (unchunked) {
+            message->objects[0] = buffer[2] | (buffer[3] << 8);
+        }
+        for (int i = 0; i < numObjects; i++) {
+            const uint8_t *obj = &buffer[2 + i * 4];
+            message->objects[i] = (uint32_t)obj[0] | (uint32_t)obj[1] << 8 |
+                                  (uint32_t)obj[2] << 16 | (uint32_t)obj[3] << 24;
+        }
+
+        // GoodCRC acknowledges our own transmissions (sent and checked by hardware)
+        if (message->sop >= FUSB302_PROTOCOL_NUM_SOP ||
+            (!extended && numObjects == 0 && type == FUSB302_PD_CTRL_GOODCRC)) {
+            continue;
+        }
+
+        // Soft_Reset restarts MessageID sequence of its SOP type
+        int messageId = FUSB302_PD_HEADER_MESSAGE_ID(message->header);
+        if (!extended && numObjects == 0 && type == FUSB302_PD_CTRL_SOFT_RESET) {
+            FUSB302_ProtocolSoftReset(protocol, message->sop);
+        } else if (protocol->rxMessageId[message->sop] == messageId) {
+            // Retransmission (our GoodCRC was lost), already handled
+            protocol->duplicates++;
+            continue;
+        }
+        protocol->rxMessageId[message->sop] = messageId;
+
+        // Both ends use the lower revision
+        uint8_t specRevision = FUSB302_PD_HEADER_SPEC_REV(message->header);
+        if (message->sop == FUSB302_SOP && specRevision < protocol->specRevision) {
+            protocol->specRevision = specRevision;
+        }
+
+        // Unchunked data was read to protocol->unchunked, the message only holds the extended header
+        if (unchunked && target) {
+            target->sop = message->sop;
+            target->messageType = type;
+            target->dataSize = len - 4;
+            target->received = len - 4;
+        }
+
+        *received = true;
+        break;
+    }
+
+    FUSB302_ReleaseBuffer(platform, buffer);
+
+    return ok;
+}
+
+bool FUSB302_ProtocolCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                           FUSB302_Protocol_t *protocol,
+                                           FUSB302_CC_Orientation_t ccOrientation, bool checkOnly,
+                                           bool *emarkerPresent, FUSB302_PDIdentity_t *identity) {
+    bool ok = true;
+
+    // Flush TX and RX FIFO before sending
+    ok &= FUSB302_FlushFIFO(platform, data);
+
+    // Read interrupt register to clear any pending interrupts
+    ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_INTERRUPT);
 
     /*
-     * VDM Header (32-bit, little-endian)
+     * VDM Header (32-bit)
      *
      * SVID           = 0xFF00 (PD SID)
      * VDM Type       = Structured (1)
@@ -205,18 +819,12 @@ bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Dat
      * Obj Position   = 0
      * Command Type   = Initiator (0)
      * Command        = Discover Identity (1)
-     *
-     * VDM = 0xFF008001 → bytes 01 80 00 FF
      */
-    packedData[packedDataLen++] = 0x01; // Command = Discover Identity
-    packedData[packedDataLen++] = 0x80; // Structured VDM, ver=1
-    packedData[packedDataLen++] = 0x00; // SVID LSB
-    packedData[packedDataLen++] = 0xFF; // SVID MSB
+    uint32_t vdm = 0xFF008001;
 
-    // Send discovery identity packet
-    uint8_t txBuffer[16];
-    ok &= FUSB302_SendPacket(platform, data, FUSB302_SOP_PRIME, packedData, packedDataLen, txBuffer,
-                             sizeof(txBuffer));
+    // Send discovery identity packet (PD header with MessageID from protocol layer)
+    ok &= FUSB302_ProtocolSend(platform, data, protocol, FUSB302_SOP_PRIME,
+                               FUSB302_PD_DATA_VENDOR_DEFINED, &vdm, 1);
 
 #ifdef FUSB302_DEBUG_1
     platform->debugPrint("FUSB302: EMarker Discover Identity sent (SOP')\r\n");
@@ -225,9 +833,8 @@ bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Dat
     // Wait for cable response
     // tTransmit max is 195us, cable should respond within tReceive (0.9-1.1ms)
     bool responseReceived = false;
-    uint8_t rxBuffer[80]; // Max FIFO size
 
-    for (int retry = 0; retry < 20; retry++) {
+    for (int retry = 0; retry < 20 && !responseReceived; retry++) {
         platform->delayUs(500); // 10ms total max
 
         ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_INTERRUPT);
@@ -245,54 +852,40 @@ bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Dat
 
             if (!rxEmpty) {
                 if (checkOnly) {
-                    // Flush RX FIFO
+                    // Flush RX FIFO, MessageID of flushed replies is unknown
                     FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 1);
                     ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL1);
                     FUSB302_SetDataBit(data, FUSB302_REG_CONTROL1, FUSB302_RX_FLUSH, 0);
+                    protocol->rxMessageId[FUSB302_SOP_PRIME] = -1;
 
                     if (rxSop1) {
                         responseReceived = true;
-                        break;
                     }
                 } else {
-                    // Read buffer
-                    int rxLen = 0;
-                    ok &= FUSB302_ReadBuffer(platform, data, rxBuffer, sizeof(rxBuffer), &rxLen);
-
-                    if (rxLen == 0) {
-                        continue;
-                    }
-
-                    // Extract packets
-                    int rxStart = 0;
-                    while (rxStart < rxLen) {
-                        int packetStart = rxStart, packetLen = 0;
-                        FUSB302_SOP_t packetSop;
-                        if (!FUSB302_ExtractPacket(rxBuffer, rxLen, rxStart, &packetStart,
-                                                   &packetLen, &packetSop)) {
-                            break;
-                        }
+                    // Read new messages until identity reply
+                    FUSB302_PDMessage_t message;
+                    bool received = true;
+                    while (ok && received && !responseReceived) {
+                        ok &= FUSB302_ProtocolReceive(platform, data, protocol, &message,
+                                                      &received);
 
 #ifdef FUSB302_DEBUG_1
-                        platform->debugPrint("Packet received: SOP=%d, start=%d, LEN=%d\r\n",
-                                             packetSop, packetStart, packetLen);
+                        if (received) {
+                            platform->debugPrint("Packet received: SOP=%d, header=%04X\r\n",
+                                                 message.sop, message.header);
+                        }
 #endif
 
                         // Try to parse identity reply
-                        if (packetSop == FUSB302_SOP_PRIME) {
-                            if (ParseDiscoverIdentityReply(&rxBuffer[packetStart], packetLen,
-                                                           identity)) {
+                        if (received && message.sop == FUSB302_SOP_PRIME &&
+                            FUSB302_ParseDiscoverIdentityReply(&message, identity)) {
 #ifdef FUSB302_DEBUG
-                                platform->debugPrint("FUSB302: Identity reply VID=%04X\r\n",
-                                                     identity->vid);
+                            platform->debugPrint("FUSB302: Identity reply VID=%04X\r\n",
+                                                 identity->vid);
 #endif
 
-                                responseReceived = true;
-                                break;
-                            }
+                            responseReceived = true;
                         }
-
-                        rxStart = packetStart + packetLen;
                     }
                 }
             }
@@ -309,3 +902,15 @@ bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Dat
 
     return ok;
 }
+
+bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                       FUSB302_CC_Orientation_t ccOrientation, bool checkOnly,
+                                       bool *emarkerPresent, FUSB302_PDIdentity_t *identity) {
+    FUSB302_Protocol_t protocol;
+    FUSB302_ProtocolHardReset(&protocol);
+    protocol.duplicates = 0;
+    protocol.unchunked = 0;
+
+    return FUSB302_ProtocolCableDiscoverIdentity(platform, data, &protocol, ccOrientation,
+                                                 checkOnly, emarkerPresent, identity);
+}
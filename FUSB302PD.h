@@ -5,6 +5,10 @@
 #include <stdbool.h>
 #include "FUSB302.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum FUSB302_SOP {
     FUSB302_SOP,
     FUSB302_SOP_PRIME,
@@ -12,20 +16,197 @@ typedef enum FUSB302_SOP {
     FUSB302_SOP_OTHER,
 } FUSB302_SOP_t;
 
+// ID Header VDO product type (UFP / cable plug)
+#define FUSB302_PD_PRODUCT_TYPE_UNDEFINED 0x0
+#define FUSB302_PD_PRODUCT_TYPE_PASSIVE_CABLE 0x3
+#define FUSB302_PD_PRODUCT_TYPE_ACTIVE_CABLE 0x4
+
+// PD header: specification revision (matches SWITCHES1 SPECREV used for GoodCRC)
+#define FUSB302_PD_SPEC_REV_2_0 0x1
+#define FUSB302_PD_SPEC_REV_3_0 0x2 // extended messages
+
+// Revision sent in SOP headers until the port partner answers with a lower one (3.0 requires the
+// application to handle PD 3.0 messages, it enables SinkTxNG collision avoidance)
+#ifndef FUSB302_PD_SPEC_REV
+#define FUSB302_PD_SPEC_REV FUSB302_PD_SPEC_REV_2_0
+#endif
+
+#define FUSB302_PD_HEADER_TYPE(header) ((header) & 0x1F)
+#define FUSB302_PD_HEADER_MESSAGE_ID(header) (((header) >> 9) & 0x7)
+#define FUSB302_PD_HEADER_SPEC_REV(header) (((header) >> 6) & 0x3)
+#define FUSB302_PD_HEADER_NUM_OBJECTS(header) (((header) >> 12) & 0x7)
+#define FUSB302_PD_HEADER_EXTENDED(header) (((header) >> 15) & 0x1)
+
+// Extended message header (first two bytes after the PD header)
+#define FUSB302_PD_EXT_HEADER_DATA_SIZE(extHeader) ((extHeader) & 0x1FF)
+#define FUSB302_PD_EXT_HEADER_REQUEST_CHUNK(extHeader) (((extHeader) >> 10) & 0x1)
+#define FUSB302_PD_EXT_HEADER_CHUNK_NUMBER(extHeader) (((extHeader) >> 11) & 0xF)
+#define FUSB302_PD_EXT_HEADER_CHUNKED(extHeader) (((extHeader) >> 15) & 0x1)
+
+// Control message types (no data objects)
+#define FUSB302_PD_CTRL_GOODCRC 0x01
+#define FUSB302_PD_CTRL_ACCEPT 0x03
+#define FUSB302_PD_CTRL_REJECT 0x04
+#define FUSB302_PD_CTRL_PS_RDY 0x06
+#define FUSB302_PD_CTRL_GET_SOURCE_CAP 0x07
+#define FUSB302_PD_CTRL_GET_SINK_CAP 0x08
+#define FUSB302_PD_CTRL_SOFT_RESET 0x0D
+#define FUSB302_PD_CTRL_NOT_SUPPORTED 0x10 // PD 3.0, Reject before
+
+// Data message types
+#define FUSB302_PD_DATA_SOURCE_CAPABILITIES 0x01
+#define FUSB302_PD_DATA_REQUEST 0x02
+#define FUSB302_PD_DATA_VENDOR_DEFINED 0x0F
+
+// Extended message types
+#define FUSB302_PD_EXT_SOURCE_CAPABILITIES_EXTENDED 0x01
+#define FUSB302_PD_EXT_STATUS 0x02
+#define FUSB302_PD_EXT_FIRMWARE_UPDATE_REQUEST 0x0A
+#define FUSB302_PD_EXT_FIRMWARE_UPDATE_RESPONSE 0x0B
+
+// Message size without CRC: header + data objects
+#define FUSB302_PD_MAX_DATA_OBJECTS 7
+#define FUSB302_PD_MAX_MESSAGE_LEN (2 + FUSB302_PD_MAX_DATA_OBJECTS * 4)
+
+// Extended message data: up to 260 bytes, sent in chunks of 26 bytes (header + extended header +
+// chunk fills 7 data objects) or in one unchunked message
+#define FUSB302_PD_MAX_EXTENDED_LEN 260
+#define FUSB302_PD_MAX_CHUNK_LEN 26
+#define FUSB302_PD_MAX_UNCHUNKED_MESSAGE_LEN (4 + FUSB302_PD_MAX_EXTENDED_LEN)
+
+// TX FIFO tokens around the packed data: 4 x SYNC, PACKSYM, JAM_CRC, EOP, TXOFF, TXON
+#define FUSB302_PD_TX_OVERHEAD 9
+
+// Longer messages are packed into several PACKSYM runs
+#define FUSB302_PD_PACKSYM_MAX_LEN 30
+#define FUSB302_PD_TX_BUFFER_SIZE(packedDataLen)                                                   \
+    ((packedDataLen) + FUSB302_PD_TX_OVERHEAD + ((packedDataLen) - 1) / FUSB302_PD_PACKSYM_MAX_LEN)
+
+// Token streams longer than the TX FIFO are refilled while the PHY is sending. The FIFO level is
+// not readable: it is estimated from the time spent in delays and I2C transfers since TX_START,
+// the PHY drains one token per data byte time (two 4b5b symbols, 33.3 us at 300 kbps) after the
+// preamble. Refills are sized from the estimated free space, at least FUSB302_PD_TX_REFILL_LEN.
+#define FUSB302_PD_TX_FIFO_SIZE 48
+#ifndef FUSB302_PD_TX_REFILL_LEN
+#define FUSB302_PD_TX_REFILL_LEN 16
+#endif
+#define FUSB302_PD_TX_BYTE_US 34
+#define FUSB302_PD_TX_PREAMBLE_US 214 // 64 bits
+
+// Time of one I2C byte (9 clocks) at the bus clock of the port, rounded down (22 us at 400 kHz).
+// Too high a value overfills the FIFO, too low a value lets it underrun.
+#ifndef FUSB302_PD_I2C_BYTE_US
+#define FUSB302_PD_I2C_BYTE_US 22
+#endif
+
+// FUSB302_ExtractPacket skips packets with a bad CRC (captures and models, live traffic is checked
+// by the FUSB302)
+#ifndef FUSB302_PD_VERIFY_CRC
+#define FUSB302_PD_VERIFY_CRC 0
+#endif
+
+typedef struct FUSB302_PDMessage {
+    FUSB302_SOP_t sop;
+    uint16_t header;
+    uint32_t objects[FUSB302_PD_MAX_DATA_OBJECTS];
+} FUSB302_PDMessage_t;
+
+// Extended message reassembled from chunks (or received unchunked)
+typedef struct FUSB302_ExtendedMessage {
+    FUSB302_SOP_t sop;
+    uint8_t messageType;
+    uint16_t dataSize;
+    uint16_t received; // bytes reassembled so far
+    uint8_t data[FUSB302_PD_MAX_EXTENDED_LEN];
+} FUSB302_ExtendedMessage_t;
+
+// Protocol layer MessageID state per SOP type (SOP, SOP', SOP'')
+#define FUSB302_PROTOCOL_NUM_SOP 3
+
+typedef struct FUSB302_Protocol {
+    uint8_t txMessageId[FUSB302_PROTOCOL_NUM_SOP];
+    int8_t rxMessageId[FUSB302_PROTOCOL_NUM_SOP]; // last received MessageID, -1: none
+    uint8_t specRevision;                         // negotiated SOP revision, until hard reset
+    uint32_t duplicates;                          // dropped retransmissions
+    FUSB302_ExtendedMessage_t *unchunked;         // optional, unchunked extended data (0: dropped)
+} FUSB302_Protocol_t;
+
 typedef struct FUSB302_PDIdentity {
     uint16_t vid;
+    uint8_t productType;
+    uint16_t vbusCurrentMa; // cable VBUS current (Cable VDO), 0: unknown or no cable
 } FUSB302_PDIdentity_t;
 
+// txBuffer needs FUSB302_PD_TX_BUFFER_SIZE(packedDataLen) bytes, at most FUSB302_PD_TX_FIFO_SIZE
+// (longer token streams are generated while the FIFO is refilled)
 bool FUSB302_SendPacket(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_SOP_t sop,
                         uint8_t *packedData, int packedDataLen, uint8_t *txBuffer,
                         int txBufferSize);
 
+uint16_t FUSB302_BuildHeader(FUSB302_SOP_t sop, uint8_t messageType, int numDataObjects,
+                             uint8_t messageId);
+// Read one message from the RX FIFO. Unchunked extended data goes to extendedData (optional,
+// FUSB302_PD_MAX_EXTENDED_LEN bytes), message holds its headers.
+bool FUSB302_ReadMessage(FUSB302_Platform_t *platform, FUSB302_SOP_t *sop, uint8_t *message,
+                         int messageSize, uint8_t *extendedData, int *messageLen);
+
 bool FUSB302_ReadBuffer(FUSB302_Platform_t *platform, FUSB302_Data_t *data, uint8_t *rxBuffer,
                         int rxBufferSize, int *rxLen);
 bool FUSB302_ExtractPacket(const uint8_t *rxBuffer, int rxBufferLen, int rxBufferStart,
                            int *packetStart, int *packetLen, FUSB302_SOP_t *packetSop);
 
+// Protocol resets: Soft_Reset (one SOP type), Hard Reset (all) and Cable Reset (SOP' and SOP'')
+void FUSB302_ProtocolSoftReset(FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop);
+void FUSB302_ProtocolHardReset(FUSB302_Protocol_t *protocol);
+void FUSB302_ProtocolCableReset(FUSB302_Protocol_t *protocol);
+
+bool FUSB302_ProtocolSend(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                          FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop, uint8_t messageType,
+                          const uint32_t *objects, int numObjects);
+// Send one chunk (chunked) or the whole data (unchunked, streamed through the TX FIFO) of an
+// extended message. Ports with a Tx scheduler queue it instead (FUSB302_QueueExtendedMessage).
+bool FUSB302_ProtocolSendExtended(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop,
+                                  uint8_t messageType, const uint8_t *payload, int dataSize,
+                                  bool chunked, int chunkNumber);
+// Request chunk chunkNumber of a chunked message from its sender (FUSB302_QueueChunkRequest)
+bool FUSB302_ProtocolSendChunkRequest(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                      FUSB302_Protocol_t *protocol, FUSB302_SOP_t sop,
+                                      uint8_t messageType, int chunkNumber);
+// Chunk Request from the receiver of a chunked message, answer with FUSB302_QueueExtendedMessage
+bool FUSB302_GetChunkRequest(const FUSB302_PDMessage_t *message, int *chunkNumber);
+// Add received extended message chunk. Complete when all dataSize bytes are in the reassembly
+// buffer, at once for unchunked messages (data in protocol->unchunked); otherwise nextChunk is
+// the chunk to request from the sender (FUSB302_QueueChunkRequest), -1 on errors. Chunk Requests
+// of our own chunked messages are answered by the caller, which also times out
+// tChunkSenderRequest (24..30 ms).
+bool FUSB302_ProtocolReceiveExtended(FUSB302_Protocol_t *protocol,
+                                     const FUSB302_PDMessage_t *message,
+                                     FUSB302_ExtendedMessage_t *extended, bool *complete,
+                                     int *nextChunk);
+// Receive next new message (GoodCRC and retransmitted duplicates are dropped). Uses STATUS1 from
+// the last status read to skip FIFO access while RX is empty. Unchunked extended messages have
+// the extended header in objects[0] and their data in protocol->unchunked.
+bool FUSB302_ProtocolReceive(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_Protocol_t *protocol, FUSB302_PDMessage_t *message,
+                             bool *received);
+
+// Discover Identity ACK (PD SID) from SOP* to identity
+bool FUSB302_ParseDiscoverIdentityReply(const FUSB302_PDMessage_t *message,
+                                        FUSB302_PDIdentity_t *id);
+
+// Blocking SOP' Discover Identity (up to 10 ms), MessageID from the port's protocol state
+bool FUSB302_ProtocolCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                           FUSB302_Protocol_t *protocol,
+                                           FUSB302_CC_Orientation_t ccOrientation, bool checkOnly,
+                                           bool *emarkerPresent, FUSB302_PDIdentity_t *identity);
+// Same without protocol state, every call starts with MessageID 0
 bool FUSB302_HostCableDiscoverIdentity(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                                        FUSB302_CC_Orientation_t ccOrientation, bool checkOnly,
                                        bool *emarkerPresent, FUSB302_PDIdentity_t *identity);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // FUSB302_PD_H
@@ -0,0 +1,63 @@
+#include "FUSB302Pool.h"
+
+static int CountBits(uint32_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+void FUSB302_SetupBufferPool(FUSB302_BufferPool_t *pool) {
+    atomic_store(&pool->used, 0);
+    atomic_store(&pool->peak, 0);
+    atomic_store(&pool->failures, 0);
+}
+
+uint8_t *FUSB302_AcquireBuffer(FUSB302_Platform_t *platform) {
+    FUSB302_BufferPool_t *pool = platform->bufferPool;
+    if (!pool) {
+        return 0;
+    }
+
+    const uint32_t all = FUSB302_POOL_BUFFERS == 32 ? 0xFFFFFFFFu
+                                                    : (1u << FUSB302_POOL_BUFFERS) - 1;
+
+    // Claim lowest free bit
+    uint32_t used = atomic_load(&pool->used);
+    uint32_t bit;
+    do {
+        uint32_t free = ~used & all;
+        if (!free) {
+            atomic_fetch_add(&pool->failures, 1);
+            return 0;
+        }
+        bit = free & -free;
+    } while (!atomic_compare_exchange_weak(&pool->used, &used, used | bit));
+
+    // Track peak usage
+    uint32_t count = CountBits(used | bit);
+    uint32_t peak = atomic_load(&pool->peak);
+    while (count > peak && !atomic_compare_exchange_weak(&pool->peak, &peak, count)) {
+    }
+
+    return pool->buffers[CountBits(bit - 1)];
+}
+
+void FUSB302_ReleaseBuffer(FUSB302_Platform_t *platform, uint8_t *buffer) {
+    FUSB302_BufferPool_t *pool = platform->bufferPool;
+    if (!pool || !buffer) {
+        return;
+    }
+
+    int index = (int)((buffer - pool->buffers[0]) / FUSB302_POOL_BUFFER_SIZE);
+    atomic_fetch_and(&pool->used, ~(1u << index));
+}
+
+int FUSB302_GetPoolPeak(FUSB302_BufferPool_t *pool) {
+    return (int)atomic_load(&pool->peak);
+}
+
+uint32_t FUSB302_GetPoolFailures(FUSB302_BufferPool_t *pool) {
+    return atomic_load(&pool->failures);
+}
@@ -0,0 +1,58 @@
+#ifndef FUSB302_POOL_H
+#define FUSB302_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FUSB302.h"
+
+// Allocation bitmap and counters, atomic in C and C++
+#ifdef __cplusplus
+#include <atomic>
+typedef std::atomic<uint32_t> FUSB302_PoolBitmap_t;
+#else
+#include <stdatomic.h>
+typedef _Atomic uint32_t FUSB302_PoolBitmap_t;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Message buffers per pool, at most 32 (one bitmap word). One buffer is in use while a PD message
+// is sent or received, more are needed only if ports share a pool across threads or interrupts.
+#ifndef FUSB302_POOL_BUFFERS
+#define FUSB302_POOL_BUFFERS 2
+#endif
+
+// Sized to the RX FIFO, also holds a full TX FIFO fill followed by a packed standard message
+#define FUSB302_POOL_BUFFER_SIZE 80
+
+#if FUSB302_POOL_BUFFERS < 1 || FUSB302_POOL_BUFFERS > 32
+#error "FUSB302_POOL_BUFFERS must be 1..32"
+#endif
+
+struct FUSB302_BufferPool {
+    FUSB302_PoolBitmap_t used; // bit n: buffers[n] handed out
+    FUSB302_PoolBitmap_t peak; // most buffers in use at the same time
+    FUSB302_PoolBitmap_t failures; // acquires with all buffers in use
+    uint8_t buffers[FUSB302_POOL_BUFFERS][FUSB302_POOL_BUFFER_SIZE];
+};
+
+// RAM of one pool, known at compile time
+#define FUSB302_POOL_RAM_SIZE (sizeof(FUSB302_BufferPool_t))
+
+void FUSB302_SetupBufferPool(FUSB302_BufferPool_t *pool);
+
+// Lock-free, safe from several threads and interrupts. Uses the pool of the platform (required,
+// one per port unless sized for sharing). Returns 0 if all buffers are in use or there is no pool.
+uint8_t *FUSB302_AcquireBuffer(FUSB302_Platform_t *platform);
+void FUSB302_ReleaseBuffer(FUSB302_Platform_t *platform, uint8_t *buffer);
+
+int FUSB302_GetPoolPeak(FUSB302_BufferPool_t *pool);
+uint32_t FUSB302_GetPoolFailures(FUSB302_BufferPool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_POOL_H
@@ -0,0 +1,93 @@
+#include "FUSB302Profile.h"
+
+static void ResetHistogram(FUSB302_LatencyHistogram_t *histogram) {
+    histogram->count = 0;
+    for (int i = 0; i < FUSB302_LATENCY_BUCKETS; i++) {
+        histogram->buckets[i] = 0;
+    }
+    histogram->min = 0;
+    histogram->max = 0;
+}
+
+static int LatencyBucket(FUSB302_TimeDiffMs latency) {
+    int bucket = 0;
+    while (latency > 0 && bucket < FUSB302_LATENCY_BUCKETS - 1) {
+        latency >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void FUSB302_ResetProfile(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile) {
+    for (int i = 0; i < FUSB302_PHASE_NUM; i++) {
+        profile->marks[i] = platform->invalidCycleTime;
+    }
+
+    for (int i = 0; i < FUSB302_LATENCY_NUM; i++) {
+        ResetHistogram(&profile->latency[i]);
+    }
+}
+
+void FUSB302_ProfileMark(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile,
+                         FUSB302_ProfilePhase_t phase) {
+    // Profiling is disabled without profile storage or time source
+    if (!profile || !platform->getCycleTime) {
+        return;
+    }
+
+    profile->marks[phase] = platform->getCycleTime();
+}
+
+void FUSB302_ProfileRecord(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile,
+                           FUSB302_ProfileLatency_t latency, FUSB302_ProfilePhase_t start,
+                           FUSB302_ProfilePhase_t end) {
+    if (!profile || !platform->getCycleTime) {
+        return;
+    }
+
+    if (profile->marks[start] == platform->invalidCycleTime ||
+        profile->marks[end] == platform->invalidCycleTime) {
+        return;
+    }
+
+    FUSB302_TimeDiffMs diff = platform->getTimeDiffMs(profile->marks[end], profile->marks[start]);
+    if (diff < 0) {
+        return;
+    }
+
+    FUSB302_LatencyHistogram_t *histogram = &profile->latency[latency];
+    if (histogram->count == 0 || diff < histogram->min) {
+        histogram->min = diff;
+    }
+    if (histogram->count == 0 || diff > histogram->max) {
+        histogram->max = diff;
+    }
+    histogram->count++;
+    histogram->buckets[LatencyBucket(diff)]++;
+}
+
+const FUSB302_LatencyHistogram_t *FUSB302_GetLatencyHistogram(const FUSB302_Profile_t *profile,
+                                                              FUSB302_ProfileLatency_t latency) {
+    return &profile->latency[latency];
+}
+
+FUSB302_TimeDiffMs FUSB302_GetLatencyPercentile(const FUSB302_LatencyHistogram_t *histogram,
+                                                int percent) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    // Find bucket holding the percentile, report its upper bound (clamped to observed maximum)
+    uint32_t target = ((uint64_t)histogram->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < FUSB302_LATENCY_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= target && seen > 0) {
+            FUSB302_TimeDiffMs upper = bucket == 0 ? 0 : ((FUSB302_TimeDiffMs)1 << bucket) - 1;
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
@@ -0,0 +1,61 @@
+#ifndef FUSB302_PROFILE_H
+#define FUSB302_PROFILE_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Histogram buckets: 0 ms, then [2^(i-1), 2^i) ms, last bucket collects everything above
+#define FUSB302_LATENCY_BUCKETS 12
+
+typedef enum FUSB302_ProfilePhase {
+    FUSB302_PHASE_EVENT,          // CC change interrupt seen
+    FUSB302_PHASE_DISCOVERED,     // CC orientation and cable type discovered
+    FUSB302_PHASE_CONFIGURED,     // switches configured for new state (VCONN settled)
+    FUSB302_PHASE_IDENTITY_START, // emarker Discover Identity sent
+    FUSB302_PHASE_IDENTITY_DONE,  // emarker identity received or timed out
+    FUSB302_PHASE_STATUS_READ,    // interrupt and status burst started
+    FUSB302_PHASE_VCONN_OFF,      // VCONN switched off after a protection fault
+    FUSB302_PHASE_NUM,
+} FUSB302_ProfilePhase_t;
+
+typedef enum FUSB302_ProfileLatency {
+    FUSB302_LATENCY_ATTACH_TO_CONFIGURED, // EVENT -> CONFIGURED, ending attached
+    FUSB302_LATENCY_DISCOVER_IDENTITY,    // IDENTITY_START -> IDENTITY_DONE
+    FUSB302_LATENCY_DETACH_TO_IDLE,       // EVENT -> CONFIGURED, ending detached
+    FUSB302_LATENCY_FAULT_TO_VCONN_OFF,   // STATUS_READ -> VCONN_OFF
+    FUSB302_LATENCY_NUM,
+} FUSB302_ProfileLatency_t;
+
+typedef struct FUSB302_LatencyHistogram {
+    uint32_t count;
+    uint32_t buckets[FUSB302_LATENCY_BUCKETS];
+    FUSB302_TimeDiffMs min;
+    FUSB302_TimeDiffMs max;
+} FUSB302_LatencyHistogram_t;
+
+typedef struct FUSB302_Profile {
+    FUSB302_CycleTime marks[FUSB302_PHASE_NUM];
+    FUSB302_LatencyHistogram_t latency[FUSB302_LATENCY_NUM];
+} FUSB302_Profile_t;
+
+void FUSB302_ResetProfile(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile);
+void FUSB302_ProfileMark(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile,
+                         FUSB302_ProfilePhase_t phase);
+void FUSB302_ProfileRecord(FUSB302_Platform_t *platform, FUSB302_Profile_t *profile,
+                           FUSB302_ProfileLatency_t latency, FUSB302_ProfilePhase_t start,
+                           FUSB302_ProfilePhase_t end);
+
+const FUSB302_LatencyHistogram_t *FUSB302_GetLatencyHistogram(const FUSB302_Profile_t *profile,
+                                                              FUSB302_ProfileLatency_t latency);
+
+FUSB302_TimeDiffMs FUSB302_GetLatencyPercentile(const FUSB302_LatencyHistogram_t *histogram,
+                                                int percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_PROFILE_H
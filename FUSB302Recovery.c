@@ -0,0 +1,98 @@
+#include "FUSB302Recovery.h"
+
+#define RESET_DELAY_US 10000
+
+static bool RestoreImage(FUSB302_Platform_t *platform, FUSB302_Data_t *data) {
+    // Protection (OCREG), power and masks first, SWITCHES0 (VCONN) last: VCONN only comes back
+    // with its over-current limit in place
+    int numRegs = FUSB302_REG_CONTROL_START + FUSB302_REG_CONTROL_NUM - FUSB302_REG_SWITCHES1;
+    if (!FUSB302_WriteControlDataSeq(platform, data, FUSB302_REG_SWITCHES1, numRegs)) {
+        return false;
+    }
+
+    return FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+}
+
+static bool RecoverChip(FUSB302_Platform_t *platform, FUSB302_Data_t *data) {
+    // Reset FUSB302, shadow image is kept
+    if (!FUSB302_Reset(platform, data)) {
+        return false;
+    }
+
+    platform->delayUs(RESET_DELAY_US);
+
+    // Restore all control registers, no read-back of reset defaults
+    return RestoreImage(platform, data);
+}
+
+bool FUSB302_Recover(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                     FUSB302_RecoveryLevel_t level) {
+    bool ok = true;
+
+    if (level >= FUSB302_RECOVERY_CHIP) {
+        ok &= RecoverChip(platform, data);
+
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: Recovery level %d done (ok=%d)\r\n", level, ok);
+#endif
+
+        return ok;
+    }
+
+    // Drop pending messages
+    ok &= FUSB302_FlushFIFO(platform, data);
+
+    // Reset PD protocol state
+    if (level >= FUSB302_RECOVERY_PROTOCOL) {
+        ok &= FUSB302_ResetPD(platform, data);
+    }
+
+    // Reapply only registers which differ from the shadow image
+    int numWritten = 0;
+    if (level >= FUSB302_RECOVERY_REGISTERS) {
+        ok &= FUSB302_SyncControlData(platform, data, &numWritten);
+    }
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Recovery level %d done (ok=%d, %d registers rewritten)\r\n",
+                         level, ok, numWritten);
+#endif
+
+    return ok;
+}
+
+bool FUSB302_CheckChipReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data, bool *restored) {
+    *restored = false;
+
+    // Read sentinel into a separate image, the shadow is the reference
+    FUSB302_Data_t chip;
+    if (!FUSB302_ReadControlData(platform, &chip, FUSB302_REG_POWER)) {
+        return false;
+    }
+    if (*FUSB302_GetRegPtr(&chip, FUSB302_REG_POWER) ==
+        *FUSB302_GetRegPtr(data, FUSB302_REG_POWER)) {
+        return true;
+    }
+
+    // Chip is at reset defaults, restore all control registers
+    if (!RestoreImage(platform, data)) {
+        return false;
+    }
+    *restored = true;
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Chip reset detected (POWER=0x%02X), shadow image restored\r\n",
+                         *FUSB302_GetRegPtr(&chip, FUSB302_REG_POWER));
+#endif
+
+    return true;
+}
+
+bool FUSB302_SetupAutoReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            bool autoSoftReset, bool autoHardReset) {
+    // Send soft reset when retries fail, then hard reset when soft reset fails
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL3, FUSB302_AUTO_SOFTRESET, autoSoftReset);
+    FUSB302_SetDataBit(data, FUSB302_REG_CONTROL3, FUSB302_AUTO_HARDRESET, autoHardReset);
+
+    return FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL3);
+}
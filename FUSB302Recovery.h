@@ -0,0 +1,35 @@
+#ifndef FUSB302_RECOVERY_H
+#define FUSB302_RECOVERY_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Recovery levels, each level includes the previous ones
+typedef enum FUSB302_RecoveryLevel {
+    FUSB302_RECOVERY_FIFO,      // flush TX and RX FIFO
+    FUSB302_RECOVERY_PROTOCOL,  // reset PD transmitter and receiver logic
+    FUSB302_RECOVERY_REGISTERS, // rewrite control registers differing from the shadow image
+    FUSB302_RECOVERY_CHIP,      // software reset and full rewrite of the shadow image
+} FUSB302_RecoveryLevel_t;
+
+bool FUSB302_Recover(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                     FUSB302_RecoveryLevel_t level);
+// Detects a chip reset (supply dip, ESD) by reading back POWER, whose reset default differs from
+// any configured image. The shadow image is restored when it does not match: all registers after
+// SWITCHES0 in one burst, then SWITCHES0, so VCONN is only switched on behind its over-current
+// limit. Host monitoring runs the check (FUSB302_HOST_INTEGRITY_CHECK_MS); sink monitoring and DRP
+// do not, call it from the application there (the restore works on any image, the monitoring state
+// is not re-synchronized).
+bool FUSB302_CheckChipReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data, bool *restored);
+// Runtime setting on top of the monitoring image, kept by warm start (FUSB302_ResumeHostMonitoring)
+bool FUSB302_SetupAutoReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                            bool autoSoftReset, bool autoHardReset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_RECOVERY_H
@@ -0,0 +1,272 @@
+#include <string.h>
+
+#include "FUSB302Sink.h"
+#include "FUSB302Trace.h"
+
+// Enable sink pull-downs on both CC, measure CC1 until orientation is known, no VCONN
+#define SINK_SWITCHES0 (FUSB302_PDWN1 | FUSB302_PDWN2 | FUSB302_MEAS_CC1)
+
+// Sink / UFP roles for GoodCRC, auto GoodCRC
+#define SINK_SWITCHES1 (FUSB302_RESET_SWITCHES1 | FUSB302_AUTOCRC)
+
+// Enable interrupts to host
+#define SINK_CONTROL0 (FUSB302_RESET_CONTROL0 & ~FUSB302_INT_MASK)
+
+// Mask all interupts except VBUS and Rp level changes
+#define SINK_MASK (0xFF & ~(FUSB302_M_VBUSOK | FUSB302_M_BC_LVL))
+#define SINK_MASKA 0xFF
+#define SINK_MASKB FUSB302_M_GCRCSENT
+
+// Setup power
+#define SINK_POWER                                                                                 \
+    (FUSB302_PWR_INT_OSC | FUSB302_PWR_MEAS_BLOCK | FUSB302_PWR_RECV_CUR |                         \
+     FUSB302_PWR_BANDGAP_WAKE)
+
+// Complete control register image after sink monitoring setup
+static const uint8_t sinkImage[FUSB302_REG_CONTROL_NUM] = {
+    0x00, /* DEVICE_ID, read only */
+    SINK_SWITCHES0, SINK_SWITCHES1, FUSB302_RESET_MEASURE, FUSB302_RESET_SLICE, SINK_CONTROL0,
+    FUSB302_RESET_CONTROL1, FUSB302_RESET_CONTROL2, FUSB302_RESET_CONTROL3, SINK_MASK, SINK_POWER,
+    FUSB302_RESET_RESET, FUSB302_RESET_OCREG, SINK_MASKA, SINK_MASKB, FUSB302_RESET_CONTROL4,
+};
+
+static FUSB302_RpLevel_t GetRpLevel(FUSB302_Data_t *data) {
+    // BC_LVL thresholds match vRd-Connect, vRd-USB, vRd-1.5 and vRd-3.0
+    switch (FUSB302_GetDataValue(data, FUSB302_REG_STATUS0, FUSB302_BC_LVL_BITS,
+                                 FUSB302_BC_LVL_OFFSET)) {
+    case FUSB302_BC_LVL_200_660MV:
+        return FUSB302_RP_LEVEL_DEFAULT;
+    case FUSB302_BC_LVL_660_1230MV:
+        return FUSB302_RP_LEVEL_1_5A;
+    case FUSB302_BC_LVL_1230MV_MORE:
+        return FUSB302_RP_LEVEL_3A;
+    case FUSB302_BC_LVL_0_200MV:
+    default:
+        return FUSB302_RP_LEVEL_NONE;
+    }
+}
+
+static bool SelectCC(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                     FUSB302_CC_Orientation_t cc) {
+    // Select CC pin for BC_LVL comparators
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC1,
+                       cc == FUSB302_CC_ORIENTATION_CC1);
+    FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_MEAS_CC2,
+                       cc == FUSB302_CC_ORIENTATION_CC2);
+    return FUSB302_WriteControlData(platform, data, FUSB302_REG_SWITCHES0);
+}
+
+static bool MeasureCC(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                      FUSB302_CC_Orientation_t cc, FUSB302_RpLevel_t *level) {
+    if (!SelectCC(platform, data, cc)) {
+        return false;
+    }
+
+    platform->delayUs(FUSB302_SINK_SETTLE_US);
+
+    if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0)) {
+        return false;
+    }
+    *level = GetRpLevel(data);
+
+    return true;
+}
+
+static bool DiscoverOrientation(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                FUSB302_CC_Orientation_t *ccOrientation, FUSB302_RpLevel_t *level) {
+    bool ok = true;
+
+    // Rp is only on the CC wire, the other pin sees Ra or nothing
+    FUSB302_RpLevel_t level1 = FUSB302_RP_LEVEL_NONE, level2 = FUSB302_RP_LEVEL_NONE;
+    ok &= MeasureCC(platform, data, FUSB302_CC_ORIENTATION_CC1, &level1);
+    ok &= MeasureCC(platform, data, FUSB302_CC_ORIENTATION_CC2, &level2);
+
+    if (level2 > level1) {
+        // Keep measuring CC2
+        *ccOrientation = FUSB302_CC_ORIENTATION_CC2;
+        *level = level2;
+    } else {
+        // Measure CC1: active pin, or idle pin while unattached
+        *ccOrientation = level1 ? FUSB302_CC_ORIENTATION_CC1 : FUSB302_CC_ORIENTATION_UNKNOWN;
+        *level = level1;
+        ok &= SelectCC(platform, data, FUSB302_CC_ORIENTATION_CC1);
+    }
+
+    // Clear BC_LVL interrupts caused by switching
+    ok &= FUSB302_ReadStatusData(platform, data, FUSB302_REG_INTERRUPT);
+
+    return ok;
+}
+
+static void SetUnattached(FUSB302_SinkMonitoring_t *monitoring) {
+    monitoring->state = FUSB302_SINK_STATE_UNATTACHED;
+    monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+    monitoring->rpLevel = FUSB302_RP_LEVEL_NONE;
+    monitoring->rpPending = false;
+}
+
+static void TrackRpLevel(FUSB302_CycleTime time, FUSB302_Platform_t *platform,
+                         FUSB302_RpLevel_t level, FUSB302_SinkMonitoring_t *monitoring) {
+    if (level < monitoring->rpLevel) {
+        // Downgrade: reduce current at once
+        monitoring->rpLevel = level;
+        monitoring->rpPending = false;
+    } else if (level > monitoring->rpLevel) {
+        // Upgrade: wait until stable
+        if (!monitoring->rpPending || monitoring->pendingRpLevel != level) {
+            monitoring->rpPending = true;
+            monitoring->pendingRpLevel = level;
+            monitoring->rpTime = time;
+        } else if (platform->getTimeDiffMs(time, monitoring->rpTime) >=
+                   FUSB302_T_RP_VALUE_CHANGE_MS) {
+            monitoring->rpLevel = level;
+            monitoring->rpPending = false;
+        }
+    } else {
+        monitoring->rpPending = false;
+    }
+}
+
+bool FUSB302_SetupSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring) {
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_SINK_SETUP, time);
+    }
+
+    // Reset FUSB302
+    if (!FUSB302_Reset(platform, data)) {
+        return false;
+    }
+
+    platform->delayUs(10000);
+
+    return FUSB302_StartSinkMonitoring(platform, data, time, monitoring);
+}
+
+bool FUSB302_StartSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring) {
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_SINK_START, time);
+    }
+
+    // Configure sink monitoring (complete image, previous configuration is overwritten)
+    memcpy(data->controlRegData, sinkImage, FUSB302_REG_CONTROL_NUM);
+    if (!FUSB302_WriteControlData(platform, data, FUSB302_REG_ALL)) {
+        return false;
+    }
+
+    // Set initial monitoring state, CC and VBUS are evaluated on first update
+    monitoring->state = FUSB302_SINK_STATE_INIT;
+    monitoring->ccOrientation = FUSB302_CC_ORIENTATION_UNKNOWN;
+    monitoring->vbusOk = false;
+    monitoring->rpLevel = FUSB302_RP_LEVEL_NONE;
+    monitoring->pendingRpLevel = FUSB302_RP_LEVEL_NONE;
+    monitoring->rpPending = false;
+    monitoring->rpTime = time;
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Sink monitoring started\r\n");
+#endif
+
+    return true;
+}
+
+bool FUSB302_UpdateSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring) {
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_SINK_UPDATE, time);
+    }
+
+    // Read interrupt and status registers in one burst (INTERRUPTA..INTERRUPT)
+    if (!FUSB302_ReadStatusDataSeq(platform, data, FUSB302_REG_INTERRUPTA,
+                                   FUSB302_REG_INTERRUPT - FUSB302_REG_INTERRUPTA + 1)) {
+        return false;
+    }
+
+    bool ok = true;
+
+    FUSB302_SinkState_t prevState = monitoring->state;
+    FUSB302_RpLevel_t prevRpLevel = monitoring->rpLevel;
+
+    uint8_t i_vbusok = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_VBUSOK);
+    uint8_t i_bc_lvl = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_BC_LVL);
+    monitoring->vbusOk = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_VBUSOK);
+
+    switch (monitoring->state) {
+    case FUSB302_SINK_STATE_ATTACHED:
+        if (!monitoring->vbusOk) {
+            // VBUS removed: detach, watch CC1 again
+            ok &= SelectCC(platform, data, FUSB302_CC_ORIENTATION_CC1);
+            SetUnattached(monitoring);
+        } else if ((i_bc_lvl || monitoring->rpPending) &&
+                   !FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_ACTIVITY)) {
+            // BC_LVL of the active CC (not valid during BMC activity)
+            TrackRpLevel(time, platform, GetRpLevel(data), monitoring);
+        }
+        break;
+    case FUSB302_SINK_STATE_INIT:
+    case FUSB302_SINK_STATE_UNATTACHED:
+    case FUSB302_SINK_STATE_ATTACH_WAIT:
+    default:
+        if (!i_vbusok && !i_bc_lvl && monitoring->state != FUSB302_SINK_STATE_INIT) {
+            break;
+        }
+
+        FUSB302_RpLevel_t level;
+        ok &= DiscoverOrientation(platform, data, &monitoring->ccOrientation, &level);
+
+        // VBUSOK interrupt may have been cleared meanwhile, use level from last STATUS0 read
+        monitoring->vbusOk = FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_VBUSOK);
+        if (level == FUSB302_RP_LEVEL_NONE) {
+            SetUnattached(monitoring);
+        } else if (monitoring->vbusOk) {
+            monitoring->state = FUSB302_SINK_STATE_ATTACHED;
+            monitoring->rpLevel = level;
+            monitoring->rpPending = false;
+        } else {
+            monitoring->state = FUSB302_SINK_STATE_ATTACH_WAIT;
+        }
+        break;
+    }
+
+#ifdef FUSB302_DEBUG
+    if (monitoring->state != prevState || monitoring->rpLevel != prevRpLevel) {
+        platform->debugPrint("FUSB302: Sink state %d -> %d (CC = %d, Rp = %d)\r\n", prevState,
+                             monitoring->state, monitoring->ccOrientation, monitoring->rpLevel);
+    }
+#else
+    (void)prevState;
+    (void)prevRpLevel;
+#endif
+
+    return ok;
+}
+
+bool FUSB302_IsSinkAttached(FUSB302_SinkMonitoring_t *monitoring) {
+    return monitoring->state == FUSB302_SINK_STATE_ATTACHED;
+}
+
+bool FUSB302_IsSinkDebouncing(FUSB302_SinkMonitoring_t *monitoring) {
+    return monitoring->rpPending;
+}
+
+int FUSB302_GetSinkCurrentMa(FUSB302_SinkMonitoring_t *monitoring) {
+    if (monitoring->state != FUSB302_SINK_STATE_ATTACHED) {
+        return 0;
+    }
+
+    switch (monitoring->rpLevel) {
+    case FUSB302_RP_LEVEL_DEFAULT:
+        return 500;
+    case FUSB302_RP_LEVEL_1_5A:
+        return 1500;
+    case FUSB302_RP_LEVEL_3A:
+        return 3000;
+    case FUSB302_RP_LEVEL_NONE:
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef FUSB302_SINK_H
+#define FUSB302_SINK_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rp advertisement must be stable for tRpValueChange (10..20 ms) before a higher current is used,
+// lower current is reported immediately
+#ifndef FUSB302_T_RP_VALUE_CHANGE_MS
+#define FUSB302_T_RP_VALUE_CHANGE_MS 10
+#endif
+
+// BC_LVL comparator settle time after switching the measured CC pin
+#ifndef FUSB302_SINK_SETTLE_US
+#define FUSB302_SINK_SETTLE_US 250
+#endif
+
+typedef enum FUSB302_SinkState {
+    FUSB302_SINK_STATE_INIT,
+    FUSB302_SINK_STATE_UNATTACHED,
+    FUSB302_SINK_STATE_ATTACH_WAIT, // Rp seen, waiting for VBUS
+    FUSB302_SINK_STATE_ATTACHED,
+} FUSB302_SinkState_t;
+
+// Source current advertisement (ordered by current)
+typedef enum FUSB302_RpLevel {
+    FUSB302_RP_LEVEL_NONE,
+    FUSB302_RP_LEVEL_DEFAULT,
+    FUSB302_RP_LEVEL_1_5A,
+    FUSB302_RP_LEVEL_3A,
+} FUSB302_RpLevel_t;
+
+typedef struct FUSB302_SinkMonitoring {
+    FUSB302_SinkState_t state;
+    FUSB302_CC_Orientation_t ccOrientation;
+    bool vbusOk;
+    FUSB302_RpLevel_t rpLevel;        // reported Rp level
+    FUSB302_RpLevel_t pendingRpLevel; // higher Rp level waiting for tRpValueChange
+    bool rpPending;
+    FUSB302_CycleTime rpTime;
+} FUSB302_SinkMonitoring_t;
+
+bool FUSB302_SetupSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring);
+// Switches to sink monitoring without reset (for example from a DRP toggle result)
+bool FUSB302_StartSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                 FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring);
+
+// Call on FUSB302 interrupt, and periodically while FUSB302_IsSinkDebouncing returns true
+bool FUSB302_UpdateSinkMonitoring(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                                  FUSB302_CycleTime time, FUSB302_SinkMonitoring_t *monitoring);
+
+bool FUSB302_IsSinkAttached(FUSB302_SinkMonitoring_t *monitoring);
+bool FUSB302_IsSinkDebouncing(FUSB302_SinkMonitoring_t *monitoring);
+int FUSB302_GetSinkCurrentMa(FUSB302_SinkMonitoring_t *monitoring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_SINK_H
@@ -0,0 +1,403 @@
+#include "FUSB302Source.h"
+#include "FUSB302Trace.h"
+
+#define PDO_TYPE(pdo) (((pdo) >> 30) & 0x3)
+#define PDO_TYPE_FIXED 0x0
+#define PDO_FIXED_VOLTAGE_50MV(pdo) (((pdo) >> 10) & 0x3FF)
+#define PDO_FIXED_CURRENT_10MA(pdo) ((pdo) & 0x3FF)
+
+#define RDO_OBJECT_POSITION(rdo) (((rdo) >> 28) & 0x7)
+#define RDO_OPERATING_CURRENT_10MA(rdo) (((rdo) >> 10) & 0x3FF)
+
+// Power stage callbacks, missing ones succeed. Results are marked for replay.
+static bool SetOutput(FUSB302_Platform_t *platform, FUSB302_Source_t *source, int objectPosition) {
+    bool ok = !source->power.setOutput || source->power.setOutput(source, objectPosition);
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_RESULT, ok);
+    }
+    return ok;
+}
+
+static bool IsOutputReady(FUSB302_Platform_t *platform, FUSB302_Source_t *source) {
+    bool ready = !source->power.isOutputReady || source->power.isOutputReady(source);
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_RESULT, ready);
+    }
+    return ready;
+}
+
+static void EnterSendCaps(FUSB302_Source_t *source, FUSB302_CycleTime time,
+                          FUSB302_TimeDiffMs waitMs) {
+    source->state = FUSB302_SOURCE_STATE_SEND_CAPS;
+    source->time = time;
+    source->waitMs = waitMs;
+}
+
+static bool HardReset(FUSB302_Platform_t *platform, FUSB302_Data_t *data, FUSB302_CycleTime time,
+                      FUSB302_Protocol_t *protocol, FUSB302_TxScheduler_t *scheduler,
+                      FUSB302_Source_t *source, bool send) {
+    bool ok = true;
+
+    if (send) {
+        // Hard reset signaling is not a message, queued messages are obsolete
+        FUSB302_ClearTxQueue(scheduler);
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL3, FUSB302_SEND_HARD_RESET, 1);
+        ok &= FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL3);
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL3, FUSB302_SEND_HARD_RESET, 0);
+        source->hardResetCount++;
+    }
+
+    // Contract is gone, VBUS goes to vSafe0V and back to vSafe5V after tSrcRecover
+    FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+    source->objectPosition = 0;
+    source->rdo = 0;
+    source->capsCount = 0;
+    FUSB302_ProtocolHardReset(protocol);
+    SetOutput(platform, source, -1);
+    source->outputSet = false;
+    source->state = FUSB302_SOURCE_STATE_VBUS_OFF;
+    source->time = time;
+
+#ifdef FUSB302_DEBUG
+    platform->debugPrint("FUSB302: Source hard reset (%s, count=%d)\r\n", send ? "sent" : "received",
+                         source->hardResetCount);
+#endif
+
+    return ok;
+}
+
+static bool SoftReset(FUSB302_CycleTime time, FUSB302_TxScheduler_t *scheduler,
+                      FUSB302_Source_t *source) {
+    // MessageID was reset by protocol layer, accept and renegotiate
+    FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+    bool ok = FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP,
+                                   FUSB302_PD_CTRL_ACCEPT, 0, 0, FUSB302_TX_PRIORITY_HIGH);
+    source->capsCount = 0;
+    EnterSendCaps(source, time, 0);
+
+    return ok;
+}
+
+static bool CheckRequest(FUSB302_Source_t *source, uint32_t rdo) {
+    int objectPosition = RDO_OBJECT_POSITION(rdo);
+    if (objectPosition < 1 || objectPosition > source->numPdos) {
+        return false;
+    }
+
+    uint32_t pdo = source->pdos[objectPosition - 1];
+    if (PDO_TYPE(pdo) != PDO_TYPE_FIXED) {
+        return false;
+    }
+
+    return RDO_OPERATING_CURRENT_10MA(rdo) <= PDO_FIXED_CURRENT_10MA(pdo);
+}
+
+static bool RejectMessage(const FUSB302_Protocol_t *protocol, FUSB302_TxScheduler_t *scheduler) {
+    // Not_Supported from PD 3.0 on, Reject before
+    uint8_t type = protocol->specRevision >= FUSB302_PD_SPEC_REV_3_0 ? FUSB302_PD_CTRL_NOT_SUPPORTED
+                                                                     : FUSB302_PD_CTRL_REJECT;
+    return FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP, type, 0, 0,
+                                FUSB302_TX_PRIORITY_HIGH);
+}
+
+static bool HandleMessage(FUSB302_Platform_t *platform, FUSB302_CycleTime time,
+                          const FUSB302_Protocol_t *protocol, FUSB302_TxScheduler_t *scheduler,
+                          FUSB302_Source_t *source, const FUSB302_PDMessage_t *message) {
+    bool ok = true;
+
+    uint8_t type = FUSB302_PD_HEADER_TYPE(message->header);
+    int numObjects = FUSB302_PD_HEADER_NUM_OBJECTS(message->header);
+
+    if (numObjects == 0 && type == FUSB302_PD_CTRL_GET_SOURCE_CAP) {
+        if (source->state == FUSB302_SOURCE_STATE_READY) {
+            EnterSendCaps(source, time, 0);
+        }
+    } else if (numObjects == 0 || type != FUSB302_PD_DATA_REQUEST) {
+        // Any other message the sink starts with a contract in place is not supported
+        if (source->state == FUSB302_SOURCE_STATE_READY) {
+            ok &= RejectMessage(protocol, scheduler);
+
+#ifdef FUSB302_DEBUG
+            platform->debugPrint("FUSB302: Source message %s type %d not supported\r\n",
+                                 numObjects ? "data" : "control", type);
+#endif
+        }
+    } else {
+        // Request is only valid as answer to Source_Capabilities
+        if (source->state != FUSB302_SOURCE_STATE_WAIT_REQUEST &&
+            source->state != FUSB302_SOURCE_STATE_READY) {
+            return true;
+        }
+
+        uint32_t rdo = message->objects[0];
+
+        if (CheckRequest(source, rdo)) {
+            ok &= FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP,
+                                       FUSB302_PD_CTRL_ACCEPT, 0, 0, FUSB302_TX_PRIORITY_HIGH);
+            source->rdo = rdo;
+            source->txDone = false;
+            source->outputSet = false;
+            source->state = FUSB302_SOURCE_STATE_TRANSITION;
+            source->time = time;
+        } else {
+            ok &= FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP,
+                                       FUSB302_PD_CTRL_REJECT, 0, 0, FUSB302_TX_PRIORITY_HIGH);
+            FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+            if (source->objectPosition) {
+                source->state = FUSB302_SOURCE_STATE_READY;
+            } else {
+                EnterSendCaps(source, time, FUSB302_T_SOURCE_CAPABILITY_MS);
+            }
+        }
+
+#ifdef FUSB302_DEBUG
+        platform->debugPrint("FUSB302: Source request RDO=%08lX %s\r\n", (unsigned long)rdo,
+                             source->state == FUSB302_SOURCE_STATE_TRANSITION ? "accepted"
+                                                                              : "rejected");
+#else
+        (void)platform;
+#endif
+    }
+
+    return ok;
+}
+
+uint32_t FUSB302_FixedPDO(int voltageMv, int maxCurrentMa, uint32_t flags) {
+    return (PDO_TYPE_FIXED << 30) | flags | ((uint32_t)(voltageMv / 50) & 0x3FF) << 10 |
+           ((uint32_t)(maxCurrentMa / 10) & 0x3FF);
+}
+
+bool FUSB302_SetupSource(FUSB302_Source_t *source, const uint32_t *pdos, int numPdos,
+                         const FUSB302_SourcePower_t *power, void *context) {
+    // First PDO must be vSafe5V fixed supply
+    if (numPdos < 1 || numPdos > FUSB302_PD_MAX_DATA_OBJECTS ||
+        PDO_TYPE(pdos[0]) != PDO_TYPE_FIXED || PDO_FIXED_VOLTAGE_50MV(pdos[0]) != 5000 / 50) {
+        return false;
+    }
+
+    source->state = FUSB302_SOURCE_STATE_IDLE;
+    for (int i = 0; i < numPdos; i++) {
+        source->pdos[i] = pdos[i];
+    }
+    source->numPdos = numPdos;
+    source->power.setOutput = power ? power->setOutput : 0;
+    source->power.isOutputReady = power ? power->isOutputReady : 0;
+    source->context = context;
+
+    source->time = 0;
+    source->waitMs = 0;
+    source->txDone = false;
+    source->outputSet = false;
+    source->capsCount = 0;
+    source->hardResetCount = 0;
+    source->objectPosition = 0;
+    source->rdo = 0;
+    source->messagePending = false;
+
+    return true;
+}
+
+bool FUSB302_UpdateSource(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                          FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                          FUSB302_TxScheduler_t *scheduler, FUSB302_Source_t *source) {
+    bool ok = true;
+    FUSB302_Protocol_t *protocol = &monitoring->protocol;
+
+    source->messagePending = false;
+
+    // Mark the call for replay, with the capabilities when the source starts
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_SOURCE_UPDATE, time);
+        if (source->state == FUSB302_SOURCE_STATE_IDLE && FUSB302_IsDeviceAttached(monitoring)) {
+            for (int i = 0; i < source->numPdos; i++) {
+                FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_ARG, source->pdos[i]);
+            }
+        }
+    }
+
+    // Follow attach state of host monitoring
+    if (!FUSB302_IsDeviceAttached(monitoring)) {
+        if (source->state != FUSB302_SOURCE_STATE_IDLE) {
+            source->state = FUSB302_SOURCE_STATE_IDLE;
+            source->objectPosition = 0;
+            source->rdo = 0;
+            SetOutput(platform, source, 0);
+        }
+        return true;
+    }
+
+    if (source->state == FUSB302_SOURCE_STATE_IDLE) {
+        source->capsCount = 0;
+        source->hardResetCount = 0;
+        EnterSendCaps(source, time, 0);
+    }
+
+    // Resets from port partner (interrupts from the monitoring burst, FIFO already flushed)
+    if (FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_HARDRST)) {
+        return HardReset(platform, data, time, protocol, scheduler, source, false);
+    }
+    bool softReset = FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_SOFTRST);
+
+    // Handle received message, RX_EMPTY of the burst may be stale after other engines' accesses
+    if (!softReset && source->state != FUSB302_SOURCE_STATE_DISABLED) {
+        FUSB302_PDMessage_t message;
+        bool received = false;
+        message.header = 0;
+        if (FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS1)) {
+            ok &= FUSB302_ProtocolReceive(platform, data, protocol, &message, &received);
+        } else {
+            ok = false;
+        }
+        bool sop = received && message.sop == FUSB302_SOP &&
+                   !FUSB302_PD_HEADER_EXTENDED(message.header);
+        int numObjects = FUSB302_PD_HEADER_NUM_OBJECTS(message.header);
+        uint8_t type = FUSB302_PD_HEADER_TYPE(message.header);
+        if (sop && numObjects == 0 && type == FUSB302_PD_CTRL_SOFT_RESET) {
+            // Soft_Reset without the interrupt (burst lost), same path as I_SOFTRST
+            softReset = true;
+        } else if (sop && !(numObjects && type == FUSB302_PD_DATA_VENDOR_DEFINED)) {
+            ok &= HandleMessage(platform, time, protocol, scheduler, source, &message);
+        } else if (received) {
+            // Leave to other engines (discovery)
+            source->message = message;
+            source->messagePending = true;
+        }
+    }
+    if (softReset) {
+        return ok & SoftReset(time, scheduler, source);
+    }
+
+    FUSB302_TimeDiffMs elapsed = platform->getTimeDiffMs(time, source->time);
+    switch (source->state) {
+    case FUSB302_SOURCE_STATE_SEND_CAPS:
+        if (elapsed < source->waitMs) {
+            break;
+        }
+
+        // Sink does not acknowledge capabilities, stay with Type-C current
+        if (source->capsCount >= FUSB302_N_CAPS_COUNT) {
+            source->state = FUSB302_SOURCE_STATE_DISABLED;
+            break;
+        }
+
+        // Power negotiation AMS, SinkTxNG until PS_RDY or Reject
+        FUSB302_BeginAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+        ok &= FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP,
+                                   FUSB302_PD_DATA_SOURCE_CAPABILITIES, source->pdos,
+                                   source->numPdos, FUSB302_TX_PRIORITY_NORMAL);
+        source->capsCount++;
+        source->txDone = false;
+        source->state = FUSB302_SOURCE_STATE_WAIT_REQUEST;
+        source->time = time;
+        break;
+    case FUSB302_SOURCE_STATE_WAIT_REQUEST:
+        if (!source->txDone) {
+            // Result reported by the scheduler for the last message of the source
+            FUSB302_TxResult_t result =
+                FUSB302_GetTxResult(scheduler, FUSB302_TX_SENDER_SOURCE);
+            if (result == FUSB302_TX_RESULT_FAILED) {
+                // No GoodCRC, sink may not be ready or not PD capable
+                FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+                EnterSendCaps(source, time, FUSB302_T_SOURCE_CAPABILITY_MS);
+            } else if (result == FUSB302_TX_RESULT_SENT) {
+                // SenderResponseTimer starts with GoodCRC
+                source->txDone = true;
+                source->hardResetCount = 0;
+                source->time = time;
+            }
+        } else if (elapsed >= FUSB302_T_SENDER_RESPONSE_MS) {
+            ok &= HardReset(platform, data, time, protocol, scheduler, source, true);
+        }
+        break;
+    case FUSB302_SOURCE_STATE_TRANSITION:
+        if (!source->txDone) {
+            // tSrcTransition starts with the GoodCRC of Accept
+            FUSB302_TxResult_t result =
+                FUSB302_GetTxResult(scheduler, FUSB302_TX_SENDER_SOURCE);
+            if (result == FUSB302_TX_RESULT_FAILED) {
+                // Sink did not get Accept, contract unchanged
+                FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+                if (source->objectPosition) {
+                    source->state = FUSB302_SOURCE_STATE_READY;
+                } else {
+                    EnterSendCaps(source, time, FUSB302_T_SOURCE_CAPABILITY_MS);
+                }
+            } else if (result == FUSB302_TX_RESULT_SENT) {
+                source->txDone = true;
+                source->time = time;
+            }
+        } else if (!source->outputSet) {
+            // Start transition after tSrcTransition
+            if (elapsed >= FUSB302_T_SRC_TRANSITION_MS) {
+                source->outputSet = true;
+                if (!SetOutput(platform, source, RDO_OBJECT_POSITION(source->rdo))) {
+                    ok &= HardReset(platform, data, time, protocol, scheduler, source, true);
+                }
+            }
+        } else if (IsOutputReady(platform, source)) {
+            ok &= FUSB302_QueueMessage(scheduler, FUSB302_TX_SENDER_SOURCE, FUSB302_SOP,
+                                       FUSB302_PD_CTRL_PS_RDY, 0, 0, FUSB302_TX_PRIORITY_HIGH);
+            FUSB302_EndAMS(scheduler, FUSB302_TX_SENDER_SOURCE);
+            source->objectPosition = RDO_OBJECT_POSITION(source->rdo);
+            source->state = FUSB302_SOURCE_STATE_READY;
+
+#ifdef FUSB302_DEBUG
+            platform->debugPrint("FUSB302: Source contract PDO %d ready\r\n",
+                                 source->objectPosition);
+#endif
+        } else if (elapsed >= FUSB302_T_PS_TRANSITION_MS) {
+            ok &= HardReset(platform, data, time, protocol, scheduler, source, true);
+        }
+        break;
+    case FUSB302_SOURCE_STATE_VBUS_OFF:
+        if (!source->outputSet) {
+            // tSrcRecover counts from vSafe0V
+            if (IsOutputReady(platform, source) || elapsed >= FUSB302_T_SAFE_0V_MS) {
+                source->outputSet = true;
+                source->time = time;
+            }
+        } else if (elapsed >= FUSB302_T_SRC_RECOVER_MS) {
+            SetOutput(platform, source, 0);
+            source->state = FUSB302_SOURCE_STATE_VBUS_ON;
+            source->time = time;
+        }
+        break;
+    case FUSB302_SOURCE_STATE_VBUS_ON:
+        // Capabilities again once VBUS is at vSafe5V
+        if (IsOutputReady(platform, source) || elapsed >= FUSB302_T_SRC_TURN_ON_MS) {
+            if (source->hardResetCount > FUSB302_N_HARD_RESET_COUNT) {
+                source->state = FUSB302_SOURCE_STATE_DISABLED;
+            } else {
+                EnterSendCaps(source, time, 0);
+            }
+        }
+        break;
+    case FUSB302_SOURCE_STATE_IDLE:
+    case FUSB302_SOURCE_STATE_READY:
+    case FUSB302_SOURCE_STATE_DISABLED:
+    default:
+        break;
+    }
+
+    return ok;
+}
+
+bool FUSB302_IsSourceBusy(FUSB302_Source_t *source) {
+    return source->state == FUSB302_SOURCE_STATE_SEND_CAPS ||
+           source->state == FUSB302_SOURCE_STATE_WAIT_REQUEST ||
+           source->state == FUSB302_SOURCE_STATE_TRANSITION ||
+           source->state == FUSB302_SOURCE_STATE_VBUS_OFF ||
+           source->state == FUSB302_SOURCE_STATE_VBUS_ON;
+}
+
+bool FUSB302_GetSourceContract(FUSB302_Source_t *source, int *voltageMv, int *currentMa) {
+    if (!source->objectPosition) {
+        return false;
+    }
+
+    uint32_t pdo = source->pdos[source->objectPosition - 1];
+    *voltageMv = PDO_FIXED_VOLTAGE_50MV(pdo) * 50;
+    *currentMa = RDO_OPERATING_CURRENT_10MA(source->rdo) * 10;
+
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef FUSB302_SOURCE_H
+#define FUSB302_SOURCE_H
+
+#include "FUSB302.h"
+#include "FUSB302Host.h"
+#include "FUSB302PD.h"
+#include "FUSB302Tx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Source policy engine timers and counters
+#ifndef FUSB302_T_SENDER_RESPONSE_MS
+#define FUSB302_T_SENDER_RESPONSE_MS 27 // tSenderResponse 24..30 ms
+#endif
+#ifndef FUSB302_T_SOURCE_CAPABILITY_MS
+#define FUSB302_T_SOURCE_CAPABILITY_MS 150 // SourceCapabilityTimer 100..200 ms
+#endif
+#ifndef FUSB302_T_SRC_TRANSITION_MS
+#define FUSB302_T_SRC_TRANSITION_MS 25 // tSrcTransition 25..35 ms
+#endif
+#ifndef FUSB302_T_PS_TRANSITION_MS
+#define FUSB302_T_PS_TRANSITION_MS 450 // PS_RDY must be sent before sink tPSTransition (450 ms)
+#endif
+#ifndef FUSB302_T_SRC_RECOVER_MS
+#define FUSB302_T_SRC_RECOVER_MS 700 // tSrcRecover 660..1000 ms
+#endif
+#ifndef FUSB302_T_SAFE_0V_MS
+#define FUSB302_T_SAFE_0V_MS 650 // VBUS at vSafe0V within tSafe0V after hard reset
+#endif
+#ifndef FUSB302_T_SRC_TURN_ON_MS
+#define FUSB302_T_SRC_TURN_ON_MS 275 // VBUS back at vSafe5V within tSrcTurnOn
+#endif
+#define FUSB302_N_CAPS_COUNT 50
+#define FUSB302_N_HARD_RESET_COUNT 2
+
+// Fixed supply PDO flags (first PDO only)
+#define FUSB302_PDO_FIXED_DUAL_ROLE_POWER (1u << 29)
+#define FUSB302_PDO_FIXED_USB_SUSPEND (1u << 28)
+#define FUSB302_PDO_FIXED_UNCONSTRAINED_POWER (1u << 27)
+#define FUSB302_PDO_FIXED_USB_COMM (1u << 26)
+#define FUSB302_PDO_FIXED_DUAL_ROLE_DATA (1u << 25)
+
+typedef enum FUSB302_SourceState {
+    FUSB302_SOURCE_STATE_IDLE,         // no device attached
+    FUSB302_SOURCE_STATE_SEND_CAPS,    // Source_Capabilities due after timer
+    FUSB302_SOURCE_STATE_WAIT_REQUEST, // Source_Capabilities sent, waiting for Request
+    FUSB302_SOURCE_STATE_TRANSITION,   // Request accepted, power stage switching
+    FUSB302_SOURCE_STATE_READY,        // explicit contract
+    FUSB302_SOURCE_STATE_DISABLED,     // sink is not PD capable, Type-C current only
+    FUSB302_SOURCE_STATE_VBUS_OFF,     // hard reset: VBUS to vSafe0V, then tSrcRecover
+    FUSB302_SOURCE_STATE_VBUS_ON,      // hard reset: VBUS back to vSafe5V
+} FUSB302_SourceState_t;
+
+typedef struct FUSB302_Source FUSB302_Source_t;
+
+typedef struct FUSB302_SourcePower {
+    // Start switching output to PDO at objectPosition (1-based), 0: back to vSafe5V, -1: off
+    // (vSafe0V, hard reset)
+    bool (*setOutput)(FUSB302_Source_t *source, int objectPosition);
+    // Output settled at the level requested by setOutput
+    bool (*isOutputReady)(FUSB302_Source_t *source);
+} FUSB302_SourcePower_t;
+
+struct FUSB302_Source {
+    FUSB302_SourceState_t state;
+    uint32_t pdos[FUSB302_PD_MAX_DATA_OBJECTS];
+    int numPdos;
+    FUSB302_SourcePower_t power;
+    void *context; // user data for power callbacks
+
+    FUSB302_CycleTime time;    // start of current state timer
+    FUSB302_TimeDiffMs waitMs; // SEND_CAPS delay
+    bool txDone;               // Source_Capabilities or Accept acknowledged by GoodCRC
+    bool outputSet;            // setOutput called in TRANSITION, vSafe0V reached in VBUS_OFF
+    uint8_t capsCount;
+    uint8_t hardResetCount;
+
+    int objectPosition; // contract PDO (1-based), 0: no explicit contract
+    uint32_t rdo;       // accepted Request Data Object
+
+    // Message received in the last update and not handled by the source (VDM, SOP', ...)
+    FUSB302_PDMessage_t message;
+    bool messagePending;
+};
+
+uint32_t FUSB302_FixedPDO(int voltageMv, int maxCurrentMa, uint32_t flags);
+
+bool FUSB302_SetupSource(FUSB302_Source_t *source, const uint32_t *pdos, int numPdos,
+                         const FUSB302_SourcePower_t *power, void *context);
+
+// Call right after FUSB302_UpdateTxScheduler with the same data, uses the interrupt burst of host
+// monitoring. Messages are queued on the scheduler of the port and sent by its next update. Must
+// be called periodically while negotiating (see FUSB302_IsSourceBusy).
+bool FUSB302_UpdateSource(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                          FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                          FUSB302_TxScheduler_t *scheduler, FUSB302_Source_t *source);
+
+bool FUSB302_IsSourceBusy(FUSB302_Source_t *source);
+bool FUSB302_GetSourceContract(FUSB302_Source_t *source, int *voltageMv, int *currentMa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_SOURCE_H
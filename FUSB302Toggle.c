@@ -1,5 +1,64 @@
+#include <string.h>
+
 #include "FUSB302Toggle.h"
 
+// Setup VCONN (VCONN_CC1=0, VCONN_CC2=0)
+#define TOGGLE_SWITCHES0 (FUSB302_RESET_SWITCHES0 & ~(FUSB302_VCONN_CC1 | FUSB302_VCONN_CC2))
+
+// Setup VBUS measurement (MEAS_VBUS=0)
+#define TOGGLE_MEASURE (FUSB302_RESET_MEASURE & ~FUSB302_MEAS_VBUS)
+
+// Setup host current, unmask the INT_N pin (INT_MASK=0, reset default 1 masks all interrupts)
+#define TOGGLE_CONTROL0(hostCur)                                                                   \
+    ((FUSB302_RESET_CONTROL0 & ~(FUSB302_INT_MASK | FUSB302_HOST_CUR_BITS)) |                      \
+     ((hostCur) << FUSB302_HOST_CUR_OFFSET))
+
+// Set toggle mode (MODE: 01 DRP, 10 SNK, 11 SRC, TOGGLE=1), stop SRC polling on Rd only
+// (TOG_RD_ONLY=1: a cable alone, Ra, does not end the toggle)
+#define TOGGLE_CONTROL2(mode)                                                                      \
+    ((FUSB302_RESET_CONTROL2 & ~FUSB302_MODE_BITS) | ((mode) << FUSB302_MODE_OFFSET) |             \
+     FUSB302_TOGGLE | FUSB302_TOG_RD_ONLY)
+
+// Setup interrupt mask (only I_TOGDONE and I_BC_LVL Interrupt): Mask=0xFE, Maska=0xBF, Maskb=0x01
+#define TOGGLE_MASK (0xFF & ~FUSB302_M_BC_LVL)
+#define TOGGLE_MASKA (0xFF & ~FUSB302_M_TOGDONE)
+#define TOGGLE_MASKB FUSB302_M_GCRCSENT
+
+// Setup power (PWR=07H)
+#define TOGGLE_POWER (FUSB302_PWR_MEAS_BLOCK | FUSB302_PWR_RECV_CUR | FUSB302_PWR_BANDGAP_WAKE)
+
+#define TOGGLE_IMAGE(mode, hostCur)                                                                \
+    {                                                                                              \
+        0x00, /* DEVICE_ID, read only */                                                           \
+        TOGGLE_SWITCHES0, FUSB302_RESET_SWITCHES1, TOGGLE_MEASURE, FUSB302_RESET_SLICE,            \
+        TOGGLE_CONTROL0(hostCur), FUSB302_RESET_CONTROL1, TOGGLE_CONTROL2(mode),                   \
+        FUSB302_RESET_CONTROL3, TOGGLE_MASK, TOGGLE_POWER, FUSB302_RESET_RESET,                    \
+        FUSB302_RESET_OCREG, TOGGLE_MASKA, TOGGLE_MASKB, FUSB302_RESET_CONTROL4                    \
+    }
+
+#define TOGGLE_IMAGES(mode)                                                                        \
+    {                                                                                              \
+        [FUSB302_HOST_CURRENT_MODE_500MA] = TOGGLE_IMAGE(mode, FUSB302_HOST_CUR_DEF_USB),          \
+        [FUSB302_HOST_CURRENT_MODE_1_5A] = TOGGLE_IMAGE(mode, FUSB302_HOST_CUR_1_5A),              \
+        [FUSB302_HOST_CURRENT_MODE_3A] = TOGGLE_IMAGE(mode, FUSB302_HOST_CUR_3A),                  \
+    }
+
+// Complete control register image after toggle setup, per toggle mode and host current mode
+static const uint8_t toggleImage[][3][FUSB302_REG_CONTROL_NUM] = {
+    [FUSB302_TOGGLE_MODE_DRP - FUSB302_TOGGLE_MODE_DRP] = TOGGLE_IMAGES(FUSB302_MODE_TOGGLE_DRP),
+    [FUSB302_TOGGLE_MODE_SNK - FUSB302_TOGGLE_MODE_DRP] = TOGGLE_IMAGES(FUSB302_MODE_TOGGLE_SNK),
+    [FUSB302_TOGGLE_MODE_SRC - FUSB302_TOGGLE_MODE_DRP] = TOGGLE_IMAGES(FUSB302_MODE_TOGGLE_SRC),
+};
+
+// Control register reset values (TOGGLE=0)
+static const uint8_t resetImage[FUSB302_REG_CONTROL_NUM] = {
+    0x00, /* DEVICE_ID, read only */
+    FUSB302_RESET_SWITCHES0, FUSB302_RESET_SWITCHES1, FUSB302_RESET_MEASURE, FUSB302_RESET_SLICE,
+    FUSB302_RESET_CONTROL0, FUSB302_RESET_CONTROL1, FUSB302_RESET_CONTROL2, FUSB302_RESET_CONTROL3,
+    FUSB302_RESET_MASK, FUSB302_RESET_POWER, FUSB302_RESET_RESET, FUSB302_RESET_OCREG,
+    FUSB302_RESET_MASKA, FUSB302_RESET_MASKB, FUSB302_RESET_CONTROL4,
+};
+
 bool FUSB302_SetupToggleMode(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                              FUSB302_ToggleMode_t mode, FUSB302_HostCurrentMode_t hostCurrentMode) {
     // Reset FUSB302
@@ -9,91 +68,44 @@ bool FUSB302_SetupToggleMode(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
 
     platform->delayUs(1000);
 
-    // Read control data
-    if (!FUSB302_ReadControlData(platform, data, FUSB302_REG_ALL)) {
-        return false;
+    if (mode == FUSB302_TOGGLE_MODE_MANUAL) {
+        // Reset toggle mode (TOGGLE=0), which is the reset value: nothing to write
+        memcpy(data->controlRegData, resetImage, FUSB302_REG_CONTROL_NUM);
+        return true;
     }
 
-    if (mode != FUSB302_TOGGLE_MODE_MANUAL) {
-        // Read status data to clear interrupt
-        if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_ALL)) {
-            return false;
-        }
+    return FUSB302_StartToggleMode(platform, data, mode, hostCurrentMode);
+}
 
-        // Configure toggle mode
-        int modeValue;
-        switch (mode) {
-        case FUSB302_TOGGLE_MODE_DRP:
-            modeValue = FUSB302_MODE_TOGGLE_DRP;
-            break;
-        case FUSB302_TOGGLE_MODE_SNK:
-            modeValue = FUSB302_MODE_TOGGLE_SNK;
-            break;
-        case FUSB302_TOGGLE_MODE_SRC:
-            modeValue = FUSB302_MODE_TOGGLE_SRC;
-            break;
-        default:
+bool FUSB302_StartToggleMode(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_ToggleMode_t mode, FUSB302_HostCurrentMode_t hostCurrentMode) {
+    if (mode != FUSB302_TOGGLE_MODE_DRP && mode != FUSB302_TOGGLE_MODE_SNK &&
+        mode != FUSB302_TOGGLE_MODE_SRC) {
+        return false;
+    }
+
+    // Stop a running or finished toggle first, the toggle logic restarts on TOGGLE 0 -> 1
+    if (FUSB302_GetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOGGLE)) {
+        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOGGLE, 0);
+        if (!FUSB302_WriteControlData(platform, data, FUSB302_REG_CONTROL2)) {
             return false;
         }
+    }
 
-        FUSB302_SetDataValue(data, FUSB302_REG_CONTROL2, FUSB302_MODE_BITS, FUSB302_MODE_OFFSET,
-                             modeValue);
-
-        // Set toggle mode (TOGGLE=1)
-        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOGGLE, 1);
-
-        // Setup power (PWR=07H)
-        FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_MEAS_BLOCK, 1);
-        FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_RECV_CUR, 1);
-        FUSB302_SetDataBit(data, FUSB302_REG_POWER, FUSB302_PWR_BANDGAP_WAKE, 1);
-
-        // Setup host current (default HUST_CUR=01b)
-        int hostCurValue;
-        switch (hostCurrentMode) {
-        case FUSB302_HOST_CURRENT_MODE_500MA:
-            hostCurValue = FUSB302_HOST_CUR_DEF_USB;
-            break;
-        case FUSB302_HOST_CURRENT_MODE_1_5A:
-            hostCurValue = FUSB302_HOST_CUR_1_5A;
-            break;
-        case FUSB302_HOST_CURRENT_MODE_3A:
-            hostCurValue = FUSB302_HOST_CUR_3A;
-            break;
-        default:
-            hostCurValue = FUSB302_HOST_CUR_DEF_USB;
-            break;
-        }
+    // Setup host current (default HOST_CUR=01b)
+    if (hostCurrentMode > FUSB302_HOST_CURRENT_MODE_3A) {
+        hostCurrentMode = FUSB302_HOST_CURRENT_MODE_500MA;
+    }
 
-        FUSB302_SetDataValue(data, FUSB302_REG_CONTROL0, FUSB302_HOST_CUR_BITS,
-                             FUSB302_HOST_CUR_OFFSET, hostCurValue);
-
-        // Setup VBUS measurement (MEAS_VBUS=0)
-        FUSB302_SetDataBit(data, FUSB302_REG_MEASURE, FUSB302_MEAS_VBUS, 0);
-
-        // Setup VCONN (VCONN_CC1=0, VCONN_CC2=0)
-        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC1, 0);
-        FUSB302_SetDataBit(data, FUSB302_REG_SWITCHES0, FUSB302_VCONN_CC2, 0);
-
-        // Setup interrupt mask (only I_TOGDONE and I_BC_LVL Interrupt)
-        // Mask Register = 0xFE
-        FUSB302_SetDataValue(data, FUSB302_REG_MASK, 0xFF, 0, ~FUSB302_M_BC_LVL);
-        // Maska Register = 0xBF
-        FUSB302_SetDataValue(data, FUSB302_REG_MASKA, 0xFF, 0, ~FUSB302_M_TOGDONE);
-        // Maskb Register = 0x01
-        FUSB302_SetDataBit(data, FUSB302_REG_MASKB, FUSB302_M_GCRCSENT, 1);
-
-        // TODO: check
-        // Set Rd only for TOGGLE
-        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOG_RD_ONLY, 1);
-
-        // TODO: check
-        // Enable host interrupts (INT_MASK=0)
-        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL0, FUSB302_INT_MASK, 0);
-    } else {
-        // Reset toggle mode (TOGGLE=0)
-        FUSB302_SetDataBit(data, FUSB302_REG_CONTROL2, FUSB302_TOGGLE, 0);
+    // Read status data to clear interrupt
+    if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_ALL)) {
+        return false;
     }
 
+    // Configure toggle mode (reset values are known, no read-back needed)
+    memcpy(data->controlRegData, toggleImage[mode - FUSB302_TOGGLE_MODE_DRP][hostCurrentMode],
+           FUSB302_REG_CONTROL_NUM);
+
     // Write control data
     if (!FUSB302_WriteControlData(platform, data, FUSB302_REG_ALL)) {
         return false;
@@ -25,6 +25,10 @@ typedef enum FUSB302_ToggleResult {
 
 bool FUSB302_SetupToggleMode(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                            FUSB302_ToggleMode_t mode, FUSB302_HostCurrentMode_t hostCurrentMode);
+// Restarts toggling without reset (chip configured by this driver, for example after a toggle
+// result or a detach)
+bool FUSB302_StartToggleMode(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                             FUSB302_ToggleMode_t mode, FUSB302_HostCurrentMode_t hostCurrentMode);
 bool FUSB302_GetToggleResult(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
                              FUSB302_ToggleResult_t *result);
 
@@ -0,0 +1,209 @@
+#include "FUSB302Trace.h"
+
+static int PutVarint(uint8_t *out, uint32_t value) {
+    int len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+static bool GetVarint(const uint8_t *stream, uint32_t streamLen, uint32_t *pos, uint32_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= streamLen) {
+            return false;
+        }
+        uint8_t byte = stream[(*pos)++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static FUSB302_CycleTime GetTime(FUSB302_Platform_t *platform) {
+    return platform->getCycleTime ? platform->getCycleTime() : 0;
+}
+
+static uint8_t *Reserve(FUSB302_Trace_t *trace, int len) {
+    if (trace->len + len > trace->size) {
+        if (!trace->flush) {
+            trace->dropped++;
+            return 0;
+        }
+        FUSB302_FlushTrace(trace);
+    }
+    return &trace->buffer[trace->len];
+}
+
+static int PutHead(FUSB302_Platform_t *platform, FUSB302_Trace_t *trace, uint8_t *out,
+                   uint8_t type) {
+    // Type and flags, time delta only if the clock moved by a full ms. The remainder below one ms
+    // stays in lastTime, so deltas add up to the platform clock.
+    FUSB302_CycleTime time = GetTime(platform);
+    FUSB302_TimeDiffMs diff = platform->getTimeDiffMs(time, trace->lastTime);
+    uint32_t delta = diff > 0 ? (uint32_t)diff : 0;
+    if (delta) {
+        trace->lastTime += delta * trace->ticksPerMs;
+    }
+
+    int len = 0;
+    out[len++] = type | (delta ? FUSB302_TRACE_FLAG_TIME : 0);
+    if (delta) {
+        len += PutVarint(&out[len], delta);
+    }
+    return len;
+}
+
+bool FUSB302_SetupTrace(FUSB302_Platform_t *platform, FUSB302_Trace_t *trace, uint8_t *buffer,
+                        uint32_t size, uint32_t ticksPerMs,
+                        void (*flush)(const uint8_t *buffer, uint32_t len)) {
+    if (size < FUSB302_TRACE_HEADER_SIZE + FUSB302_TRACE_MAX_RECORD || !ticksPerMs) {
+        return false;
+    }
+
+    trace->buffer = buffer;
+    trace->size = size;
+    trace->dropped = 0;
+    trace->flush = flush;
+    trace->ticksPerMs = ticksPerMs;
+    trace->lastTime = GetTime(platform);
+
+    buffer[0] = 'F';
+    buffer[1] = 'T';
+    buffer[2] = FUSB302_TRACE_VERSION;
+    for (int i = 0; i < 4; i++) {
+        buffer[3 + i] = (trace->lastTime >> (i * 8)) & 0xFF;
+        buffer[7 + i] = (ticksPerMs >> (i * 8)) & 0xFF;
+    }
+    trace->len = FUSB302_TRACE_HEADER_SIZE;
+
+    platform->trace = trace;
+    return true;
+}
+
+void FUSB302_FlushTrace(FUSB302_Trace_t *trace) {
+    // Stream continues in the emptied buffer, chunks concatenate to one stream
+    if (trace->flush && trace->len) {
+        trace->flush(trace->buffer, trace->len);
+    }
+    trace->len = 0;
+}
+
+void FUSB302_TraceAccess(FUSB302_Platform_t *platform, FUSB302_TraceType_t type, int reg,
+                         const uint8_t *data, int len, bool failed) {
+    FUSB302_Trace_t *trace = platform->trace;
+    if (!trace) {
+        return;
+    }
+
+    uint8_t *out = Reserve(trace, FUSB302_TRACE_MAX_RECORD);
+    if (!out) {
+        return;
+    }
+
+    int pos = PutHead(platform, trace, out, (uint8_t)type);
+    if (failed) {
+        out[0] |= FUSB302_TRACE_FLAG_FAILED;
+    }
+    out[pos++] = (uint8_t)reg;
+    if (!failed) {
+        out[pos++] = (uint8_t)len;
+        for (int i = 0; i < len; i++) {
+            out[pos++] = data[i];
+        }
+    }
+    trace->len += pos;
+}
+
+void FUSB302_TraceMark(FUSB302_Platform_t *platform, uint8_t tag, uint32_t value) {
+    FUSB302_Trace_t *trace = platform->trace;
+    if (!trace) {
+        return;
+    }
+
+    uint8_t *out = Reserve(trace, FUSB302_TRACE_MAX_RECORD);
+    if (!out) {
+        return;
+    }
+
+    int pos = PutHead(platform, trace, out, FUSB302_TRACE_MARK);
+    out[pos++] = tag;
+    pos += PutVarint(&out[pos], value);
+    trace->len += pos;
+}
+
+bool FUSB302_ReadTraceHeader(const uint8_t *stream, uint32_t streamLen, uint32_t *pos,
+                             FUSB302_CycleTime *baseTime, uint32_t *ticksPerMs) {
+    if (streamLen < FUSB302_TRACE_HEADER_SIZE || stream[0] != 'F' || stream[1] != 'T' ||
+        stream[2] != FUSB302_TRACE_VERSION) {
+        return false;
+    }
+
+    *baseTime = 0;
+    *ticksPerMs = 0;
+    for (int i = 0; i < 4; i++) {
+        *baseTime |= (FUSB302_CycleTime)stream[3 + i] << (i * 8);
+        *ticksPerMs |= (uint32_t)stream[7 + i] << (i * 8);
+    }
+    if (!*ticksPerMs) {
+        return false;
+    }
+    *pos = FUSB302_TRACE_HEADER_SIZE;
+    return true;
+}
+
+bool FUSB302_ReadTraceRecord(const uint8_t *stream, uint32_t streamLen, uint32_t *pos,
+                             uint32_t *timeMs, FUSB302_TraceRecord_t *record) {
+    uint32_t p = *pos;
+    if (p + 2 > streamLen) {
+        return false;
+    }
+
+    uint8_t head = stream[p++];
+    record->type = (FUSB302_TraceType_t)(head & 0x7);
+    record->failed = (head & FUSB302_TRACE_FLAG_FAILED) != 0;
+    if (record->type > FUSB302_TRACE_MARK) {
+        return false;
+    }
+
+    if (head & FUSB302_TRACE_FLAG_TIME) {
+        uint32_t delta;
+        if (!GetVarint(stream, streamLen, &p, &delta)) {
+            return false;
+        }
+        *timeMs += delta;
+    }
+    record->timeMs = *timeMs;
+
+    if (p >= streamLen) {
+        return false;
+    }
+    record->reg = stream[p++];
+    record->len = 0;
+    record->data = 0;
+    record->value = 0;
+
+    if (record->type == FUSB302_TRACE_MARK) {
+        if (!GetVarint(stream, streamLen, &p, &record->value)) {
+            return false;
+        }
+    } else if (!record->failed) {
+        if (p >= streamLen) {
+            return false;
+        }
+        record->len = stream[p++];
+        if (p + record->len > streamLen) {
+            return false;
+        }
+        record->data = &stream[p];
+        p += record->len;
+    }
+
+    *pos = p;
+    return true;
+}
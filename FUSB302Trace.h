@@ -0,0 +1,110 @@
+#ifndef FUSB302_TRACE_H
+#define FUSB302_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary capture of all FUSB302 accesses (RX FIFO drains, TX FIFO writes, register reads and
+// writes) and driver markers, for offline decoding and deterministic replay.
+//
+// Stream: header 'F' 'T' version, base time and tick rate, then records:
+//   base time                4 bytes LE, platform cycle time at setup
+//   ticks per ms             4 bytes LE, FUSB302_CycleTime units per ms
+//   type | flags             type in bits 0..2, FLAG_TIME, FLAG_FAILED
+//   [time delta]             varint, ms since previous record (FLAG_TIME)
+//   reg or tag               register (access) or marker tag
+//   len | value              access: length byte and data (not for failed accesses)
+//                            marker: varint value
+#define FUSB302_TRACE_VERSION 2
+#define FUSB302_TRACE_HEADER_SIZE 11
+
+#define FUSB302_TRACE_FLAG_TIME (1 << 3)
+#define FUSB302_TRACE_FLAG_FAILED (1 << 4)
+
+// Longest record: type, time, reg, len, 255 bytes of data
+#define FUSB302_TRACE_MAX_RECORD (1 + 5 + 1 + 1 + 255)
+
+typedef enum FUSB302_TraceType {
+    FUSB302_TRACE_RX,    // RX FIFO read
+    FUSB302_TRACE_TX,    // TX FIFO write
+    FUSB302_TRACE_READ,  // register read (status and interrupt snapshots)
+    FUSB302_TRACE_WRITE, // register write
+    FUSB302_TRACE_MARK,  // driver or application marker
+} FUSB302_TraceType_t;
+
+// Marker tags of the driver entry points, value: time argument of the call (cycle time). Inputs
+// that do not show in the register accesses follow as ARG marks before the first access, results
+// of application callbacks as RESULT marks where the callback returns. Calls made by other marked
+// calls (host and sink monitoring under DRP) are marked as well.
+typedef enum FUSB302_TraceMark {
+    FUSB302_TRACE_MARK_HOST_SETUP,           // plus host current mode
+    FUSB302_TRACE_MARK_HOST_UPDATE = 4,
+    FUSB302_TRACE_MARK_HOST_CURRENT,         // value: host current mode
+    FUSB302_TRACE_MARK_HOST_CURRENT_CAP,     // value: host current cap
+    FUSB302_TRACE_MARK_SINK_SETUP,
+    FUSB302_TRACE_MARK_SINK_START,
+    FUSB302_TRACE_MARK_SINK_UPDATE,
+    FUSB302_TRACE_MARK_DRP_SETUP,            // plus host current mode, ARG: preference
+    FUSB302_TRACE_MARK_DRP_UPDATE = 14,
+    FUSB302_TRACE_MARK_TX_UPDATE,            // plus collision avoidance
+    FUSB302_TRACE_MARK_SOURCE_UPDATE = 17,   // ARG: PDOs when a source starts on attach
+    FUSB302_TRACE_MARK_DISCOVERY_UPDATE,     // ARG: enterSvid << 16 | message << 1 | sopAllowed,
+                                             // message: sop << 16 | header, objects
+    FUSB302_TRACE_MARK_ARG = 0x40,           // value: further input of the call
+    FUSB302_TRACE_MARK_RESULT,               // value: result of a source power callback
+    FUSB302_TRACE_MARK_USER = 0x80,          // application tags from here on
+} FUSB302_TraceMark_t;
+
+struct FUSB302_Trace {
+    uint8_t *buffer;
+    uint32_t size;
+    uint32_t len;
+    uint32_t ticksPerMs;
+    FUSB302_CycleTime lastTime; // cycle time of the last full ms recorded
+    uint32_t dropped; // records lost on a full buffer without flush callback
+
+    // Optional (may be 0): called with the filled buffer when the next record does not fit
+    void (*flush)(const uint8_t *buffer, uint32_t len);
+};
+
+typedef struct FUSB302_TraceRecord {
+    FUSB302_TraceType_t type;
+    uint32_t timeMs; // ms since the start of the stream
+    bool failed;
+    uint8_t reg; // register or marker tag
+    uint8_t len;
+    const uint8_t *data;
+    uint32_t value; // marker value
+} FUSB302_TraceRecord_t;
+
+// Starts a new stream in buffer (size >= FUSB302_TRACE_HEADER_SIZE + FUSB302_TRACE_MAX_RECORD)
+// and enables capture on the platform. ticksPerMs: cycle time units per ms of the platform clock
+// (1 for a ms counter), a 32 bit counter is assumed.
+bool FUSB302_SetupTrace(FUSB302_Platform_t *platform, FUSB302_Trace_t *trace, uint8_t *buffer,
+                        uint32_t size, uint32_t ticksPerMs,
+                        void (*flush)(const uint8_t *buffer, uint32_t len));
+void FUSB302_FlushTrace(FUSB302_Trace_t *trace);
+
+// Called by the driver for every platform I2C access and marker, no-op without trace
+void FUSB302_TraceAccess(FUSB302_Platform_t *platform, FUSB302_TraceType_t type, int reg,
+                         const uint8_t *data, int len, bool failed);
+void FUSB302_TraceMark(FUSB302_Platform_t *platform, uint8_t tag, uint32_t value);
+
+// Decoding: header first, then records until false (end of stream or corrupt record). timeMs
+// starts at 0 and is advanced by every record.
+bool FUSB302_ReadTraceHeader(const uint8_t *stream, uint32_t streamLen, uint32_t *pos,
+                             FUSB302_CycleTime *baseTime, uint32_t *ticksPerMs);
+bool FUSB302_ReadTraceRecord(const uint8_t *stream, uint32_t streamLen, uint32_t *pos,
+                             uint32_t *timeMs, FUSB302_TraceRecord_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_TRACE_H
@@ -0,0 +1,353 @@
+#include "FUSB302Tx.h"
+#include "FUSB302Trace.h"
+
+static void SetResult(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                      FUSB302_TxResult_t result) {
+    // Pending while the sender has more messages queued
+    for (int i = 0; i < scheduler->count; i++) {
+        if (scheduler->queue[i].sender == sender) {
+            result = FUSB302_TX_RESULT_PENDING;
+        }
+    }
+    scheduler->results[sender] = result;
+}
+
+static void PopMessage(FUSB302_TxScheduler_t *scheduler, FUSB302_TxResult_t result) {
+    FUSB302_TxSender_t sender = scheduler->queue[0].sender;
+    for (int i = 1; i < scheduler->count; i++) {
+        scheduler->queue[i - 1] = scheduler->queue[i];
+    }
+    scheduler->count--;
+    scheduler->inFlight = false;
+    scheduler->attempts = 0;
+    scheduler->waitMs = 0;
+    SetResult(scheduler, sender, result);
+}
+
+static void DropMessages(FUSB302_TxScheduler_t *scheduler, int from) {
+    int count = scheduler->count;
+    scheduler->counters.failed += count - from;
+    scheduler->count = from;
+    for (int i = from; i < count; i++) {
+        SetResult(scheduler, scheduler->queue[i].sender, FUSB302_TX_RESULT_FAILED);
+    }
+}
+
+static bool SendRequest(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                        FUSB302_Protocol_t *protocol, const FUSB302_TxRequest_t *request) {
+    switch (request->kind) {
+    case FUSB302_TX_KIND_EXTENDED:
+        return FUSB302_ProtocolSendExtended(platform, data, protocol, request->sop,
+                                            request->messageType, request->payload,
+                                            request->dataSize, request->chunked,
+                                            request->chunkNumber);
+    case FUSB302_TX_KIND_CHUNK_REQUEST:
+        return FUSB302_ProtocolSendChunkRequest(platform, data, protocol, request->sop,
+                                                request->messageType, request->chunkNumber);
+    case FUSB302_TX_KIND_MESSAGE:
+    default:
+        return FUSB302_ProtocolSend(platform, data, protocol, request->sop, request->messageType,
+                                    request->objects, request->numObjects);
+    }
+}
+
+static bool SetSinkTxNG(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                        FUSB302_HostMonitoring_t *monitoring, FUSB302_TxScheduler_t *scheduler,
+                        bool sinkTxNG) {
+    // SinkTxNG: Rp capped to 1.5 A, SinkTxOk: back to the Rp setting (3 A)
+    if (!FUSB302_SetHostCurrentCap(platform, data, monitoring,
+                                   sinkTxNG ? FUSB302_HOST_CURRENT_MODE_1_5A
+                                            : FUSB302_HOST_CURRENT_MODE_3A)) {
+        return false;
+    }
+
+    scheduler->sinkTxNG = sinkTxNG;
+
+#ifdef FUSB302_DEBUG_1
+    platform->debugPrint("FUSB302: Rp %s\r\n", sinkTxNG ? "SinkTxNG" : "SinkTxOk");
+#endif
+
+    return true;
+}
+
+void FUSB302_SetupTxScheduler(FUSB302_TxScheduler_t *scheduler, bool collisionAvoidance) {
+    scheduler->count = 0;
+    for (int i = 0; i < FUSB302_TX_SENDER_NUM; i++) {
+        scheduler->results[i] = FUSB302_TX_RESULT_NONE;
+    }
+    scheduler->inFlight = false;
+    scheduler->attempts = 0;
+    scheduler->messageId = 0;
+    scheduler->time = 0;
+    scheduler->waitMs = 0;
+    scheduler->collisionAvoidance = collisionAvoidance;
+    scheduler->sinkTxNG = false;
+    scheduler->amsSenders = 0;
+    scheduler->counters.sent = 0;
+    scheduler->counters.failed = 0;
+    scheduler->counters.collisions = 0;
+    scheduler->counters.deferrals = 0;
+    scheduler->counters.overflows = 0;
+}
+
+static FUSB302_TxRequest_t *InsertRequest(FUSB302_TxScheduler_t *scheduler,
+                                          FUSB302_TxSender_t sender, FUSB302_SOP_t sop,
+                                          uint8_t messageType, FUSB302_TxPriority_t priority) {
+    if (scheduler->count >= FUSB302_TX_QUEUE_SIZE) {
+        scheduler->counters.overflows++;
+        SetResult(scheduler, sender, FUSB302_TX_RESULT_FAILED);
+        return 0;
+    }
+
+    // Insert behind messages of same or higher priority, never ahead of the one in flight
+    int pos = scheduler->count;
+    while (pos > (scheduler->inFlight ? 1 : 0) && scheduler->queue[pos - 1].priority > priority) {
+        scheduler->queue[pos] = scheduler->queue[pos - 1];
+        pos--;
+    }
+
+    FUSB302_TxRequest_t *request = &scheduler->queue[pos];
+    request->sender = sender;
+    request->kind = FUSB302_TX_KIND_MESSAGE;
+    request->sop = sop;
+    request->messageType = messageType;
+    request->numObjects = 0;
+    request->priority = priority;
+    request->payload = 0;
+    request->dataSize = 0;
+    request->chunkNumber = 0;
+    request->chunked = false;
+    scheduler->count++;
+    scheduler->results[sender] = FUSB302_TX_RESULT_PENDING;
+
+    return request;
+}
+
+bool FUSB302_QueueMessage(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                          FUSB302_SOP_t sop, uint8_t messageType, const uint32_t *objects,
+                          int numObjects, FUSB302_TxPriority_t priority) {
+    if (sender >= FUSB302_TX_SENDER_NUM || sop >= FUSB302_PROTOCOL_NUM_SOP || numObjects < 0 ||
+        numObjects > FUSB302_PD_MAX_DATA_OBJECTS) {
+        return false;
+    }
+
+    FUSB302_TxRequest_t *request = InsertRequest(scheduler, sender, sop, messageType, priority);
+    if (!request) {
+        return false;
+    }
+
+    request->numObjects = numObjects;
+    for (int i = 0; i < numObjects; i++) {
+        request->objects[i] = objects[i];
+    }
+
+    return true;
+}
+
+bool FUSB302_QueueExtendedMessage(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                                  FUSB302_SOP_t sop, uint8_t messageType, const uint8_t *payload,
+                                  int dataSize, bool chunked, int chunkNumber,
+                                  FUSB302_TxPriority_t priority) {
+    if (sender >= FUSB302_TX_SENDER_NUM || sop >= FUSB302_PROTOCOL_NUM_SOP || dataSize < 0 ||
+        dataSize > FUSB302_PD_MAX_EXTENDED_LEN || chunkNumber < 0 || chunkNumber > 0xF ||
+        (!chunked && chunkNumber)) {
+        return false;
+    }
+
+    FUSB302_TxRequest_t *request = InsertRequest(scheduler, sender, sop, messageType, priority);
+    if (!request) {
+        return false;
+    }
+
+    request->kind = FUSB302_TX_KIND_EXTENDED;
+    request->payload = payload;
+    request->dataSize = dataSize;
+    request->chunkNumber = chunkNumber;
+    request->chunked = chunked;
+
+    return true;
+}
+
+bool FUSB302_QueueChunkRequest(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                               const FUSB302_ExtendedMessage_t *extended, int chunkNumber) {
+    if (sender >= FUSB302_TX_SENDER_NUM || extended->sop >= FUSB302_PROTOCOL_NUM_SOP ||
+        chunkNumber < 0 || chunkNumber > 0xF) {
+        return false;
+    }
+
+    FUSB302_TxRequest_t *request = InsertRequest(scheduler, sender, extended->sop,
+                                                 extended->messageType, FUSB302_TX_PRIORITY_HIGH);
+    if (!request) {
+        return false;
+    }
+
+    request->kind = FUSB302_TX_KIND_CHUNK_REQUEST;
+    request->chunkNumber = chunkNumber;
+    request->chunked = true;
+
+    return true;
+}
+
+void FUSB302_BeginAMS(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender) {
+    if (sender < FUSB302_TX_SENDER_NUM) {
+        scheduler->amsSenders |= 1u << sender;
+    }
+}
+
+void FUSB302_EndAMS(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender) {
+    if (sender < FUSB302_TX_SENDER_NUM) {
+        scheduler->amsSenders &= ~(1u << sender);
+    }
+}
+
+void FUSB302_ClearTxQueue(FUSB302_TxScheduler_t *scheduler) {
+    DropMessages(scheduler, scheduler->inFlight ? 1 : 0);
+}
+
+bool FUSB302_UpdateTxScheduler(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                               FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                               FUSB302_TxScheduler_t *scheduler) {
+    bool ok = true;
+    FUSB302_Protocol_t *protocol = &monitoring->protocol;
+
+    // Mark the call for replay
+    if (platform->trace) {
+        FUSB302_TraceMark(platform, FUSB302_TRACE_MARK_TX_UPDATE + scheduler->collisionAvoidance,
+                          time);
+    }
+
+    // Queued messages are obsolete after detach or reset (MessageID restarts, the engines queue
+    // their responses after this update)
+    bool attached = FUSB302_IsDeviceAttached(monitoring) ||
+                    FUSB302_IsActiveCableAttached(monitoring);
+    if (!attached || FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_HARDRST) ||
+        FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_SOFTRST)) {
+        DropMessages(scheduler, 0);
+        scheduler->amsSenders = 0;
+        scheduler->inFlight = false;
+        scheduler->attempts = 0;
+        scheduler->waitMs = 0;
+        if (scheduler->sinkTxNG) {
+            ok &= SetSinkTxNG(platform, data, monitoring, scheduler, false);
+        }
+        return ok;
+    }
+
+    FUSB302_TimeDiffMs elapsed = platform->getTimeDiffMs(time, scheduler->time);
+
+    // BMC activity without own transmission: the partner sent, its message is handled first
+    bool partnerActivity = !scheduler->inFlight &&
+                           FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_ACTIVITY);
+
+    // Result of previous transmission (interrupts from the monitoring burst)
+    if (scheduler->inFlight) {
+        FUSB302_TxRequest_t *request = &scheduler->queue[0];
+
+        if (FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPT, FUSB302_I_COLLISION)) {
+            // Nothing was sent, retry with the same MessageID after backoff
+            scheduler->counters.collisions++;
+            scheduler->inFlight = false;
+            protocol->txMessageId[request->sop] = scheduler->messageId;
+            if (scheduler->attempts >= FUSB302_TX_MAX_ATTEMPTS) {
+                scheduler->counters.failed++;
+                PopMessage(scheduler, FUSB302_TX_RESULT_FAILED);
+            } else {
+                scheduler->time = time;
+                scheduler->waitMs = FUSB302_TX_BACKOFF_MS << (scheduler->attempts - 1);
+            }
+            return ok;
+        } else if (FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_TXSENT)) {
+            scheduler->counters.sent++;
+            PopMessage(scheduler, FUSB302_TX_RESULT_SENT);
+        } else if (FUSB302_GetDataBit(data, FUSB302_REG_INTERRUPTA, FUSB302_I_RETRYFAIL) ||
+                   elapsed >= FUSB302_TX_TIMEOUT_MS) {
+            scheduler->counters.failed++;
+            PopMessage(scheduler, FUSB302_TX_RESULT_FAILED);
+        } else {
+            return ok;
+        }
+
+        elapsed = 0;
+    }
+
+    if (!scheduler->count) {
+        // AMS done, sink may initiate again (not while waiting for the partner's response)
+        if (scheduler->sinkTxNG && !scheduler->amsSenders) {
+            ok &= SetSinkTxNG(platform, data, monitoring, scheduler, false);
+        }
+        return ok;
+    }
+
+    if (elapsed < scheduler->waitMs) {
+        return ok;
+    }
+
+    FUSB302_TxRequest_t *request = &scheduler->queue[0];
+
+    // Source initiating an AMS: signal SinkTxNG and give the sink tSinkTx to finish its own
+    // transmission (responses do not wait). PD 2.0 sinks do not know SinkTxNG, Rp below 3 A is
+    // SinkTxNG already.
+    if (scheduler->collisionAvoidance && !scheduler->sinkTxNG &&
+        request->priority != FUSB302_TX_PRIORITY_HIGH &&
+        monitoring->protocol.specRevision >= FUSB302_PD_SPEC_REV_3_0 &&
+        monitoring->hostCurrentSetting == FUSB302_HOST_CURRENT_MODE_3A) {
+        ok &= SetSinkTxNG(platform, data, monitoring, scheduler, true);
+        scheduler->time = time;
+        scheduler->waitMs = FUSB302_T_SINK_TX_MS;
+        return ok;
+    }
+
+    // Do not start while a BMC message is on CC, the chip would report a collision
+    if (!FUSB302_ReadStatusData(platform, data, FUSB302_REG_STATUS0)) {
+        return false;
+    }
+    if (partnerActivity || FUSB302_GetDataBit(data, FUSB302_REG_STATUS0, FUSB302_ACTIVITY)) {
+        scheduler->counters.deferrals++;
+        scheduler->time = time;
+        scheduler->waitMs = FUSB302_TX_BACKOFF_MS;
+        return ok;
+    }
+
+    if (scheduler->attempts == 0) {
+        scheduler->messageId = protocol->txMessageId[request->sop];
+    } else {
+        protocol->txMessageId[request->sop] = scheduler->messageId;
+    }
+
+    scheduler->attempts++;
+    scheduler->time = time;
+
+#ifdef FUSB302_DEBUG_1
+    platform->debugPrint("FUSB302: TX type %d SOP%d attempt %d\r\n", request->messageType,
+                         request->sop, scheduler->attempts);
+#endif
+
+    if (SendRequest(platform, data, protocol, request)) {
+        scheduler->inFlight = true;
+    } else {
+        // FIFO write failed, retry after backoff unless attempts are exhausted
+        ok = false;
+        protocol->txMessageId[request->sop] = scheduler->messageId;
+        if (scheduler->attempts >= FUSB302_TX_MAX_ATTEMPTS) {
+            scheduler->counters.failed++;
+            PopMessage(scheduler, FUSB302_TX_RESULT_FAILED);
+        } else {
+            scheduler->waitMs = FUSB302_TX_BACKOFF_MS;
+        }
+    }
+
+    return ok;
+}
+
+bool FUSB302_IsTxBusy(FUSB302_TxScheduler_t *scheduler) {
+    return scheduler->count > 0 || scheduler->sinkTxNG;
+}
+
+FUSB302_TxResult_t FUSB302_GetTxResult(FUSB302_TxScheduler_t *scheduler,
+                                       FUSB302_TxSender_t sender) {
+    if (sender >= FUSB302_TX_SENDER_NUM) {
+        return FUSB302_TX_RESULT_NONE;
+    }
+
+    return scheduler->results[sender];
+}
@@ -0,0 +1,149 @@
+#ifndef FUSB302_TX_H
+#define FUSB302_TX_H
+
+#include "FUSB302.h"
+#include "FUSB302Host.h"
+#include "FUSB302PD.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued messages per port
+#ifndef FUSB302_TX_QUEUE_SIZE
+#define FUSB302_TX_QUEUE_SIZE 4
+#endif
+
+// Collision backoff, doubled on every collision of the same message
+#ifndef FUSB302_TX_BACKOFF_MS
+#define FUSB302_TX_BACKOFF_MS 1
+#endif
+#ifndef FUSB302_TX_MAX_ATTEMPTS
+#define FUSB302_TX_MAX_ATTEMPTS 4
+#endif
+
+// Transmission result not seen (I_TXSENT / I_RETRYFAIL / I_COLLISION) after this time
+#ifndef FUSB302_TX_TIMEOUT_MS
+#define FUSB302_TX_TIMEOUT_MS 10
+#endif
+
+// PD 3.0 collision avoidance: source waits tSinkTx (16..20 ms) after SinkTxNG before an AMS
+#ifndef FUSB302_T_SINK_TX_MS
+#define FUSB302_T_SINK_TX_MS 16
+#endif
+
+typedef enum FUSB302_TxPriority {
+    FUSB302_TX_PRIORITY_HIGH,   // responses and resets, sent before anything else
+    FUSB302_TX_PRIORITY_NORMAL, // AMS initiators (capabilities, requests)
+    FUSB302_TX_PRIORITY_LOW,    // discovery and vendor messages
+} FUSB302_TxPriority_t;
+
+// Engine that queued a message, I_TXSENT / I_RETRYFAIL are reported back to it
+typedef enum FUSB302_TxSender {
+    FUSB302_TX_SENDER_APPLICATION,
+    FUSB302_TX_SENDER_SOURCE,
+    FUSB302_TX_SENDER_DISCOVERY,
+    FUSB302_TX_SENDER_NUM,
+} FUSB302_TxSender_t;
+
+typedef enum FUSB302_TxResult {
+    FUSB302_TX_RESULT_NONE,    // nothing queued yet
+    FUSB302_TX_RESULT_PENDING, // queued or in flight
+    FUSB302_TX_RESULT_SENT,    // acknowledged by GoodCRC
+    FUSB302_TX_RESULT_FAILED,  // no GoodCRC, attempts exhausted, queue full or dropped on reset
+} FUSB302_TxResult_t;
+
+typedef enum FUSB302_TxKind {
+    FUSB302_TX_KIND_MESSAGE,       // control or data message, objects
+    FUSB302_TX_KIND_EXTENDED,      // extended message chunk or unchunked data, payload
+    FUSB302_TX_KIND_CHUNK_REQUEST, // Chunk Request for chunkNumber of a received message
+} FUSB302_TxKind_t;
+
+typedef struct FUSB302_TxRequest {
+    FUSB302_TxSender_t sender;
+    FUSB302_TxKind_t kind;
+    FUSB302_SOP_t sop;
+    uint8_t messageType;
+    uint8_t numObjects;
+    FUSB302_TxPriority_t priority;
+    uint32_t objects[FUSB302_PD_MAX_DATA_OBJECTS];
+
+    // Extended messages and Chunk Requests
+    const uint8_t *payload; // not copied, kept by the sender until its result is final
+    uint16_t dataSize;
+    uint8_t chunkNumber;
+    bool chunked;
+} FUSB302_TxRequest_t;
+
+typedef struct FUSB302_TxCounters {
+    uint32_t sent;       // acknowledged by GoodCRC
+    uint32_t failed;     // no GoodCRC after hardware retries, attempts exhausted or timeout
+    uint32_t collisions; // I_COLLISION, message not transmitted
+    uint32_t deferrals;  // transmission postponed because CC was busy
+    uint32_t overflows;  // queue full
+} FUSB302_TxCounters_t;
+
+typedef struct FUSB302_TxScheduler {
+    FUSB302_TxRequest_t queue[FUSB302_TX_QUEUE_SIZE]; // sorted by priority, FIFO within priority
+    uint8_t count;
+    FUSB302_TxResult_t results[FUSB302_TX_SENDER_NUM]; // last message queued by each sender
+
+    bool inFlight;             // queue[0] written to FIFO, waiting for result
+    uint8_t attempts;          // transmissions of queue[0]
+    uint8_t messageId;         // MessageID of queue[0], reused after collision
+    FUSB302_CycleTime time;    // start of backoff, SinkTxNG wait or transmission
+    FUSB302_TimeDiffMs waitMs; // backoff before next attempt
+
+    bool collisionAvoidance; // PD 3.0 SinkTxOk (Rp 3 A) / SinkTxNG (Rp 1.5 A), source only
+    bool sinkTxNG;           // Rp capped to SinkTxNG for the queued AMS
+    uint8_t amsSenders;      // engines with an AMS in progress (bit per sender)
+
+    FUSB302_TxCounters_t counters;
+} FUSB302_TxScheduler_t;
+
+// Collision avoidance applies while the Rp setting is FUSB302_HOST_CURRENT_MODE_3A and the
+// negotiated revision is PD 3.0 (FUSB302_PD_SPEC_REV), SinkTxNG is a cap on top of the setting
+void FUSB302_SetupTxScheduler(FUSB302_TxScheduler_t *scheduler, bool collisionAvoidance);
+
+// Queues a message, its result is kept per sender (FUSB302_GetTxResult)
+bool FUSB302_QueueMessage(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                          FUSB302_SOP_t sop, uint8_t messageType, const uint32_t *objects,
+                          int numObjects, FUSB302_TxPriority_t priority);
+// Queues one chunk (chunked) or the whole data (unchunked) of an extended message, answers to
+// Chunk Requests (FUSB302_GetChunkRequest) use FUSB302_TX_PRIORITY_HIGH
+bool FUSB302_QueueExtendedMessage(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                                  FUSB302_SOP_t sop, uint8_t messageType, const uint8_t *payload,
+                                  int dataSize, bool chunked, int chunkNumber,
+                                  FUSB302_TxPriority_t priority);
+// Queues the Chunk Request for nextChunk of FUSB302_ProtocolReceiveExtended, sent before anything
+// else like other responses
+bool FUSB302_QueueChunkRequest(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender,
+                               const FUSB302_ExtendedMessage_t *extended, int chunkNumber);
+// An engine initiating an AMS (Source_Capabilities, VDM request) begins it before queueing the
+// first message and ends it after the last one or when the AMS is abandoned. SinkTxNG is held
+// from the first message until every AMS has ended and the queue is empty, also while waiting for
+// the partner's response. Detach and resets end all of them.
+void FUSB302_BeginAMS(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender);
+void FUSB302_EndAMS(FUSB302_TxScheduler_t *scheduler, FUSB302_TxSender_t sender);
+// Drops queued messages (hard reset sent), the one in flight still reports its result
+void FUSB302_ClearTxQueue(FUSB302_TxScheduler_t *scheduler);
+
+// Call right after FUSB302_UpdateHostMonitoring with the same data, uses its interrupt burst,
+// then the engines queueing messages (source, discovery). All messages of the port must be sent
+// through the scheduler, so I_TXSENT / I_RETRYFAIL belong to the message in flight; only the
+// blocking e-marker discovery of host monitoring sends directly, while no device is attached.
+// Must be called periodically while FUSB302_IsTxBusy returns true. Queued messages are sent in
+// order of priority when CC is idle; SinkTxNG is held until the AMS ends (FUSB302_EndAMS).
+bool FUSB302_UpdateTxScheduler(FUSB302_Platform_t *platform, FUSB302_Data_t *data,
+                               FUSB302_CycleTime time, FUSB302_HostMonitoring_t *monitoring,
+                               FUSB302_TxScheduler_t *scheduler);
+
+bool FUSB302_IsTxBusy(FUSB302_TxScheduler_t *scheduler);
+FUSB302_TxResult_t FUSB302_GetTxResult(FUSB302_TxScheduler_t *scheduler,
+                                       FUSB302_TxSender_t sender);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_TX_H
@@ -0,0 +1,660 @@
+// Fleet benchmark of host monitoring: many simulated FUSB302 ports (FUSB302Model) driven through
+// FUSB302_UpdateHostMonitoring under plug churn. Prints one JSON object per workload to stdout.
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302Model.c FUSB302Bench.c -o fusb302-bench
+//   ./fusb302-bench --ports 1000 --duration-ms 20000 --workload all > results.jsonl
+//
+// Options: --ports N, --duration-ms N (virtual time), --period-ms N (update period),
+// --seed N, --workload plug|cable|cable-device|noisy|all, --trace FILE (capture port 0 of a single
+// workload for FUSB302TraceReplay), --export PATH (publish all ports to shared memory for
+// FUSB302StatusMonitor), --budget-ma N (shared supply managed by FUSB302Budget, default: every
+// port fixed at 1.5 A), --brownout-ms N (chip resets at random intervals of about N ms per port,
+// recovery_ms is the time until the driver restored the chip), --stack host|pd (pd: Tx scheduler,
+// source and discovery follow every host monitoring update, devices are PD sinks)
+//
+// Time seen by the driver is virtual (delays advance the port clock), update_ns is the host CPU
+// time of one FUSB302_UpdateHostMonitoring call including the register model.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FUSB302Budget.h"
+#include "FUSB302Discovery.h"
+#include "FUSB302Export.h"
+#include "FUSB302Host.h"
+#include "FUSB302Model.h"
+#include "FUSB302Pool.h"
+#include "FUSB302Profile.h"
+#include "FUSB302Source.h"
+#include "FUSB302Trace.h"
+#include "FUSB302Tx.h"
+
+#define BENCH_VERSION 1
+
+// Plug cycle: attached hold, then detached hold (plus random jitter)
+#define ATTACHED_HOLD_MS 400
+#define DETACHED_HOLD_MS 250
+#define HOLD_JITTER_MS 100
+
+// Noisy insertion: contact bounces before the termination settles
+#define NOISY_MIN_BOUNCES 3
+#define NOISY_MAX_BOUNCES 8
+#define NOISY_MAX_BOUNCE_MS 4
+
+// Log-linear histogram: 8 sub-buckets per power of two
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB)
+
+#define TRACE_BUFFER_SIZE 4096
+
+typedef enum Workload {
+    WORKLOAD_PLUG,         // device (Rd) on a random CC pin
+    WORKLOAD_CABLE,        // e-marked cable without device (Ra)
+    WORKLOAD_CABLE_DEVICE, // e-marked cable with device (Rd + Ra)
+    WORKLOAD_NOISY,        // device with contact bounce on insertion
+    WORKLOAD_NUM,
+} Workload_t;
+
+static const char *workloadNames[WORKLOAD_NUM] = {"plug", "cable", "cable-device", "noisy"};
+
+static const FUSB302_HostState_t expectedStates[WORKLOAD_NUM] = {
+    FUSB302_HOST_STATE_ATTACHED_DEVICE,
+    FUSB302_HOST_STATE_ATTACHED_CABLE,
+    FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE,
+    FUSB302_HOST_STATE_ATTACHED_DEVICE,
+};
+
+typedef struct Histogram {
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[HIST_BUCKETS];
+} Histogram_t;
+
+typedef struct Port {
+    FUSB302_Model_t model;
+    FUSB302_Platform_t platform;
+    FUSB302_Data_t data;
+    FUSB302_BufferPool_t pool;
+    FUSB302_HostMonitoring_t monitoring;
+    FUSB302_Profile_t profile;
+    FUSB302_TxScheduler_t scheduler;
+    FUSB302_Source_t source;
+    FUSB302_Discovery_t discovery;
+
+    bool attached;
+    int pin;     // CC pin of the device (Rd)
+    int bounces; // pending contact bounces
+    uint64_t nextEventUs;
+    uint64_t nextBrownoutUs;
+    uint64_t brownoutUs; // time of the pending brownout (0: none)
+    uint32_t chipResets; // restored chip resets seen so far
+    uint32_t rng;
+} Port_t;
+
+typedef struct Options {
+    int ports;
+    int durationMs;
+    int periodMs;
+    uint32_t seed;
+    int workload; // WORKLOAD_NUM: all
+    const char *traceFile;
+    const char *exportFile;
+    int budgetMa;   // 0: no budget
+    int brownoutMs; // 0: no brownouts
+    bool pd;        // PD engines after host monitoring
+} Options_t;
+
+typedef struct Result {
+    uint64_t updates;
+    uint64_t events;
+    uint64_t eventUpdates;
+    uint64_t errors;      // failed updates
+    uint64_t stateErrors; // wrong state at the end of an attached hold
+    uint64_t eventI2C;
+    uint64_t idleI2C;
+    uint64_t delayUs;
+    uint64_t cpuNs;
+    uint64_t attachedTicks;   // attached ports summed over update periods
+    uint64_t attachedMa;      // advertised current of attached ports, summed likewise
+    uint64_t overcommits;     // periods with advertised plus released current above the budget
+    uint32_t rpChanges;
+    uint64_t brownouts;
+    uint64_t chipResets;
+    uint64_t recoveryMaxUs; // brownout to restored chip
+    Histogram_t updateNs;
+    Histogram_t eventUpdateNs;
+    FUSB302_LatencyHistogram_t latency[FUSB302_LATENCY_NUM];
+} Result_t;
+
+static FUSB302_ExportRegion_t *exportRegion;
+static FILE *traceFile;
+static FUSB302_Trace_t trace;
+static uint8_t traceBuffer[TRACE_BUFFER_SIZE];
+
+static void FlushTrace(const uint8_t *buffer, uint32_t len) {
+    fwrite(buffer, 1, len, traceFile);
+}
+
+static uint32_t Random(uint32_t *state) {
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static uint64_t NowNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int HistogramIndex(uint64_t value) {
+    if (value < HIST_SUB) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (exponent - HIST_SUB_BITS)) & (HIST_SUB - 1));
+    return (exponent - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+static uint64_t HistogramValue(int index) {
+    // Upper bound of the bucket
+    if (index < HIST_SUB) {
+        return index;
+    }
+    int exponent = index / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t sub = index % HIST_SUB;
+    return ((HIST_SUB + sub + 1) << (exponent - HIST_SUB_BITS)) - 1;
+}
+
+static void HistogramAdd(Histogram_t *histogram, uint64_t value) {
+    histogram->buckets[HistogramIndex(value)]++;
+    histogram->count++;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+static uint64_t HistogramPercentile(const Histogram_t *histogram, double percent) {
+    uint64_t rank = (uint64_t)(histogram->count * percent / 100.0);
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > rank) {
+            uint64_t value = HistogramValue(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+static void MergeLatency(FUSB302_LatencyHistogram_t *total, const FUSB302_LatencyHistogram_t *h) {
+    if (!h->count) {
+        return;
+    }
+    if (!total->count || h->min < total->min) {
+        total->min = h->min;
+    }
+    if (!total->count || h->max > total->max) {
+        total->max = h->max;
+    }
+    total->count += h->count;
+    for (int i = 0; i < FUSB302_LATENCY_BUCKETS; i++) {
+        total->buckets[i] += h->buckets[i];
+    }
+}
+
+static void SetTermination(Port_t *port, Workload_t workload, bool attached) {
+    FUSB302_Model_t *model = &port->model;
+    model->cc[0] = FUSB302_MODEL_TERM_OPEN;
+    model->cc[1] = FUSB302_MODEL_TERM_OPEN;
+    if (!attached) {
+        return;
+    }
+
+    // Cable Ra is on the pin opposite to the device
+    if (workload != WORKLOAD_CABLE) {
+        model->cc[port->pin] = FUSB302_MODEL_TERM_RD;
+    }
+    if (workload == WORKLOAD_CABLE || workload == WORKLOAD_CABLE_DEVICE) {
+        model->cc[!port->pin] = FUSB302_MODEL_TERM_RA;
+    }
+}
+
+static uint64_t HoldUs(Port_t *port, int holdMs) {
+    return (uint64_t)(holdMs + Random(&port->rng) % HOLD_JITTER_MS) * 1000;
+}
+
+static void RunEvents(Port_t *port, Workload_t workload, uint64_t nowUs, Result_t *result) {
+    if (nowUs < port->nextEventUs) {
+        return;
+    }
+
+    if (port->bounces > 0) {
+        // Contact bounce: toggle the device termination for a few ms
+        port->bounces--;
+        bool connected = port->bounces % 2 == 0;
+        SetTermination(port, workload, connected);
+        port->nextEventUs = nowUs + (1 + Random(&port->rng) % NOISY_MAX_BOUNCE_MS) * 1000;
+        if (!port->bounces) {
+            port->nextEventUs = nowUs + HoldUs(port, ATTACHED_HOLD_MS);
+        }
+        return;
+    }
+
+    if (port->attached) {
+        // End of attached hold, state must be settled by now
+        if (port->monitoring.state != expectedStates[workload]) {
+            result->stateErrors++;
+        }
+        port->attached = false;
+        SetTermination(port, workload, false);
+        port->nextEventUs = nowUs + HoldUs(port, DETACHED_HOLD_MS);
+    } else {
+        port->attached = true;
+        port->pin = Random(&port->rng) & 1;
+        SetTermination(port, workload, true);
+        port->nextEventUs = nowUs + HoldUs(port, ATTACHED_HOLD_MS);
+        if (workload == WORKLOAD_NOISY) {
+            int range = NOISY_MAX_BOUNCES - NOISY_MIN_BOUNCES + 1;
+            port->bounces = 2 * (NOISY_MIN_BOUNCES + (int)(Random(&port->rng) % range));
+            port->nextEventUs = nowUs + 1000;
+        }
+    }
+    result->events++;
+}
+
+static void RunBrownout(const Options_t *options, Port_t *port, uint64_t nowUs,
+                        Result_t *result) {
+    if (port->nextBrownoutUs && nowUs >= port->nextBrownoutUs) {
+        FUSB302_BrownoutModel(&port->model);
+        if (!port->brownoutUs) {
+            port->brownoutUs = nowUs;
+        }
+        result->brownouts++;
+    }
+    if (!port->nextBrownoutUs || nowUs >= port->nextBrownoutUs) {
+        port->nextBrownoutUs =
+            nowUs + (options->brownoutMs / 2 + Random(&port->rng) % options->brownoutMs) * 1000;
+    }
+}
+
+static void CheckRecovery(Port_t *port, Result_t *result) {
+    uint32_t chipResets = port->monitoring.counters.chipResets;
+    if (chipResets == port->chipResets) {
+        return;
+    }
+    port->chipResets = chipResets;
+    result->chipResets++;
+
+    uint64_t recoveryUs = port->model.nowUs - port->brownoutUs;
+    if (port->brownoutUs && recoveryUs > result->recoveryMaxUs) {
+        result->recoveryMaxUs = recoveryUs;
+    }
+    port->brownoutUs = 0;
+}
+
+static bool SetupPort(Port_t *port, Workload_t workload, uint32_t seed, bool traced, bool pd,
+                      FUSB302_HostCurrentMode_t hostCurrentMode) {
+    FUSB302_SetupModel(&port->model);
+    port->model.sink = pd;
+    port->model.emarker = workload == WORKLOAD_CABLE || workload == WORKLOAD_CABLE_DEVICE;
+    port->model.emarkerVid = 0x1234;
+    port->model.emarkerProductType = 3; // passive cable
+    FUSB302_SetupModelPlatform(&port->platform);
+    FUSB302_SetupBufferPool(&port->pool);
+    port->platform.bufferPool = &port->pool;
+    FUSB302_SelectModel(&port->model);
+
+    port->attached = false;
+    port->bounces = 0;
+    port->rng = seed ? seed : 1;
+    port->nextEventUs = HoldUs(port, DETACHED_HOLD_MS); // spread first events
+
+    // Model cycle time is in ms
+    if (traced && !FUSB302_SetupTrace(&port->platform, &trace, traceBuffer, sizeof(traceBuffer), 1,
+                                      FlushTrace)) {
+        return false;
+    }
+
+    if (!FUSB302_SetupHostMonitoring(&port->platform, &port->data, hostCurrentMode, 0,
+                                     &port->monitoring)) {
+        return false;
+    }
+    FUSB302_ResetProfile(&port->platform, &port->profile);
+    port->monitoring.profile = &port->profile;
+
+    FUSB302_SetupTxScheduler(&port->scheduler, false);
+    uint32_t pdos[2] = {FUSB302_FixedPDO(5000, 3000, 0), FUSB302_FixedPDO(9000, 3000, 0)};
+    FUSB302_SetupDiscovery(&port->discovery, 0);
+    return FUSB302_SetupSource(&port->source, pdos, 2, 0, 0);
+}
+
+static bool UpdatePD(Port_t *port, FUSB302_CycleTime time) {
+    // Same cycle as a PD port: scheduler, source, discovery with what the source left
+    bool ok = FUSB302_UpdateTxScheduler(&port->platform, &port->data, time, &port->monitoring,
+                                        &port->scheduler);
+    ok &= FUSB302_UpdateSource(&port->platform, &port->data, time, &port->monitoring,
+                               &port->scheduler, &port->source);
+    ok &= FUSB302_UpdateDiscovery(&port->platform, &port->data, time, &port->monitoring,
+                                  &port->scheduler, &port->discovery,
+                                  port->source.messagePending ? &port->source.message : 0,
+                                  port->source.objectPosition != 0);
+    return ok;
+}
+
+static void RunBudget(const Options_t *options, Port_t *ports, FUSB302_Budget_t *budget,
+                      uint64_t nowUs, Result_t *result) {
+    FUSB302_CycleTime time = (FUSB302_CycleTime)(nowUs / 1000);
+    FUSB302_UpdateBudget(&ports[0].platform, budget, time);
+
+    uint64_t heldMa = 0;
+    for (int i = 0; i < options->ports; i++) {
+        Port_t *port = &ports[i];
+        FUSB302_SelectModel(&port->model);
+        if (!FUSB302_ApplyBudget(&port->platform, &port->data, budget, i, time)) {
+            result->errors++;
+        }
+
+        uint32_t ma = FUSB302_GetHostCurrentMa(port->monitoring.hostCurrentMode);
+        uint32_t releaseMa = budget->ports[i].releaseMa;
+        heldMa += ma > releaseMa ? ma : releaseMa;
+    }
+    if (heldMa > (uint64_t)options->budgetMa) {
+        result->overcommits++;
+    }
+}
+
+static void SetupExport(Port_t *ports, int numPorts) {
+    FUSB302_SetupExport(exportRegion, numPorts);
+    for (int i = 0; i < numPorts; i++) {
+        ports[i].monitoring.statusExport = FUSB302_GetExportSlot(exportRegion, i);
+    }
+}
+
+static bool RunWorkload(const Options_t *options, Workload_t workload, Result_t *result) {
+    Port_t *ports = calloc(options->ports, sizeof(Port_t));
+    if (!ports) {
+        return false;
+    }
+    memset(result, 0, sizeof(*result));
+
+    for (int i = 0; i < options->ports; i++) {
+        if (!SetupPort(&ports[i], workload, options->seed * 2654435761u + i,
+                       traceFile && i == 0, options->pd,
+                       options->budgetMa ? FUSB302_HOST_CURRENT_MODE_500MA
+                                         : FUSB302_HOST_CURRENT_MODE_1_5A)) {
+            free(ports);
+            return false;
+        }
+    }
+
+    // Ports start at default current, the budget raises them
+    FUSB302_Budget_t budget;
+    FUSB302_BudgetPort_t *budgetPorts = calloc(options->ports, sizeof(FUSB302_BudgetPort_t));
+    if (!budgetPorts) {
+        free(ports);
+        return false;
+    }
+    FUSB302_SetupBudget(&budget, budgetPorts, options->ports, (uint32_t)options->budgetMa,
+                        FUSB302_HOST_CURRENT_MODE_3A);
+    for (int i = 0; i < options->ports; i++) {
+        FUSB302_SetBudgetPort(&budget, i, &ports[i].monitoring);
+    }
+
+    if (exportRegion) {
+        SetupExport(ports, options->ports);
+    }
+
+    uint64_t cpuStart = NowNs(CLOCK_PROCESS_CPUTIME_ID);
+    for (uint64_t nowUs = 0; nowUs < (uint64_t)options->durationMs * 1000;
+         nowUs += (uint64_t)options->periodMs * 1000) {
+        for (int i = 0; i < options->ports; i++) {
+            Port_t *port = &ports[i];
+            FUSB302_Model_t *model = &port->model;
+
+            // Delays of the previous update may have moved the port clock ahead
+            if (model->nowUs < nowUs) {
+                model->nowUs = nowUs;
+            }
+            RunEvents(port, workload, model->nowUs, result);
+            if (options->brownoutMs) {
+                RunBrownout(options, port, model->nowUs, result);
+            }
+
+            FUSB302_SelectModel(model);
+            FUSB302_HostState_t state = port->monitoring.state;
+            uint64_t i2c = model->reads + model->writes;
+            uint64_t delayUs = model->delayUs;
+
+            uint64_t start = NowNs(CLOCK_MONOTONIC);
+            bool ok = FUSB302_UpdateHostMonitoring(&port->platform, &port->data,
+                                                   (FUSB302_CycleTime)(model->nowUs / 1000),
+                                                   &port->monitoring);
+            uint64_t ns = NowNs(CLOCK_MONOTONIC) - start;
+            if (options->pd) {
+                ok &= UpdatePD(port, (FUSB302_CycleTime)(model->nowUs / 1000));
+            }
+
+            // Updates that change state, debounce or wait belong to an event
+            i2c = model->reads + model->writes - i2c;
+            delayUs = model->delayUs - delayUs;
+            bool eventUpdate = state != port->monitoring.state || delayUs ||
+                               FUSB302_IsHostDebouncing(&port->monitoring);
+
+            result->updates++;
+            result->errors += !ok;
+            result->delayUs += delayUs;
+            HistogramAdd(&result->updateNs, ns);
+            if (eventUpdate) {
+                result->eventUpdates++;
+                result->eventI2C += i2c;
+                HistogramAdd(&result->eventUpdateNs, ns);
+            } else {
+                result->idleI2C += i2c;
+            }
+
+            CheckRecovery(port, result);
+
+            if (FUSB302_IsDeviceAttached(&port->monitoring)) {
+                result->attachedTicks++;
+                result->attachedMa += FUSB302_GetHostCurrentMa(port->monitoring.hostCurrentMode);
+            }
+        }
+
+        if (options->budgetMa) {
+            RunBudget(options, ports, &budget, nowUs, result);
+        }
+    }
+    result->rpChanges = budget.upgrades + budget.downgrades;
+    result->cpuNs = NowNs(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+
+    if (traceFile) {
+        FUSB302_FlushTrace(&trace);
+    }
+
+    for (int i = 0; i < options->ports; i++) {
+        for (int l = 0; l < FUSB302_LATENCY_NUM; l++) {
+            MergeLatency(&result->latency[l],
+                         FUSB302_GetLatencyHistogram(&ports[i].profile, (FUSB302_ProfileLatency_t)l));
+        }
+    }
+
+    free(budgetPorts);
+    free(ports);
+    return true;
+}
+
+static double Ratio(uint64_t value, uint64_t count) {
+    return count ? (double)value / count : 0.0;
+}
+
+static void PrintHistogram(const char *name, const Histogram_t *histogram) {
+    printf("\"%s\":{\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}", name,
+           (unsigned long long)HistogramPercentile(histogram, 50),
+           (unsigned long long)HistogramPercentile(histogram, 90),
+           (unsigned long long)HistogramPercentile(histogram, 99),
+           (unsigned long long)HistogramPercentile(histogram, 99.9),
+           (unsigned long long)histogram->max);
+}
+
+static void PrintLatency(const char *name, const FUSB302_LatencyHistogram_t *histogram) {
+    printf("\"%s\":{\"count\":%u,\"p50\":%d,\"p99\":%d,\"max\":%d}", name, histogram->count,
+           (int)FUSB302_GetLatencyPercentile(histogram, 50),
+           (int)FUSB302_GetLatencyPercentile(histogram, 99), (int)histogram->max);
+}
+
+static void PrintResult(const Options_t *options, Workload_t workload, const Result_t *result) {
+    printf("{\"bench\":\"fleet\",\"version\":%d,\"workload\":\"%s\",\"ports\":%d,"
+           "\"duration_ms\":%d,\"period_ms\":%d,\"seed\":%u,",
+           BENCH_VERSION, workloadNames[workload], options->ports, options->durationMs,
+           options->periodMs, options->seed);
+    printf("\"updates\":%llu,\"events\":%llu,\"event_updates\":%llu,\"errors\":%llu,"
+           "\"state_errors\":%llu,",
+           (unsigned long long)result->updates, (unsigned long long)result->events,
+           (unsigned long long)result->eventUpdates, (unsigned long long)result->errors,
+           (unsigned long long)result->stateErrors);
+    printf("\"budget_ma\":%d,\"attached_ma\":%.0f,\"overcommits\":%llu,\"rp_changes\":%u,",
+           options->budgetMa, Ratio(result->attachedMa, result->attachedTicks),
+           (unsigned long long)result->overcommits, result->rpChanges);
+    printf("\"brownouts\":%llu,\"chip_resets\":%llu,\"recovery_max_ms\":%.1f,",
+           (unsigned long long)result->brownouts, (unsigned long long)result->chipResets,
+           result->recoveryMaxUs / 1000.0);
+    printf("\"cpu_ns_per_update\":%.1f,\"i2c_per_event\":%.2f,\"i2c_per_idle_update\":%.3f,"
+           "\"delay_us_per_event\":%.1f,",
+           Ratio(result->cpuNs, result->updates), Ratio(result->eventI2C, result->events),
+           Ratio(result->idleI2C, result->updates - result->eventUpdates),
+           Ratio(result->delayUs, result->events));
+    PrintHistogram("update_ns", &result->updateNs);
+    printf(",");
+    PrintHistogram("event_update_ns", &result->eventUpdateNs);
+    printf(",");
+    PrintLatency("attach_ms", &result->latency[FUSB302_LATENCY_ATTACH_TO_CONFIGURED]);
+    printf(",");
+    PrintLatency("identity_ms", &result->latency[FUSB302_LATENCY_DISCOVER_IDENTITY]);
+    printf(",");
+    PrintLatency("detach_ms", &result->latency[FUSB302_LATENCY_DETACH_TO_IDLE]);
+    printf("}\n");
+}
+
+static bool ParseOptions(int argc, char **argv, Options_t *options) {
+    options->ports = 256;
+    options->durationMs = 10000;
+    options->periodMs = 2;
+    options->seed = 1;
+    options->workload = WORKLOAD_NUM;
+    options->traceFile = 0;
+    options->exportFile = 0;
+    options->budgetMa = 0;
+    options->brownoutMs = 0;
+    options->pd = false;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *value = argv[i + 1];
+        if (!strcmp(argv[i], "--ports")) {
+            options->ports = atoi(value);
+        } else if (!strcmp(argv[i], "--duration-ms")) {
+            options->durationMs = atoi(value);
+        } else if (!strcmp(argv[i], "--period-ms")) {
+            options->periodMs = atoi(value);
+        } else if (!strcmp(argv[i], "--seed")) {
+            options->seed = (uint32_t)strtoul(value, 0, 0);
+        } else if (!strcmp(argv[i], "--budget-ma")) {
+            options->budgetMa = atoi(value);
+        } else if (!strcmp(argv[i], "--brownout-ms")) {
+            options->brownoutMs = atoi(value);
+        } else if (!strcmp(argv[i], "--export")) {
+            options->exportFile = value;
+        } else if (!strcmp(argv[i], "--stack")) {
+            if (strcmp(value, "host") && strcmp(value, "pd")) {
+                return false;
+            }
+            options->pd = !strcmp(value, "pd");
+        } else if (!strcmp(argv[i], "--trace")) {
+            options->traceFile = value;
+        } else if (!strcmp(argv[i], "--workload")) {
+            options->workload = -1;
+            for (int w = 0; w < WORKLOAD_NUM; w++) {
+                if (!strcmp(value, workloadNames[w])) {
+                    options->workload = w;
+                }
+            }
+            if (!strcmp(value, "all")) {
+                options->workload = WORKLOAD_NUM;
+            }
+        } else {
+            return false;
+        }
+    }
+    if (argc % 2 == 0) {
+        return false;
+    }
+
+    // One trace stream per file
+    if (options->traceFile && options->workload == WORKLOAD_NUM) {
+        return false;
+    }
+
+    return options->ports > 0 && options->ports <= 0xFFFF && options->durationMs > 0 &&
+           options->periodMs > 0 && options->workload >= 0 && options->budgetMa >= 0 &&
+           options->brownoutMs >= 0;
+}
+
+int main(int argc, char **argv) {
+    Options_t options;
+    if (!ParseOptions(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--ports N] [--duration-ms N] [--period-ms N] [--seed N] "
+                        "[--workload plug|cable|cable-device|noisy|all] [--trace FILE] "
+                        "[--export PATH] [--budget-ma N] [--brownout-ms N] [--stack host|pd]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (options.traceFile) {
+        traceFile = fopen(options.traceFile, "wb");
+        if (!traceFile) {
+            perror(options.traceFile);
+            return 1;
+        }
+    }
+
+    if (options.exportFile) {
+        exportRegion = FUSB302_CreateExportFile(options.exportFile, options.ports);
+        if (!exportRegion) {
+            perror(options.exportFile);
+            return 1;
+        }
+    }
+
+    static Result_t result;
+    int status = 0;
+    for (int w = 0; w < WORKLOAD_NUM; w++) {
+        if (options.workload != WORKLOAD_NUM && options.workload != w) {
+            continue;
+        }
+        if (!RunWorkload(&options, (Workload_t)w, &result)) {
+            fprintf(stderr, "%s: setup failed\n", workloadNames[w]);
+            return 1;
+        }
+        PrintResult(&options, (Workload_t)w, &result);
+        fflush(stdout);
+        if (result.errors || result.stateErrors || result.overcommits) {
+            status = 1;
+        }
+    }
+
+    if (traceFile) {
+        fclose(traceFile);
+    }
+    if (exportRegion) {
+        FUSB302_CloseExportFile(exportRegion);
+    }
+    return status;
+}
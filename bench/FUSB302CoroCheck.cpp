@@ -0,0 +1,76 @@
+// Link and run check of the C++20 coroutine facade (FUSB302Coro.hpp) on the register model
+// (FUSB302Model): every driver operation task is awaited once on a port fiber, so each wrapper is
+// instantiated and linked against the C objects. Prints one line per operation, exit status is the
+// number of failed operations.
+//
+//   cc -O2 -I.. -c ../FUSB302*.c FUSB302Model.c
+//   c++ -std=c++20 -O2 -I.. FUSB302CoroCheck.cpp FUSB302*.o -o fusb302-coro-check
+//   ./fusb302-coro-check
+
+#include <cstdio>
+
+#include "FUSB302Coro.hpp"
+#include "FUSB302Model.h"
+#include "FUSB302Pool.h"
+
+using namespace fusb302::coro;
+
+static FUSB302_Model_t model;
+static FUSB302_Platform_t platform;
+static FUSB302_Data_t data;
+static FUSB302_BufferPool_t pool;
+static FUSB302_HostMonitoring_t host;
+static FUSB302_SinkMonitoring_t sink;
+static FUSB302_DRP_t drp;
+static int failed;
+
+static void Check(const char *name, bool ok) {
+    printf("%-30s %s\n", name, ok ? "ok" : "FAIL");
+    failed += !ok;
+}
+
+static Task<> Run(Port &port) {
+    FUSB302_CycleTime time = 0;
+    bool emarkerPresent = false;
+    FUSB302_PDIdentity_t identity;
+
+    Check("SetupHostMonitoring",
+          co_await SetupHostMonitoring(port, &platform, &data, FUSB302_HOST_CURRENT_MODE_1_5A,
+                                       time, &host));
+    Check("UpdateHostMonitoring",
+          co_await UpdateHostMonitoring(port, &platform, &data, time, &host));
+    Check("HostCableDiscoverIdentity",
+          co_await HostCableDiscoverIdentity(port, &platform, &data, FUSB302_CC_ORIENTATION_CC1,
+                                             false, &emarkerPresent, &identity));
+    Check("ProtocolCableDiscoverIdentity",
+          co_await ProtocolCableDiscoverIdentity(port, &platform, &data, &host.protocol,
+                                                 FUSB302_CC_ORIENTATION_CC1, false,
+                                                 &emarkerPresent, &identity));
+    Check("SetupSinkMonitoring", co_await SetupSinkMonitoring(port, &platform, &data, time, &sink));
+    Check("UpdateSinkMonitoring",
+          co_await UpdateSinkMonitoring(port, &platform, &data, time, &sink));
+    Check("SetupToggleMode", co_await SetupToggleMode(port, &platform, &data,
+                                                      FUSB302_TOGGLE_MODE_DRP,
+                                                      FUSB302_HOST_CURRENT_MODE_1_5A));
+    Check("SetupDRP", co_await SetupDRP(port, &platform, &data, FUSB302_DRP_PREFER_NONE,
+                                        FUSB302_HOST_CURRENT_MODE_1_5A, time, &host, &sink, &drp));
+    Check("UpdateDRP", co_await UpdateDRP(port, &platform, &data, time, &drp));
+}
+
+int main() {
+    FUSB302_SetupModel(&model);
+    FUSB302_SetupModelPlatform(&platform);
+    FUSB302_SelectModel(&model);
+    FUSB302_SetupBufferPool(&pool);
+    platform.bufferPool = &pool;
+
+    // Driver delays suspend the port fiber on the executor
+    platform.delayUs = Executor::delayUs;
+
+    Executor executor;
+    Port port(executor);
+    executor.spawn(Run(port));
+    executor.run();
+
+    return failed;
+}
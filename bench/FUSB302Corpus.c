@@ -0,0 +1,158 @@
+#include "FUSB302Corpus.h"
+#include "FUSB302CRC.h"
+
+#define MAX_FRAME_LEN (1 + 2 + FUSB302_PD_MAX_DATA_OBJECTS * 4 + 4)
+#define MAX_GARBAGE_LEN 8
+#define MAX_GARBAGE_FRAMES 3
+
+static const char *corpusNames[FUSB302_CORPUS_NUM] = {"single-reply", "goodcrc-data", "truncated",
+                                                      "garbage"};
+
+static uint32_t Random(uint32_t *state) {
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int PutFrame(uint8_t *out, uint8_t token, uint16_t header, const uint32_t *objects) {
+    int len = 0;
+    out[len++] = token;
+    out[len++] = header & 0xFF;
+    out[len++] = header >> 8;
+    for (int i = 0; i < FUSB302_PD_HEADER_NUM_OBJECTS(header); i++) {
+        out[len++] = objects[i] & 0xFF;
+        out[len++] = (objects[i] >> 8) & 0xFF;
+        out[len++] = (objects[i] >> 16) & 0xFF;
+        out[len++] = objects[i] >> 24;
+    }
+
+    // CRC over header and data objects
+    uint32_t crc = FUSB302_UpdateCRC(0, &out[1], len - 1);
+    for (int i = 0; i < 4; i++) {
+        out[len++] = (crc >> (i * 8)) & 0xFF;
+    }
+    return len;
+}
+
+static uint16_t Header(uint8_t type, int numObjects, uint32_t *rng) {
+    // PD 3.0, random MessageID
+    return (uint16_t)((numObjects << 12) | ((Random(rng) & 0x7) << 9) | (0x2 << 6) | type);
+}
+
+static int PutIdentityReply(uint8_t *out, uint32_t *rng) {
+    // Discover Identity ACK from a cable plug: VDM header, ID Header, Cert Stat, Product, Cable
+    uint32_t objects[5] = {
+        0xFF008041,
+        (Random(rng) & 0xFFFF) | ((uint32_t)(3 + (Random(rng) & 1)) << 27),
+        Random(rng),
+        Random(rng),
+        Random(rng),
+    };
+    uint16_t header = Header(FUSB302_PD_DATA_VENDOR_DEFINED, 5, rng) | (1 << 8);
+    return PutFrame(out, FUSB302_RXTOKEN_SOP1, header, objects);
+}
+
+static int PutGoodCRC(uint8_t *out, uint32_t *rng) {
+    return PutFrame(out, FUSB302_RXTOKEN_SOP, Header(FUSB302_PD_CTRL_GOODCRC, 0, rng), 0);
+}
+
+static int PutDataMessage(uint8_t *out, uint32_t *rng) {
+    // Source_Capabilities with 1..7 PDOs
+    uint32_t objects[FUSB302_PD_MAX_DATA_OBJECTS];
+    int numObjects = 1 + Random(rng) % FUSB302_PD_MAX_DATA_OBJECTS;
+    for (int i = 0; i < numObjects; i++) {
+        objects[i] = Random(rng);
+    }
+    return PutFrame(out, FUSB302_RXTOKEN_SOP, Header(FUSB302_PD_DATA_SOURCE_CAPABILITIES,
+                                                      numObjects, rng),
+                    objects);
+}
+
+static int PutAnyFrame(uint8_t *out, uint32_t *rng) {
+    switch (Random(rng) % 3) {
+    case 0:
+        return PutIdentityReply(out, rng);
+    case 1:
+        return PutGoodCRC(out, rng);
+    default:
+        return PutDataMessage(out, rng);
+    }
+}
+
+static int PutGarbage(uint8_t *out, uint32_t *rng) {
+    // Bytes that are no SOP, SOP' or SOP'' token (SOP*_Debug tokens included)
+    int len = Random(rng) % (MAX_GARBAGE_LEN + 1);
+    for (int i = 0; i < len; i++) {
+        out[i] = (uint8_t)(((Random(rng) % 5) << 5) | (Random(rng) & 0x1F));
+    }
+    return len;
+}
+
+const char *FUSB302_GetCorpusName(FUSB302_CorpusKind_t kind) {
+    return kind < FUSB302_CORPUS_NUM ? corpusNames[kind] : "?";
+}
+
+int FUSB302_BuildCorpus(FUSB302_Corpus_t *corpus, FUSB302_CorpusKind_t kind, uint32_t seed) {
+    uint32_t rng = seed ? seed : 1;
+    int maxRecordLen = MAX_GARBAGE_FRAMES * (MAX_FRAME_LEN + MAX_GARBAGE_LEN) + MAX_GARBAGE_LEN;
+
+    corpus->kind = kind;
+    corpus->arenaLen = 0;
+    corpus->numRecords = 0;
+
+    while (corpus->numRecords < corpus->maxRecords &&
+           corpus->arenaLen + maxRecordLen <= corpus->arenaSize) {
+        uint8_t *out = &corpus->arena[corpus->arenaLen];
+        int len = 0, packets = 0;
+
+        switch (kind) {
+        case FUSB302_CORPUS_SINGLE_REPLY:
+            len = PutIdentityReply(out, &rng);
+            packets = 1;
+            break;
+        case FUSB302_CORPUS_GOODCRC_DATA:
+            len = PutGoodCRC(out, &rng);
+            len += PutDataMessage(&out[len], &rng);
+            packets = 2;
+            break;
+        case FUSB302_CORPUS_TRUNCATED:
+            // Keep at least the SOP token, lose at least one CRC byte
+            len = PutAnyFrame(out, &rng);
+            len = 1 + Random(&rng) % (len - 1);
+            break;
+        case FUSB302_CORPUS_GARBAGE:
+        default:
+            packets = 1 + Random(&rng) % MAX_GARBAGE_FRAMES;
+            for (int i = 0; i < packets; i++) {
+                len += PutGarbage(&out[len], &rng);
+                len += PutAnyFrame(&out[len], &rng);
+            }
+            len += PutGarbage(&out[len], &rng);
+            break;
+        }
+
+        FUSB302_CorpusRecord_t *record = &corpus->records[corpus->numRecords++];
+        record->offset = corpus->arenaLen;
+        record->len = (uint16_t)len;
+        record->packets = (uint16_t)packets;
+        corpus->arenaLen += len;
+    }
+
+    return corpus->numRecords;
+}
+
+void FUSB302_DecodeCorpusPacket(const uint8_t *packet, int packetLen, FUSB302_SOP_t sop,
+                                FUSB302_PDMessage_t *message) {
+    message->sop = sop;
+    message->header = packet[0] | (packet[1] << 8);
+
+    int numObjects = FUSB302_PD_HEADER_NUM_OBJECTS(message->header);
+    for (int i = 0; i < numObjects && 2 + i * 4 + 4 <= packetLen; i++) {
+        const uint8_t *obj = &packet[2 + i * 4];
+        message->objects[i] = (uint32_t)obj[0] | (uint32_t)obj[1] << 8 | (uint32_t)obj[2] << 16 |
+                              (uint32_t)obj[3] << 24;
+    }
+}
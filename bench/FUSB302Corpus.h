@@ -0,0 +1,52 @@
+#ifndef FUSB302_CORPUS_H
+#define FUSB302_CORPUS_H
+
+#include <stdint.h>
+
+#include "FUSB302PD.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Generated RX FIFO captures for parser benchmarks and fuzz seeds. A corpus is a set of records
+// (one FIFO drain each) in one arena, deterministic for a given seed.
+
+typedef enum FUSB302_CorpusKind {
+    FUSB302_CORPUS_SINGLE_REPLY,  // one Discover Identity ACK (SOP')
+    FUSB302_CORPUS_GOODCRC_DATA,  // GoodCRC followed by a data message (SOP)
+    FUSB302_CORPUS_TRUNCATED,     // frame cut short anywhere after the SOP token
+    FUSB302_CORPUS_GARBAGE,       // frames with non-SOP bytes between them
+    FUSB302_CORPUS_NUM,
+} FUSB302_CorpusKind_t;
+
+typedef struct FUSB302_CorpusRecord {
+    uint32_t offset;
+    uint16_t len;
+    uint16_t packets; // complete packets in the record
+} FUSB302_CorpusRecord_t;
+
+typedef struct FUSB302_Corpus {
+    FUSB302_CorpusKind_t kind;
+    uint8_t *arena;
+    uint32_t arenaSize;
+    uint32_t arenaLen;
+    FUSB302_CorpusRecord_t *records;
+    int maxRecords;
+    int numRecords;
+} FUSB302_Corpus_t;
+
+const char *FUSB302_GetCorpusName(FUSB302_CorpusKind_t kind);
+
+// Fills the corpus until arena or records are full, returns number of records
+int FUSB302_BuildCorpus(FUSB302_Corpus_t *corpus, FUSB302_CorpusKind_t kind, uint32_t seed);
+
+// Decodes an extracted packet (PD header onwards) for the message parsers
+void FUSB302_DecodeCorpusPacket(const uint8_t *packet, int packetLen, FUSB302_SOP_t sop,
+                                FUSB302_PDMessage_t *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_CORPUS_H
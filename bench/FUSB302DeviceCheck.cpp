@@ -0,0 +1,107 @@
+// Check of the C++ Device facade (FUSB302.hpp) in a FUSB302_STATIC_BUS build on the register
+// model (FUSB302Model): register accesses of Device and the C layers reach the Bus as direct calls
+// (the platform I2C pointers are cleared), with the I2C policy retrying and the trace capturing
+// them. Prints one line per check, exit status is the number of failed checks.
+//
+//   cc -O2 -DFUSB302_STATIC_BUS -I.. -c ../FUSB302*.c FUSB302Model.c
+//   c++ -O2 -DFUSB302_STATIC_BUS -I.. FUSB302DeviceCheck.cpp FUSB302*.o -o fusb302-device-check
+//   ./fusb302-device-check
+
+#include <cstdio>
+
+#include "FUSB302.hpp"
+#include "FUSB302Host.h"
+#include "FUSB302Model.h"
+#include "FUSB302Pool.h"
+#include "FUSB302Trace.h"
+
+#ifndef FUSB302_STATIC_BUS
+#error "Build with -DFUSB302_STATIC_BUS"
+#endif
+
+static FUSB302_Model_t model;
+static FUSB302_Platform_t modelPlatform; // model callbacks, called by the Bus only
+static int failed;
+
+// Bus on the model, the next failReads reads fail
+struct Bus {
+    static int failReads;
+    static uint32_t reads;
+    static uint32_t writes;
+
+    static bool read(uint8_t addr7bit, uint8_t reg, uint8_t *data, uint8_t length) {
+        reads++;
+        if (failReads) {
+            failReads--;
+            return false;
+        }
+        return modelPlatform.i2cReadReg(addr7bit, reg, data, length, 0) >= 0;
+    }
+
+    static bool write(uint8_t addr7bit, uint8_t reg, const uint8_t *data, uint8_t length) {
+        writes++;
+        return modelPlatform.i2cWriteReg(addr7bit, reg, data, length, 0) >= 0;
+    }
+
+    static void delayUs(uint32_t us) { modelPlatform.delayUs(us); }
+};
+
+int Bus::failReads;
+uint32_t Bus::reads;
+uint32_t Bus::writes;
+
+FUSB302_DEFINE_STATIC_BUS(Bus, FUSB302_I2C_ADDR)
+
+static void Check(const char *name, bool ok) {
+    printf("%-30s %s\n", name, ok ? "ok" : "FAIL");
+    failed += !ok;
+}
+
+int main() {
+    FUSB302_SetupModel(&model);
+    FUSB302_SetupModelPlatform(&modelPlatform);
+    FUSB302_SelectModel(&model);
+
+    fusb302::Device<Bus> device;
+    FUSB302_Platform_t *platform = device.platform();
+    platform->debugPrint = modelPlatform.debugPrint;
+    platform->getTimeDiffMs = modelPlatform.getTimeDiffMs;
+    platform->i2cReadReg = 0;
+    platform->i2cWriteReg = 0;
+
+    FUSB302_BufferPool_t pool;
+    FUSB302_SetupBufferPool(&pool);
+    platform->bufferPool = &pool;
+    FUSB302_I2CPolicy_t policy;
+    FUSB302_SetupI2CPolicy(&policy, 1, 2, 0);
+    platform->i2cPolicy = &policy;
+    static uint8_t traceBuffer[4096];
+    FUSB302_Trace_t trace;
+    FUSB302_SetupTrace(platform, &trace, traceBuffer, sizeof(traceBuffer), 1, 0);
+
+    // Device accesses: direct Bus calls, captured by the trace
+    uint32_t writes = Bus::writes;
+    uint32_t traceLen = trace.len;
+    Check("reset", device.reset() && Bus::writes == writes + 1 && trace.len > traceLen);
+    Check("flushFIFO", device.flushFIFO() && Bus::writes == writes + 2);
+
+    // Idempotent read retried by the policy
+    Bus::failReads = 1;
+    Check("readControl retry",
+          device.readControl(FUSB302_REG_DEVICE_ID) && policy.retries == 1 &&
+              device.getValue(FUSB302_REG_DEVICE_ID, 0xFF, 0) == model.regs[FUSB302_REG_DEVICE_ID]);
+
+    // C layers on the Device's platform and data
+    FUSB302_HostMonitoring_t monitoring;
+    bool ok = FUSB302_SetupHostMonitoring(platform, device.data(), FUSB302_HOST_CURRENT_MODE_1_5A,
+                                          0, &monitoring);
+    model.cc[0] = FUSB302_MODEL_TERM_RD;
+    for (int i = 0; ok && i < 500 && !FUSB302_IsDeviceAttached(&monitoring); i++) {
+        model.nowUs += 2000;
+        ok = FUSB302_UpdateHostMonitoring(platform, device.data(),
+                                          (FUSB302_CycleTime)(model.nowUs / 1000), &monitoring);
+    }
+    Check("host monitoring attach", ok && FUSB302_IsDeviceAttached(&monitoring));
+
+    return failed;
+}
@@ -0,0 +1,134 @@
+// Fault injection checks of host monitoring on the register model (FUSB302Model): protection
+// faults and PD resets reported while the interrupt burst read fails must still be handled. Prints
+// one line per case, exit status is the number of failed cases.
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302Model.c FUSB302FaultTest.c -o fusb302-fault-test
+//   ./fusb302-fault-test
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FUSB302FaultInject.h"
+#include "FUSB302Host.h"
+#include "FUSB302Model.h"
+#include "FUSB302Pool.h"
+
+#define UPDATE_PERIOD_US 2000
+#define ATTACH_TIMEOUT_US 1000000
+
+typedef struct Case {
+    const char *name;
+    uint8_t status0a; // level bits of the injected event
+    uint8_t status1;
+    uint8_t interruptA;
+    bool abortBurst; // interrupt burst read fails after clearing the interrupts
+} Case_t;
+
+static const Case_t cases[] = {
+    {"ocp", 0, FUSB302_OCP, FUSB302_I_OCP_TEMP, false},
+    {"ocp-burst-abort", 0, FUSB302_OCP, FUSB302_I_OCP_TEMP, true},
+    {"ovrtemp-burst-abort", 0, FUSB302_OVRTEMP, FUSB302_I_OCP_TEMP, true},
+    {"hardrst-burst-abort", FUSB302_HARDRST, 0, FUSB302_I_HARDRST, true},
+    {"softrst-burst-abort", FUSB302_SOFTRST, 0, FUSB302_I_SOFTRST, true},
+};
+
+static FUSB302_Model_t model;
+static FUSB302_Platform_t platform;
+static FUSB302_Data_t data;
+static FUSB302_BufferPool_t pool;
+static FUSB302_HostMonitoring_t monitoring;
+static FUSB302_FaultInjector_t injector;
+
+static bool Update(void) {
+    model.nowUs += UPDATE_PERIOD_US;
+    return FUSB302_UpdateHostMonitoring(&platform, &data, (FUSB302_CycleTime)(model.nowUs / 1000),
+                                        &monitoring);
+}
+
+static bool AttachCableDevice(void) {
+    FUSB302_SetupModel(&model);
+    model.emarker = true;
+    model.emarkerVid = 0x1234;
+    model.emarkerProductType = 3; // passive cable
+    FUSB302_SetupModelPlatform(&platform);
+    FUSB302_SetupBufferPool(&pool);
+    platform.bufferPool = &pool;
+    FUSB302_SelectModel(&model);
+
+    if (!FUSB302_SetupHostMonitoring(&platform, &data, FUSB302_HOST_CURRENT_MODE_1_5A, 0,
+                                     &monitoring)) {
+        return false;
+    }
+
+    // Device on CC1, cable Ra (VCONN) on CC2
+    model.cc[0] = FUSB302_MODEL_TERM_RD;
+    model.cc[1] = FUSB302_MODEL_TERM_RA;
+    uint64_t startUs = model.nowUs;
+    while (monitoring.state != FUSB302_HOST_STATE_ATTACHED_CABLE_DEVICE) {
+        if (!Update() || model.nowUs - startUs > ATTACH_TIMEOUT_US) {
+            return false;
+        }
+    }
+
+    return (model.regs[FUSB302_REG_SWITCHES0] & FUSB302_VCONN_CC2) != 0;
+}
+
+static bool RunCase(const Case_t *c, const char **error) {
+    if (!AttachCableDevice()) {
+        *error = "attach";
+        return false;
+    }
+
+    FUSB302_SetupFaultInjector(&injector, &platform, 1);
+    if (c->abortBurst) {
+        injector.failReg = FUSB302_REG_INTERRUPTA;
+        injector.failReads = 1;
+    }
+
+    // Event raised by the chip between two updates
+    model.regs[FUSB302_REG_STATUS0A] |= c->status0a;
+    model.regs[FUSB302_REG_STATUS1] |= c->status1;
+    model.regs[FUSB302_REG_INTERRUPTA] |= c->interruptA;
+    Update();
+
+    FUSB302_RemoveFaultInjector(&injector, &platform);
+
+    if (c->abortBurst && injector.aborts != 1) {
+        *error = "burst not aborted";
+        return false;
+    }
+    if (c->status1) {
+        uint32_t faults = c->status1 & FUSB302_OVRTEMP ? monitoring.counters.overTempFaults
+                                                       : monitoring.counters.ocpFaults;
+        if (model.regs[FUSB302_REG_SWITCHES0] & (FUSB302_VCONN_CC1 | FUSB302_VCONN_CC2)) {
+            *error = "VCONN still on";
+            return false;
+        }
+        if (monitoring.state != FUSB302_HOST_STATE_FAULT || faults != 1) {
+            *error = "fault not recorded";
+            return false;
+        }
+    }
+    if (c->status0a & FUSB302_HARDRST && monitoring.counters.hardResets != 1) {
+        *error = "hard reset not handled";
+        return false;
+    }
+    if (c->status0a & FUSB302_SOFTRST && monitoring.counters.softResets != 1) {
+        *error = "soft reset not handled";
+        return false;
+    }
+
+    return true;
+}
+
+int main(void) {
+    int failed = 0;
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const char *error = "";
+        bool ok = RunCase(&cases[i], &error);
+        printf("%-22s %s%s%s\n", cases[i].name, ok ? "ok" : "FAIL", ok ? "" : ": ", error);
+        failed += !ok;
+    }
+
+    return failed;
+}
@@ -0,0 +1,412 @@
+#include "FUSB302Model.h"
+#include "FUSB302CRC.h"
+
+#include <string.h>
+
+// Pull-up current source per HOST_CUR setting, uA
+static const int hostCurrentUa[] = {0, 80, 180, 330};
+
+// Termination resistors, Ohm
+#define RD_OHM 5100
+#define RA_OHM 1000
+
+#define OPEN_MV 3300
+#define VCONN_MV 5000
+
+static const uint8_t resetValues[FUSB302_REG_CONTROL_NUM] = {
+    0x91, // DEVICE_ID: FUSB302B, revision B
+    FUSB302_RESET_SWITCHES0, FUSB302_RESET_SWITCHES1, FUSB302_RESET_MEASURE,
+    FUSB302_RESET_SLICE,     FUSB302_RESET_CONTROL0,  FUSB302_RESET_CONTROL1,
+    FUSB302_RESET_CONTROL2,  FUSB302_RESET_CONTROL3,  FUSB302_RESET_MASK,
+    FUSB302_RESET_POWER,     FUSB302_RESET_RESET,     FUSB302_RESET_OCREG,
+    FUSB302_RESET_MASKA,     FUSB302_RESET_MASKB,     FUSB302_RESET_CONTROL4,
+};
+
+static FUSB302_Model_t *current;
+
+static void ResetRegisters(FUSB302_Model_t *model) {
+    memset(model->regs, 0, sizeof(model->regs));
+    memcpy(&model->regs[FUSB302_REG_CONTROL_START], resetValues, FUSB302_REG_CONTROL_NUM);
+    model->regs[FUSB302_REG_STATUS1] = FUSB302_RX_EMPTY | FUSB302_TX_EMPTY;
+    model->rxLen = 0;
+    model->txLen = 0;
+    model->lastComp = -1;
+    model->lastBcLvl = -1;
+}
+
+void FUSB302_SetupModel(FUSB302_Model_t *model) {
+    memset(model, 0, sizeof(*model));
+    ResetRegisters(model);
+}
+
+void FUSB302_BrownoutModel(FUSB302_Model_t *model) {
+    ResetRegisters(model);
+}
+
+static int TermMv(FUSB302_Model_t *model, FUSB302_ModelTerm_t term) {
+    int ua = hostCurrentUa[(model->regs[FUSB302_REG_CONTROL0] & FUSB302_HOST_CUR_BITS) >>
+                           FUSB302_HOST_CUR_OFFSET];
+    switch (term) {
+    case FUSB302_MODEL_TERM_RD:
+        return ua * RD_OHM / 1000;
+    case FUSB302_MODEL_TERM_RA:
+        return ua * RA_OHM / 1000;
+    case FUSB302_MODEL_TERM_OPEN:
+    default:
+        return OPEN_MV;
+    }
+}
+
+static int MeasureCC(FUSB302_Model_t *model, int pin) {
+    uint8_t switches0 = model->regs[FUSB302_REG_SWITCHES0];
+    uint8_t pullUp = pin ? FUSB302_PU_EN2 : FUSB302_PU_EN1;
+    uint8_t vconn = pin ? FUSB302_VCONN_CC2 : FUSB302_VCONN_CC1;
+    uint8_t otherVconn = pin ? FUSB302_VCONN_CC1 : FUSB302_VCONN_CC2;
+
+    if (switches0 & vconn) {
+        return VCONN_MV;
+    }
+    if (!(switches0 & pullUp)) {
+        return 0;
+    }
+
+    int mv = TermMv(model, model->cc[pin]);
+
+    // Both pull-ups on: pins are interconnected, lower termination wins
+    if ((switches0 & (FUSB302_PU_EN1 | FUSB302_PU_EN2)) == (FUSB302_PU_EN1 | FUSB302_PU_EN2) &&
+        !(switches0 & otherVconn)) {
+        int otherMv = TermMv(model, model->cc[!pin]);
+        if (otherMv < mv) {
+            mv = otherMv;
+        }
+    }
+
+    return mv;
+}
+
+static void Evaluate(FUSB302_Model_t *model) {
+    uint8_t switches0 = model->regs[FUSB302_REG_SWITCHES0];
+    uint8_t measure = model->regs[FUSB302_REG_MEASURE];
+
+    int mv = 0, lsbMv = FUSB302_MDAC_LSB_MV;
+    if (measure & FUSB302_MEAS_VBUS) {
+        lsbMv = FUSB302_MDAC_VBUS_LSB_MV; // no VBUS in the model
+    } else if (switches0 & FUSB302_MEAS_CC1) {
+        mv = MeasureCC(model, 0);
+    } else if (switches0 & FUSB302_MEAS_CC2) {
+        mv = MeasureCC(model, 1);
+    }
+
+    int mdac = (measure & FUSB302_MDAC_BITS) >> FUSB302_MDAC_OFFSET;
+    int comp = mv > (mdac + 1) * lsbMv;
+    int bcLvl = mv < 200    ? FUSB302_BC_LVL_0_200MV
+                : mv < 660  ? FUSB302_BC_LVL_200_660MV
+                : mv < 1230 ? FUSB302_BC_LVL_660_1230MV
+                            : FUSB302_BC_LVL_1230MV_MORE;
+
+    if (model->lastComp >= 0 && comp != model->lastComp) {
+        model->regs[FUSB302_REG_INTERRUPT] |= FUSB302_I_COMP_CHNG;
+    }
+    if (model->lastBcLvl >= 0 && bcLvl != model->lastBcLvl) {
+        model->regs[FUSB302_REG_INTERRUPT] |= FUSB302_I_BC_LVL;
+    }
+    model->lastComp = comp;
+    model->lastBcLvl = bcLvl;
+
+    model->regs[FUSB302_REG_STATUS0] = (comp ? FUSB302_COMP : 0) | bcLvl;
+
+    uint8_t *status1 = &model->regs[FUSB302_REG_STATUS1];
+    if (model->rxLen) {
+        *status1 &= ~FUSB302_RX_EMPTY;
+    } else {
+        *status1 = (*status1 & ~(FUSB302_RXSOP1 | FUSB302_RXSOP2)) | FUSB302_RX_EMPTY;
+    }
+}
+
+static void PushRx(FUSB302_Model_t *model, uint8_t token, const uint8_t *packet, int len) {
+    if (model->rxLen + 1 + len + 4 > FUSB302_MODEL_RX_SIZE) {
+        return;
+    }
+
+    // SOP token, header and data objects, CRC
+    uint32_t crc = FUSB302_UpdateCRC(0, packet, len);
+    model->rx[model->rxLen++] = token;
+    memcpy(&model->rx[model->rxLen], packet, len);
+    model->rxLen += len;
+    for (int i = 0; i < 4; i++) {
+        model->rx[model->rxLen++] = (crc >> (i * 8)) & 0xFF;
+    }
+
+    model->regs[FUSB302_REG_INTERRUPT] |= FUSB302_I_CRC_CHK;
+    if (token == FUSB302_RXTOKEN_SOP1) {
+        model->regs[FUSB302_REG_STATUS1] |= FUSB302_RXSOP1;
+    }
+}
+
+static int VconnPin(FUSB302_Model_t *model) {
+    uint8_t switches0 = model->regs[FUSB302_REG_SWITCHES0];
+    return (switches0 & FUSB302_VCONN_CC1) ? 0 : (switches0 & FUSB302_VCONN_CC2) ? 1 : -1;
+}
+
+static void ReplyIdentity(FUSB302_Model_t *model, const uint8_t *packet, int len) {
+    // Discover Identity REQ on SOP' to a powered e-marker
+    int pin = VconnPin(model);
+    if (!model->emarker || pin < 0 || model->cc[pin] != FUSB302_MODEL_TERM_RA || len < 6 ||
+        (packet[0] & 0x1F) != 15) {
+        return;
+    }
+
+    uint16_t header = packet[0] | (packet[1] << 8);
+    uint32_t vdm = packet[2] | (packet[3] << 8) | (packet[4] << 16) | ((uint32_t)packet[5] << 24);
+    if ((vdm & 0x1F) != 1) {
+        return;
+    }
+    int messageId = (header >> 9) & 0x7;
+
+    // GoodCRC from the cable plug
+    uint8_t goodCrc[2] = {0x01 | (2 << 6), (uint8_t)(messageId << 1)};
+    PushRx(model, FUSB302_RXTOKEN_SOP1, goodCrc, sizeof(goodCrc));
+
+    // ACK: VDM header, ID Header, Cert Stat, Product, Cable VDO
+    uint32_t objects[5] = {
+        (vdm & ~0xC0u) | 0x40,
+        model->emarkerVid | ((uint32_t)model->emarkerProductType << 27),
+        0,
+        0,
+        1u << 5, // 3 A
+    };
+    uint16_t reply = 15 | (2 << 6) | (1 << 8) | (messageId << 9) | (5 << 12);
+    uint8_t message[2 + sizeof(objects)];
+    message[0] = reply & 0xFF;
+    message[1] = reply >> 8;
+    for (int i = 0; i < 5; i++) {
+        message[2 + i * 4] = objects[i] & 0xFF;
+        message[3 + i * 4] = (objects[i] >> 8) & 0xFF;
+        message[4 + i * 4] = (objects[i] >> 16) & 0xFF;
+        message[5 + i * 4] = objects[i] >> 24;
+    }
+    PushRx(model, FUSB302_RXTOKEN_SOP1, message, sizeof(message));
+}
+
+static int SinkPin(FUSB302_Model_t *model) {
+    return model->cc[0] == FUSB302_MODEL_TERM_RD ? 0 : model->cc[1] == FUSB302_MODEL_TERM_RD ? 1 : -1;
+}
+
+void FUSB302_ModelSinkSend(FUSB302_Model_t *model, uint8_t messageType, const uint32_t *objects,
+                           int numObjects) {
+    // Sink, UFP, PD 3.0 unless set
+    int specRevision = model->sinkSpecRevision ? model->sinkSpecRevision : 2;
+    uint16_t header = (uint16_t)(messageType | (specRevision << 6) |
+                                 ((model->sinkMessageId & 0x7) << 9) | ((numObjects & 0x7) << 12));
+    model->sinkMessageId = (model->sinkMessageId + 1) & 0x7;
+
+    uint8_t message[2 + 7 * 4];
+    message[0] = header & 0xFF;
+    message[1] = header >> 8;
+    for (int i = 0; i < numObjects; i++) {
+        message[2 + i * 4] = objects[i] & 0xFF;
+        message[3 + i * 4] = (objects[i] >> 8) & 0xFF;
+        message[4 + i * 4] = (objects[i] >> 16) & 0xFF;
+        message[5 + i * 4] = objects[i] >> 24;
+    }
+    PushRx(model, FUSB302_RXTOKEN_SOP, message, 2 + numObjects * 4);
+}
+
+static void ReceiveSink(FUSB302_Model_t *model, const uint8_t *packet, int len) {
+    if (!model->sink || SinkPin(model) < 0 || len < 2) {
+        return;
+    }
+
+    uint16_t header = packet[0] | (packet[1] << 8);
+    int numObjects = (header >> 12) & 0x7;
+    model->sinkHeader = header;
+    for (int i = 0; i < numObjects && 2 + i * 4 + 4 <= len; i++) {
+        const uint8_t *obj = &packet[2 + i * 4];
+        model->sinkObjects[i] = obj[0] | (obj[1] << 8) | (obj[2] << 16) | ((uint32_t)obj[3] << 24);
+    }
+    model->sinkMessages++;
+
+    // GoodCRC from the sink
+    uint8_t goodCrc[2] = {0x01 | (2 << 6), (uint8_t)(((header >> 9) & 0x7) << 1)};
+    PushRx(model, FUSB302_RXTOKEN_SOP, goodCrc, sizeof(goodCrc));
+
+    // Request for the first PDO at its maximum current
+    if (numObjects && (header & 0x1F) == 1) {
+        uint32_t rdo = model->sinkRdo;
+        if (!rdo) {
+            uint32_t maxCurrent = model->sinkObjects[0] & 0x3FF;
+            rdo = (1u << 28) | (maxCurrent << 10) | maxCurrent;
+        }
+        FUSB302_ModelSinkSend(model, 2, &rdo, 1);
+    }
+}
+
+static void Transmit(FUSB302_Model_t *model) {
+    // Decode tokens up to TXOFF
+    uint8_t packet[FUSB302_MODEL_TX_SIZE];
+    int len = 0;
+    bool sopPrime = model->txLen >= 4 && model->tx[2] == FUSB302_TOKEN_SOP3 &&
+                    model->tx[3] == FUSB302_TOKEN_SOP3;
+    bool sop = model->txLen >= 4 && model->tx[2] == FUSB302_TOKEN_SOP1 &&
+               model->tx[3] == FUSB302_TOKEN_SOP2;
+    for (int i = 4; i < model->txLen;) {
+        uint8_t token = model->tx[i++];
+        if ((token & 0xE0) == FUSB302_TOKEN_PACKSYM) {
+            int runLen = token & 0x1F;
+            memcpy(&packet[len], &model->tx[i], runLen);
+            len += runLen;
+            i += runLen;
+        } else if (token == FUSB302_TOKEN_TXOFF) {
+            break;
+        }
+    }
+    model->txLen = 0;
+    model->packets++;
+
+    model->regs[FUSB302_REG_INTERRUPTA] |= FUSB302_I_TXSENT;
+    if (sopPrime) {
+        ReplyIdentity(model, packet, len);
+    } else if (sop) {
+        ReceiveSink(model, packet, len);
+    }
+}
+
+static bool HasToken(FUSB302_Model_t *model, uint8_t wanted, bool remove) {
+    // Find a token outside PACKSYM runs
+    for (int i = 0; i < model->txLen;) {
+        uint8_t token = model->tx[i];
+        if ((token & 0xE0) == FUSB302_TOKEN_PACKSYM) {
+            i += 1 + (token & 0x1F);
+            continue;
+        }
+        if (token == wanted) {
+            if (remove) {
+                memmove(&model->tx[i], &model->tx[i + 1], model->txLen - i - 1);
+                model->txLen--;
+            }
+            return true;
+        }
+        i++;
+    }
+    return false;
+}
+
+static int ReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length, int timeout) {
+    (void)addr7bit;
+    (void)timeout;
+    FUSB302_Model_t *model = current;
+    model->reads++;
+    Evaluate(model);
+
+    if (regNum == FUSB302_REG_FIFOS) {
+        for (int i = 0; i < length; i++) {
+            data[i] = model->rxLen ? model->rx[0] : 0;
+            if (model->rxLen) {
+                memmove(model->rx, &model->rx[1], --model->rxLen);
+            }
+        }
+        Evaluate(model);
+        return 0;
+    }
+
+    for (int i = 0; i < length; i++) {
+        int reg = regNum + i;
+        data[i] = model->regs[reg];
+        if (reg == FUSB302_REG_INTERRUPTA || reg == FUSB302_REG_INTERRUPTB ||
+            reg == FUSB302_REG_INTERRUPT) {
+            model->regs[reg] = 0;
+        }
+    }
+
+    return 0;
+}
+
+static int WriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
+                    uint8_t wait) {
+    (void)addr7bit;
+    (void)wait;
+    FUSB302_Model_t *model = current;
+    model->writes++;
+
+    if (regNum == FUSB302_REG_FIFOS) {
+        for (int i = 0; i < length && model->txLen < FUSB302_MODEL_TX_SIZE; i++) {
+            model->tx[model->txLen++] = data[i];
+        }
+        if (HasToken(model, FUSB302_TOKEN_TXON, true) &&
+            HasToken(model, FUSB302_TOKEN_TXOFF, false)) {
+            Transmit(model);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < length; i++) {
+        int reg = regNum + i;
+        if (reg == FUSB302_REG_DEVICE_ID) {
+            continue;
+        }
+        model->regs[reg] = data[i];
+
+        if (reg == FUSB302_REG_RESET) {
+            if (data[i] & FUSB302_SW_RESET) {
+                ResetRegisters(model);
+                return 0;
+            }
+            model->regs[reg] = 0;
+        } else if (reg == FUSB302_REG_CONTROL0) {
+            if (data[i] & FUSB302_TX_FLUSH) {
+                model->txLen = 0;
+            }
+            if ((data[i] & FUSB302_TX_START) && HasToken(model, FUSB302_TOKEN_TXOFF, false)) {
+                Transmit(model);
+            }
+            model->regs[reg] &= ~(FUSB302_TX_FLUSH | FUSB302_TX_START);
+        } else if (reg == FUSB302_REG_CONTROL3) {
+            if (data[i] & FUSB302_SEND_HARD_RESET) {
+                model->hardResets++;
+                model->sinkMessageId = 0;
+                model->regs[FUSB302_REG_INTERRUPTA] |= FUSB302_I_HARDSENT;
+            }
+            model->regs[reg] &= ~FUSB302_SEND_HARD_RESET;
+        } else if (reg == FUSB302_REG_CONTROL1) {
+            if (data[i] & FUSB302_RX_FLUSH) {
+                model->rxLen = 0;
+            }
+            model->regs[reg] &= ~FUSB302_RX_FLUSH;
+        }
+    }
+
+    Evaluate(model);
+    return 0;
+}
+
+static void DelayUs(uint32_t us) {
+    current->delayUs += us;
+    current->nowUs += us;
+}
+
+static void DebugPrint(const char *fmt, ...) {
+    (void)fmt;
+}
+
+static FUSB302_TimeDiffMs GetTimeDiffMs(FUSB302_CycleTime end, FUSB302_CycleTime start) {
+    return (FUSB302_TimeDiffMs)(end - start);
+}
+
+static FUSB302_CycleTime GetCycleTime(void) {
+    return (FUSB302_CycleTime)(current->nowUs / 1000);
+}
+
+void FUSB302_SelectModel(FUSB302_Model_t *model) {
+    current = model;
+}
+
+void FUSB302_SetupModelPlatform(FUSB302_Platform_t *platform) {
+    memset(platform, 0, sizeof(*platform));
+    platform->i2cWriteReg = WriteReg;
+    platform->i2cReadReg = ReadReg;
+    platform->delayUs = DelayUs;
+    platform->debugPrint = DebugPrint;
+    platform->getTimeDiffMs = GetTimeDiffMs;
+    platform->invalidCycleTime = 0xFFFFFFFF;
+    platform->getCycleTime = GetCycleTime;
+}
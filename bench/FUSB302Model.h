@@ -0,0 +1,74 @@
+#ifndef FUSB302_MODEL_H
+#define FUSB302_MODEL_H
+
+#include "FUSB302.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register-level FUSB302 model for benchmarks: CC terminations, comparator and BC_LVL, interrupts,
+// TX token parsing, an e-marker answering Discover Identity on SOP' and a PD sink behind Rd. Time
+// is virtual, delays advance the clock of the model instead of sleeping.
+
+typedef enum FUSB302_ModelTerm {
+    FUSB302_MODEL_TERM_OPEN,
+    FUSB302_MODEL_TERM_RD, // sink (device)
+    FUSB302_MODEL_TERM_RA, // cable VCONN load (e-marker)
+} FUSB302_ModelTerm_t;
+
+#define FUSB302_MODEL_RX_SIZE 256
+#define FUSB302_MODEL_TX_SIZE 320
+
+typedef struct FUSB302_Model {
+    uint8_t regs[256];
+    FUSB302_ModelTerm_t cc[2];
+
+    bool emarker;
+    uint16_t emarkerVid;
+    uint8_t emarkerProductType;
+
+    // PD sink on the Rd pin: answers Source_Capabilities with a Request for sinkRdo (0: first PDO
+    // at its maximum current) and keeps the last SOP message of the port
+    bool sink;
+    uint8_t sinkSpecRevision; // header revision, 0: PD 3.0
+    uint32_t sinkRdo;
+    uint8_t sinkMessageId;
+    uint16_t sinkHeader;
+    uint32_t sinkObjects[7];
+    uint32_t sinkMessages; // SOP messages received by the sink
+    uint32_t hardResets;   // Hard Reset signaling sent by the port
+
+    uint8_t rx[FUSB302_MODEL_RX_SIZE];
+    int rxLen;
+    uint8_t tx[FUSB302_MODEL_TX_SIZE];
+    int txLen;
+
+    int lastComp; // -1: not sampled yet
+    int lastBcLvl;
+
+    // Virtual clock and statistics
+    uint64_t nowUs;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t delayUs;
+    uint64_t packets; // transmitted messages
+} FUSB302_Model_t;
+
+void FUSB302_SetupModel(FUSB302_Model_t *model);
+// Power-on reset after a supply dip: registers back to defaults, CC terminations are kept
+void FUSB302_BrownoutModel(FUSB302_Model_t *model);
+
+// Message from the sink to the port (SOP, next sink MessageID)
+void FUSB302_ModelSinkSend(FUSB302_Model_t *model, uint8_t messageType, const uint32_t *objects,
+                           int numObjects);
+
+// Platform callbacks have no context, they act on the current model
+void FUSB302_SelectModel(FUSB302_Model_t *model);
+void FUSB302_SetupModelPlatform(FUSB302_Platform_t *platform);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSB302_MODEL_H
@@ -0,0 +1,212 @@
+// Micro-benchmark of FUSB302_ExtractPacket, FUSB302_ParseDiscoverIdentityReply and the PD CRC-32
+// over generated RX FIFO corpora (FUSB302Corpus). Prints one JSON object per corpus to stdout and
+// fails if the number of extracted or CRC-valid packets differs from the corpus.
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302Corpus.c FUSB302ParserBench.c -o fusb302-parser-bench
+//   ./fusb302-parser-bench --min-ms 500 > parser.jsonl
+//
+// CRC variants: -DFUSB302_CRC_SLICING=1, -march=native (PCLMULQDQ or ARMv8 CRC32),
+// -DFUSB302_CRC_HARDWARE=0
+//
+// Options: --min-ms N (run time per measurement), --seed N, --arena-kb N
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FUSB302CRC.h"
+#include "FUSB302Corpus.h"
+#include "FUSB302PD.h"
+
+#define BENCH_VERSION 1
+
+// Bytes per record are small, records are bounded by the arena
+#define RECORDS_PER_KB 32
+
+typedef struct Options {
+    int minMs;
+    uint32_t seed;
+    int arenaKb;
+} Options_t;
+
+static volatile uint32_t sink;
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int ExtractRecords(const FUSB302_Corpus_t *corpus, FUSB302_PDMessage_t *messages,
+                          int maxMessages, int *validCRCs) {
+    int count = 0;
+    uint32_t check = 0;
+
+    for (int r = 0; r < corpus->numRecords; r++) {
+        const FUSB302_CorpusRecord_t *record = &corpus->records[r];
+        const uint8_t *buffer = &corpus->arena[record->offset];
+        int start = 0, packetStart, packetLen;
+        FUSB302_SOP_t sop;
+
+        while (FUSB302_ExtractPacket(buffer, record->len, start, &packetStart, &packetLen, &sop)) {
+            if (messages && count < maxMessages) {
+                FUSB302_DecodeCorpusPacket(&buffer[packetStart], packetLen, sop,
+                                           &messages[count]);
+            }
+            if (validCRCs) {
+                *validCRCs += FUSB302_VerifyPacketCRC(&buffer[packetStart], packetLen);
+            }
+            check += packetLen;
+            count++;
+            start = packetStart + packetLen;
+        }
+    }
+
+    sink += check;
+    return count;
+}
+
+static void CRCRecords(const FUSB302_Corpus_t *corpus) {
+    uint32_t check = 0;
+    for (int r = 0; r < corpus->numRecords; r++) {
+        const FUSB302_CorpusRecord_t *record = &corpus->records[r];
+        check ^= FUSB302_UpdateCRC(0, &corpus->arena[record->offset], record->len);
+    }
+    sink += check;
+}
+
+static int ParseMessages(const FUSB302_PDMessage_t *messages, int numMessages) {
+    int identities = 0;
+    uint32_t check = 0;
+
+    for (int i = 0; i < numMessages; i++) {
+        FUSB302_PDIdentity_t identity;
+        if (FUSB302_ParseDiscoverIdentityReply(&messages[i], &identity)) {
+            check += identity.vid + identity.productType;
+            identities++;
+        }
+    }
+
+    sink += check;
+    return identities;
+}
+
+static int RunCorpus(const Options_t *options, FUSB302_CorpusKind_t kind, FUSB302_Corpus_t *corpus,
+                     FUSB302_PDMessage_t *messages) {
+    FUSB302_BuildCorpus(corpus, kind, options->seed + kind);
+
+    int expected = 0;
+    for (int r = 0; r < corpus->numRecords; r++) {
+        expected += corpus->records[r].packets;
+    }
+
+    // Reference pass, also collects messages for the parser measurement
+    int validCRCs = 0;
+    int numMessages = ExtractRecords(corpus, messages, corpus->maxRecords * 4, &validCRCs);
+    if (numMessages != expected || validCRCs != expected) {
+        fprintf(stderr, "%s: extracted %d packets (%d valid CRCs), expected %d\n",
+                FUSB302_GetCorpusName(kind), numMessages, validCRCs, expected);
+        return 1;
+    }
+
+    uint64_t minNs = (uint64_t)options->minMs * 1000000u;
+
+    uint64_t extractPasses = 0, start = NowNs(), extractNs;
+    do {
+        ExtractRecords(corpus, 0, 0, 0);
+        extractPasses++;
+        extractNs = NowNs() - start;
+    } while (extractNs < minNs);
+
+    uint64_t parsePasses = 0, parseNs = 0;
+    int identities = 0;
+    if (numMessages) {
+        start = NowNs();
+        do {
+            identities = ParseMessages(messages, numMessages);
+            parsePasses++;
+            parseNs = NowNs() - start;
+        } while (parseNs < minNs);
+    }
+
+    // CRC over whole records (packets are a few to a few hundred bytes)
+    uint64_t crcPasses = 0, crcNs;
+    start = NowNs();
+    do {
+        CRCRecords(corpus);
+        crcPasses++;
+        crcNs = NowNs() - start;
+    } while (crcNs < minNs);
+
+    double bytes = (double)corpus->arenaLen * extractPasses;
+    double extracted = (double)numMessages * extractPasses;
+    double parsed = (double)numMessages * parsePasses;
+
+    printf("{\"bench\":\"parser\",\"version\":%d,\"corpus\":\"%s\",\"seed\":%u,\"records\":%d,"
+           "\"bytes\":%u,\"packets\":%d,\"identities\":%d,",
+           BENCH_VERSION, FUSB302_GetCorpusName(kind), options->seed, corpus->numRecords,
+           corpus->arenaLen, numMessages, identities);
+    printf("\"extract_bytes_per_ns\":%.4f,\"extract_msgs_per_s\":%.0f,"
+           "\"parse_msgs_per_s\":%.0f,\"parse_ns_per_msg\":%.2f,",
+           bytes / extractNs, extractNs ? extracted * 1e9 / extractNs : 0.0,
+           parseNs ? parsed * 1e9 / parseNs : 0.0, parsed ? parseNs / parsed : 0.0);
+    printf("\"crc\":\"%s\",\"crc_bytes_per_ns\":%.4f}\n", FUSB302_GetCRCImplementation(),
+           (double)corpus->arenaLen * crcPasses / crcNs);
+    fflush(stdout);
+
+    return 0;
+}
+
+static bool ParseOptions(int argc, char **argv, Options_t *options) {
+    options->minMs = 300;
+    options->seed = 1;
+    options->arenaKb = 1024;
+
+    if (argc % 2 == 0) {
+        return false;
+    }
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--min-ms")) {
+            options->minMs = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--seed")) {
+            options->seed = (uint32_t)strtoul(argv[i + 1], 0, 0);
+        } else if (!strcmp(argv[i], "--arena-kb")) {
+            options->arenaKb = atoi(argv[i + 1]);
+        } else {
+            return false;
+        }
+    }
+
+    return options->minMs > 0 && options->arenaKb > 0;
+}
+
+int main(int argc, char **argv) {
+    Options_t options;
+    if (!ParseOptions(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--min-ms N] [--seed N] [--arena-kb N]\n", argv[0]);
+        return 2;
+    }
+
+    FUSB302_Corpus_t corpus;
+    corpus.arenaSize = (uint32_t)options.arenaKb * 1024;
+    corpus.maxRecords = options.arenaKb * RECORDS_PER_KB;
+    corpus.arena = malloc(corpus.arenaSize);
+    corpus.records = malloc(corpus.maxRecords * sizeof(FUSB302_CorpusRecord_t));
+    FUSB302_PDMessage_t *messages = malloc(corpus.maxRecords * 4 * sizeof(FUSB302_PDMessage_t));
+    if (!corpus.arena || !corpus.records || !messages) {
+        return 1;
+    }
+
+    int status = 0;
+    for (int kind = 0; kind < FUSB302_CORPUS_NUM; kind++) {
+        status |= RunCorpus(&options, (FUSB302_CorpusKind_t)kind, &corpus, messages);
+    }
+
+    free(messages);
+    free(corpus.records);
+    free(corpus.arena);
+    return status;
+}
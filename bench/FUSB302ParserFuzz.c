@@ -0,0 +1,187 @@
+// Fuzz entry point for FUSB302_ExtractPacket, FUSB302_ParseDiscoverIdentityReply and the CRC-32
+// implementations. Every packet is checked against a plain reference scanner and every CRC against
+// the byte-wise table, so speed work cannot change results.
+//
+// libFuzzer, seeded from the benchmark corpus:
+//   clang -g -O1 -fsanitize=fuzzer,address -I.. ../FUSB302*.c FUSB302Corpus.c
+//       FUSB302ParserFuzz.c -o fusb302-parser-fuzz
+//   ./fusb302-parser-fuzz-seeds --write-corpus seeds && ./fusb302-parser-fuzz seeds
+//
+// Standalone (no fuzzer): replays the generated corpus and the given files
+//   cc -DFUSB302_FUZZ_MAIN -I.. ../FUSB302*.c FUSB302Corpus.c FUSB302ParserFuzz.c
+//       -o fusb302-parser-fuzz-seeds
+//   ./fusb302-parser-fuzz-seeds [--write-corpus DIR] [FILE...]
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FUSB302CRC.h"
+#include "FUSB302Corpus.h"
+#include "FUSB302PD.h"
+
+// Seeds per corpus kind written or replayed by the standalone driver
+#define SEED_RECORDS 64
+#define SEED_ARENA_SIZE (SEED_RECORDS * 256)
+
+static bool ReferenceExtract(const uint8_t *buffer, int len, int start, int *packetStart,
+                             int *packetLen, FUSB302_SOP_t *sop) {
+    // First SOP, SOP' or SOP'' token, complete packet required
+    for (int i = start; i < len; i++) {
+        uint8_t token = buffer[i] & FUSB302_RXTOKEN_BITMASK;
+        if (token == FUSB302_RXTOKEN_SOP) {
+            *sop = FUSB302_SOP;
+        } else if (token == FUSB302_RXTOKEN_SOP1) {
+            *sop = FUSB302_SOP_PRIME;
+        } else if (token == FUSB302_RXTOKEN_SOP2) {
+            *sop = FUSB302_SOP_DOUBLE_PRIME;
+        } else {
+            continue;
+        }
+
+        if (i + 3 > len) {
+            return false;
+        }
+        uint16_t header = buffer[i + 1] | (buffer[i + 2] << 8);
+        int pdLen = 2 + FUSB302_PD_HEADER_NUM_OBJECTS(header) * 4;
+        if (FUSB302_PD_HEADER_EXTENDED(header) && FUSB302_PD_HEADER_NUM_OBJECTS(header) == 0) {
+            if (i + 5 > len) {
+                return false;
+            }
+            pdLen = 4 + FUSB302_PD_EXT_HEADER_DATA_SIZE(buffer[i + 3] | (buffer[i + 4] << 8));
+        }
+        if (i + 1 + pdLen + 4 > len) {
+            return false;
+        }
+
+#if FUSB302_PD_VERIFY_CRC
+        if (!FUSB302_VerifyPacketCRC(&buffer[i + 1], pdLen + 4)) {
+            continue;
+        }
+#endif
+
+        *packetStart = i + 1;
+        *packetLen = pdLen + 4;
+        return true;
+    }
+
+    return false;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > 0xFFFF) {
+        return 0;
+    }
+    int len = (int)size;
+
+    // Fast CRC paths against the byte-wise table, also split at an arbitrary point
+    uint32_t crc = FUSB302_UpdateCRCTable(0, data, (uint32_t)size);
+    uint32_t split = size ? data[0] % (uint32_t)(size + 1) : 0;
+    if (FUSB302_UpdateCRC(0, data, (uint32_t)size) != crc ||
+        FUSB302_UpdateCRC(FUSB302_UpdateCRC(0, data, split), &data[split], (uint32_t)size - split) !=
+            crc) {
+        abort();
+    }
+
+    int start = 0;
+    for (;;) {
+        int packetStart = -1, packetLen = -1, refStart = -1, refLen = -1;
+        FUSB302_SOP_t sop = FUSB302_SOP_OTHER, refSop = FUSB302_SOP_OTHER;
+
+        bool found = FUSB302_ExtractPacket(data, len, start, &packetStart, &packetLen, &sop);
+        bool refFound = ReferenceExtract(data, len, start, &refStart, &refLen, &refSop);
+        if (found != refFound ||
+            (found && (packetStart != refStart || packetLen != refLen || sop != refSop))) {
+            abort();
+        }
+        if (!found) {
+            break;
+        }
+
+        // Packet inside the buffer, at least header and CRC, after the start
+        if (packetStart <= start || packetLen < 6 || packetStart + packetLen > len) {
+            abort();
+        }
+
+        FUSB302_PDMessage_t message;
+        memset(&message, 0, sizeof(message));
+        FUSB302_DecodeCorpusPacket(&data[packetStart], packetLen, sop, &message);
+
+        FUSB302_PDIdentity_t identity;
+        if (FUSB302_ParseDiscoverIdentityReply(&message, &identity) &&
+            FUSB302_PD_HEADER_NUM_OBJECTS(message.header) < 2) {
+            abort();
+        }
+
+        start = packetStart + packetLen;
+    }
+
+    return 0;
+}
+
+#ifdef FUSB302_FUZZ_MAIN
+
+static int ReplayFile(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    static uint8_t buffer[0x10000];
+    size_t len = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+
+    return LLVMFuzzerTestOneInput(buffer, len);
+}
+
+int main(int argc, char **argv) {
+    const char *writeDir = 0;
+    int firstFile = 1;
+    if (argc > 2 && !strcmp(argv[1], "--write-corpus")) {
+        writeDir = argv[2];
+        firstFile = 3;
+    }
+
+    static uint8_t arena[SEED_ARENA_SIZE];
+    static FUSB302_CorpusRecord_t records[SEED_RECORDS];
+    FUSB302_Corpus_t corpus = {FUSB302_CORPUS_SINGLE_REPLY, arena, sizeof(arena), 0, records,
+                               SEED_RECORDS, 0};
+
+    // Generated corpus, same generator as the benchmark
+    int seeds = 0;
+    for (int kind = 0; kind < FUSB302_CORPUS_NUM; kind++) {
+        FUSB302_BuildCorpus(&corpus, (FUSB302_CorpusKind_t)kind, 1 + kind);
+        for (int r = 0; r < corpus.numRecords; r++) {
+            const FUSB302_CorpusRecord_t *record = &records[r];
+            LLVMFuzzerTestOneInput(&arena[record->offset], record->len);
+            seeds++;
+
+            if (writeDir) {
+                char path[512];
+                snprintf(path, sizeof(path), "%s/%s-%03d", writeDir,
+                         FUSB302_GetCorpusName((FUSB302_CorpusKind_t)kind), r);
+                FILE *file = fopen(path, "wb");
+                if (!file) {
+                    perror(path);
+                    return 1;
+                }
+                fwrite(&arena[record->offset], 1, record->len, file);
+                fclose(file);
+            }
+        }
+    }
+
+    int status = 0;
+    for (int i = firstFile; i < argc; i++) {
+        status |= ReplayFile(argv[i]);
+    }
+
+    printf("%d seeds, %d files ok\n", seeds, argc - firstFile);
+    return status;
+}
+
+#endif // FUSB302_FUZZ_MAIN
@@ -0,0 +1,290 @@
+// Source policy engine checks on the register model (FUSB302Model) with a PD 3.0 sink behind Rd:
+// host monitoring, Tx scheduler and source updated like a port does. Built for PD 3.0, which
+// enables SinkTxNG collision avoidance. Prints one line per case, exit status is the number of
+// failed cases.
+//
+//   cc -O2 -DFUSB302_PD_SPEC_REV=2 -I.. ../FUSB302*.c FUSB302Model.c FUSB302SourceTest.c -o fusb302-source-test
+//   ./fusb302-source-test
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FUSB302Host.h"
+#include "FUSB302Model.h"
+#include "FUSB302Pool.h"
+#include "FUSB302Source.h"
+#include "FUSB302Tx.h"
+
+#if FUSB302_PD_SPEC_REV < FUSB302_PD_SPEC_REV_3_0
+#error "Build with -DFUSB302_PD_SPEC_REV=2 (PD 3.0)"
+#endif
+
+#define UPDATE_PERIOD_US 1000
+#define NEGOTIATION_TIMEOUT_US 2000000
+
+typedef struct Case {
+    const char *name;
+    bool (*run)(const char **error);
+} Case_t;
+
+static FUSB302_Model_t model;
+static FUSB302_Platform_t platform;
+static FUSB302_Data_t data;
+static FUSB302_BufferPool_t pool;
+static FUSB302_HostMonitoring_t monitoring;
+static FUSB302_TxScheduler_t scheduler;
+static FUSB302_Source_t source;
+
+// Power stage: output settles OUTPUT_SETTLE_MS after setOutput, calls are logged
+#define OUTPUT_SETTLE_MS 20
+#define MAX_OUTPUT_CALLS 8
+
+typedef struct OutputCall {
+    int objectPosition;
+    uint64_t timeMs;
+} OutputCall_t;
+
+static OutputCall_t outputCalls[MAX_OUTPUT_CALLS];
+static int numOutputCalls;
+
+static uint64_t GetTimeMs(void) {
+    return model.nowUs / 1000;
+}
+
+static bool SetOutput(FUSB302_Source_t *s, int objectPosition) {
+    (void)s;
+    if (numOutputCalls < MAX_OUTPUT_CALLS) {
+        outputCalls[numOutputCalls].objectPosition = objectPosition;
+        outputCalls[numOutputCalls].timeMs = GetTimeMs();
+        numOutputCalls++;
+    }
+    return true;
+}
+
+static bool IsOutputReady(FUSB302_Source_t *s) {
+    (void)s;
+    return !numOutputCalls ||
+           GetTimeMs() - outputCalls[numOutputCalls - 1].timeMs >= OUTPUT_SETTLE_MS;
+}
+
+static const FUSB302_SourcePower_t power = {SetOutput, IsOutputReady};
+
+static bool Update(void) {
+    model.nowUs += UPDATE_PERIOD_US;
+    FUSB302_CycleTime time = (FUSB302_CycleTime)(model.nowUs / 1000);
+    bool ok = FUSB302_UpdateHostMonitoring(&platform, &data, time, &monitoring);
+    ok &= FUSB302_UpdateTxScheduler(&platform, &data, time, &monitoring, &scheduler);
+    ok &= FUSB302_UpdateSource(&platform, &data, time, &monitoring, &scheduler, &source);
+    return ok;
+}
+
+static int GetSinkMessageType(void) {
+    return FUSB302_PD_HEADER_TYPE(model.sinkHeader);
+}
+
+static int GetHostCur(void) {
+    return (model.regs[FUSB302_REG_CONTROL0] & FUSB302_HOST_CUR_BITS) >> FUSB302_HOST_CUR_OFFSET;
+}
+
+static bool Setup(uint8_t sinkSpecRevision) {
+    FUSB302_SetupModel(&model);
+    model.sink = true;
+    model.sinkSpecRevision = sinkSpecRevision;
+    numOutputCalls = 0;
+    FUSB302_SetupModelPlatform(&platform);
+    FUSB302_SetupBufferPool(&pool);
+    platform.bufferPool = &pool;
+    FUSB302_SelectModel(&model);
+
+    if (!FUSB302_SetupHostMonitoring(&platform, &data, FUSB302_HOST_CURRENT_MODE_3A, 0,
+                                     &monitoring)) {
+        return false;
+    }
+    FUSB302_SetupTxScheduler(&scheduler, true);
+    uint32_t pdos[2] = {FUSB302_FixedPDO(5000, 3000, 0), FUSB302_FixedPDO(9000, 3000, 0)};
+    if (!FUSB302_SetupSource(&source, pdos, 2, &power, 0)) {
+        return false;
+    }
+
+    model.cc[0] = FUSB302_MODEL_TERM_RD;
+    return true;
+}
+
+static bool Negotiate(const char **error) {
+    // Collision avoidance: Rp stays at SinkTxNG from Source_Capabilities until PS_RDY is sent
+    uint64_t startUs = model.nowUs;
+    uint32_t seen = model.sinkMessages;
+    bool amsStarted = false;
+    while (source.state != FUSB302_SOURCE_STATE_READY ||
+           FUSB302_GetTxResult(&scheduler, FUSB302_TX_SENDER_SOURCE) != FUSB302_TX_RESULT_SENT) {
+        if (!Update() || model.nowUs - startUs > NEGOTIATION_TIMEOUT_US) {
+            *error = "no contract";
+            return false;
+        }
+        if (model.sinkMessages != seen) {
+            seen = model.sinkMessages;
+            amsStarted = true;
+        }
+        if (amsStarted && !(source.state == FUSB302_SOURCE_STATE_READY &&
+                            GetSinkMessageType() == FUSB302_PD_CTRL_PS_RDY) &&
+            GetHostCur() != FUSB302_HOST_CUR_1_5A) {
+            *error = "SinkTxOk during the AMS";
+            return false;
+        }
+    }
+    if (!amsStarted) {
+        *error = "no message to the sink";
+        return false;
+    }
+
+    // SinkTxOk after the AMS
+    for (int i = 0; i < 5; i++) {
+        Update();
+    }
+    if (GetHostCur() != FUSB302_HOST_CUR_3A) {
+        *error = "SinkTxNG after the AMS";
+        return false;
+    }
+    return true;
+}
+
+static bool RunNegotiation(const char **error) {
+    if (!Setup(0)) {
+        *error = "setup";
+        return false;
+    }
+    if (!Negotiate(error)) {
+        return false;
+    }
+
+    int voltageMv, currentMa;
+    if (!FUSB302_GetSourceContract(&source, &voltageMv, &currentMa) || voltageMv != 5000 ||
+        currentMa != 3000) {
+        *error = "wrong contract";
+        return false;
+    }
+    return true;
+}
+
+static bool RunTransitionTimer(const char **error) {
+    if (!Setup(0)) {
+        *error = "setup";
+        return false;
+    }
+
+    // Power stage switches tSrcTransition after the GoodCRC of Accept
+    uint64_t startUs = model.nowUs;
+    uint64_t acceptMs = 0;
+    while (!numOutputCalls) {
+        if (!Update() || model.nowUs - startUs > NEGOTIATION_TIMEOUT_US) {
+            *error = "no transition";
+            return false;
+        }
+        if (!acceptMs && GetSinkMessageType() == FUSB302_PD_CTRL_ACCEPT) {
+            acceptMs = GetTimeMs();
+        }
+    }
+    if (!acceptMs || outputCalls[0].objectPosition != 1) {
+        *error = "no Accept";
+        return false;
+    }
+    if (outputCalls[0].timeMs - acceptMs < FUSB302_T_SRC_TRANSITION_MS) {
+        *error = "transition before tSrcTransition";
+        return false;
+    }
+    return true;
+}
+
+static bool RunHardReset(const char **error) {
+    if (!Setup(0) || !Negotiate(error)) {
+        *error = "no contract";
+        return false;
+    }
+
+    // Hard Reset from the sink
+    int first = numOutputCalls;
+    uint32_t seen = model.sinkMessages;
+    model.regs[FUSB302_REG_STATUS0A] |= FUSB302_HARDRST;
+    model.regs[FUSB302_REG_INTERRUPTA] |= FUSB302_I_HARDRST;
+    model.sinkMessageId = 0;
+    Update();
+    model.regs[FUSB302_REG_STATUS0A] &= ~FUSB302_HARDRST;
+
+    uint64_t startUs = model.nowUs;
+    while (model.sinkMessages == seen) {
+        if (!Update() || model.nowUs - startUs > NEGOTIATION_TIMEOUT_US) {
+            *error = "no capabilities after hard reset";
+            return false;
+        }
+    }
+
+    // vSafe0V, tSrcRecover after it is reached, vSafe5V, capabilities once VBUS is back
+    const OutputCall_t *off = &outputCalls[first];
+    const OutputCall_t *on = &outputCalls[first + 1];
+    if (numOutputCalls != first + 2 || off->objectPosition != -1 || on->objectPosition != 0) {
+        *error = "VBUS not cycled through vSafe0V";
+        return false;
+    }
+    if (on->timeMs - off->timeMs < OUTPUT_SETTLE_MS + FUSB302_T_SRC_RECOVER_MS) {
+        *error = "vSafe5V before tSrcRecover";
+        return false;
+    }
+    if (GetTimeMs() - on->timeMs < OUTPUT_SETTLE_MS ||
+        GetSinkMessageType() != FUSB302_PD_DATA_SOURCE_CAPABILITIES) {
+        *error = "capabilities before vSafe5V";
+        return false;
+    }
+    return true;
+}
+
+static bool CheckNotSupported(uint8_t sinkSpecRevision, uint8_t expected, const char **error) {
+    if (!Setup(sinkSpecRevision) || !Negotiate(error)) {
+        *error = "no contract";
+        return false;
+    }
+
+    // Message the source does not support, answered once a contract is in place
+    uint32_t seen = model.sinkMessages;
+    FUSB302_ModelSinkSend(&model, FUSB302_PD_CTRL_GET_SINK_CAP, 0, 0);
+    for (int i = 0; i < 5 && model.sinkMessages == seen; i++) {
+        Update();
+    }
+    if (model.sinkMessages == seen || GetSinkMessageType() != expected ||
+        FUSB302_PD_HEADER_NUM_OBJECTS(model.sinkHeader)) {
+        *error = "not answered";
+        return false;
+    }
+    if (source.state != FUSB302_SOURCE_STATE_READY) {
+        *error = "contract lost";
+        return false;
+    }
+    return true;
+}
+
+static bool RunNotSupported(const char **error) {
+    return CheckNotSupported(0, FUSB302_PD_CTRL_NOT_SUPPORTED, error);
+}
+
+static bool RunRejectPD2(const char **error) {
+    return CheckNotSupported(FUSB302_PD_SPEC_REV_2_0, FUSB302_PD_CTRL_REJECT, error);
+}
+
+static const Case_t cases[] = {
+    {"negotiation", RunNegotiation},
+    {"transition-timer", RunTransitionTimer},
+    {"hard-reset", RunHardReset},
+    {"not-supported", RunNotSupported},
+    {"reject-pd2", RunRejectPD2},
+};
+
+int main(void) {
+    int failed = 0;
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const char *error = "";
+        bool ok = cases[i].run(&error);
+        printf("%-22s %s%s%s\n", cases[i].name, ok ? "ok" : "FAIL", ok ? "" : ": ", error);
+        failed += !ok;
+    }
+
+    return failed;
+}
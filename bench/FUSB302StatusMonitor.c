@@ -0,0 +1,103 @@
+// Reader of the FUSB302Export shared memory region: prints the status of every port. Polling
+// only reads the mapping (no syscalls, no effect on the driver loop).
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302StatusMonitor.c -o fusb302-status
+//   ./fusb302-bench --ports 16 --duration-ms 600000 --period-ms 2 --export /dev/shm/fusb302 &
+//   ./fusb302-status /dev/shm/fusb302 [--interval-ms N] [--count N]
+//
+// --count 0 polls forever, --interval-ms 0 polls without sleeping and reports the read rate.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FUSB302Export.h"
+
+static const char *stateNames[] = {"init",  "detached", "device", "cable", "cable-device",
+                                   "unknown", "fault"};
+
+static const char *StateName(uint32_t state) {
+    return state < sizeof(stateNames) / sizeof(stateNames[0]) ? stateNames[state] : "?";
+}
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void PrintPorts(const FUSB302_ExportRegion_t *region) {
+    printf("port state        cc vconn-vid type  ocp  otp soft hard changes   since\n");
+    for (int port = 0; port < region->numPorts; port++) {
+        FUSB302_PortStatus_t status;
+        if (!FUSB302_ReadPortStatus(region, port, &status)) {
+            printf("%4d busy\n", port);
+            continue;
+        }
+
+        printf("%4d %-12s %2u ", port, StateName(status.state), (unsigned)status.ccOrientation);
+        if (status.emarkerPresent) {
+            printf("   0x%04X %4u ", (unsigned)status.emarkerVid,
+                   (unsigned)status.emarkerProductType);
+        } else {
+            printf("        -    - ");
+        }
+        printf("%4u %4u %4u %4u %7u %7u\n", (unsigned)status.ocpFaults,
+               (unsigned)status.overTempFaults, (unsigned)status.softResets,
+               (unsigned)status.hardResets, (unsigned)status.changes, (unsigned)status.time);
+    }
+}
+
+static void PollRate(const FUSB302_ExportRegion_t *region) {
+    // Read every port back to back for one second
+    uint64_t reads = 0, failed = 0, start = NowNs();
+    while (NowNs() - start < 1000000000u) {
+        for (int port = 0; port < region->numPorts; port++) {
+            FUSB302_PortStatus_t status;
+            failed += !FUSB302_ReadPortStatus(region, port, &status);
+            reads++;
+        }
+    }
+    printf("%llu port reads/s, %llu busy\n", (unsigned long long)reads,
+           (unsigned long long)failed);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc % 2 != 0) {
+        fprintf(stderr, "usage: %s PATH [--interval-ms N] [--count N]\n", argv[0]);
+        return 2;
+    }
+
+    int intervalMs = 1000, count = 1;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--interval-ms")) {
+            intervalMs = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--count")) {
+            count = atoi(argv[i + 1]);
+        }
+    }
+
+    const FUSB302_ExportRegion_t *region = FUSB302_OpenExportFile(argv[1]);
+    if (!region) {
+        fprintf(stderr, "%s: no FUSB302 status export\n", argv[1]);
+        return 1;
+    }
+
+    for (int n = 0; count == 0 || n < count; n++) {
+        if (intervalMs == 0) {
+            PollRate(region);
+            continue;
+        }
+        if (n) {
+            struct timespec ts = {intervalMs / 1000, (long)(intervalMs % 1000) * 1000000};
+            nanosleep(&ts, 0);
+        }
+        PrintPorts(region);
+    }
+
+    FUSB302_CloseExportFile(region);
+    return 0;
+}
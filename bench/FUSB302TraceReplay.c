@@ -0,0 +1,476 @@
+// Offline decoder and replay of FUSB302Trace captures. Packets are extracted from the recorded RX
+// FIFO drains with FUSB302_ExtractPacket and the parser, then the driver calls marked in the trace
+// (host and sink monitoring, DRP, Tx scheduler, source, discovery) are replayed against the
+// recorded register data, with the recorded call inputs and power callback results. Writes are
+// compared with the capture, so any driver change that alters the access sequence shows up as a
+// divergence. Messages the application queues on the Tx scheduler itself are not replayed.
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302Corpus.c FUSB302TraceReplay.c -o fusb302-trace-replay
+//   ./fusb302-bench --ports 1 --workload cable-device --stack pd --trace cable.trace
+//   ./fusb302-trace-replay [--dump] cable.trace
+//
+// --dump prints every record before the replay.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FUSB302CRC.h"
+#include "FUSB302Corpus.h"
+#include "FUSB302DRP.h"
+#include "FUSB302Discovery.h"
+#include "FUSB302Host.h"
+#include "FUSB302PD.h"
+#include "FUSB302Pool.h"
+#include "FUSB302Sink.h"
+#include "FUSB302Source.h"
+#include "FUSB302Trace.h"
+#include "FUSB302Tx.h"
+
+#define MAX_TRACE_SIZE (64 * 1024 * 1024)
+#define RX_BUFFER_SIZE 512
+#define MAX_CALL_ARGS (2 + FUSB302_PD_MAX_DATA_OBJECTS) // discovery: flags, message
+
+static const char *typeNames[] = {"rx", "tx", "read", "write", "mark"};
+
+static const char *stateNames[] = {"init",  "detached", "device", "cable", "cable-device",
+                                   "unknown", "fault"};
+
+typedef struct Replay {
+    const uint8_t *stream;
+    uint32_t streamLen;
+    uint32_t pos;
+    FUSB302_CycleTime baseTime;
+    uint32_t ticksPerMs;
+    uint32_t timeMs;
+    FUSB302_TraceRecord_t record; // current record
+    bool valid;
+
+    uint64_t accesses;
+    uint64_t divergences;
+    uint64_t skipped; // accesses outside replayed calls
+} Replay_t;
+
+// Driver state of the replayed port
+typedef struct Port {
+    FUSB302_Platform_t platform;
+    FUSB302_Data_t data;
+    FUSB302_BufferPool_t pool;
+    FUSB302_HostMonitoring_t monitoring;
+    FUSB302_SinkMonitoring_t sink;
+    FUSB302_DRP_t drp;
+    FUSB302_TxScheduler_t scheduler;
+    FUSB302_Source_t source;
+    FUSB302_Discovery_t discovery;
+    bool started; // host monitoring set up
+} Port_t;
+
+// Platform callbacks have no context
+static Replay_t replay;
+
+static void Next(Replay_t *r) {
+    r->valid = FUSB302_ReadTraceRecord(r->stream, r->streamLen, &r->pos, &r->timeMs, &r->record);
+}
+
+static bool IsAccess(const Replay_t *r) {
+    return r->valid && r->record.type != FUSB302_TRACE_MARK;
+}
+
+static bool IsMark(const Replay_t *r, uint8_t tag) {
+    return r->valid && r->record.type == FUSB302_TRACE_MARK && r->record.reg == tag;
+}
+
+// Driver call, not an input or result of one
+static bool IsCall(const Replay_t *r) {
+    return r->valid && r->record.type == FUSB302_TRACE_MARK &&
+           r->record.reg != FUSB302_TRACE_MARK_ARG && r->record.reg != FUSB302_TRACE_MARK_RESULT;
+}
+
+static void SkipNestedCalls(void) {
+    // Calls made inside the replayed call (host or sink monitoring under DRP) run again by
+    // themselves, as do their accesses
+    while (IsCall(&replay) || IsMark(&replay, FUSB302_TRACE_MARK_ARG)) {
+        Next(&replay);
+    }
+}
+
+static void Diverge(const char *what, int reg, int len) {
+    replay.divergences++;
+    if (replay.divergences <= 10) {
+        FUSB302_TraceRecord_t *record = &replay.record;
+        fprintf(stderr, "divergence at %u ms: %s 0x%02X/%d, trace has %s 0x%02X/%d\n",
+                (unsigned)replay.timeMs, what, reg, len,
+                replay.valid ? typeNames[record->type] : "end", record->reg, record->len);
+    }
+}
+
+static int ReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length, int timeout) {
+    (void)addr7bit;
+    (void)timeout;
+
+    FUSB302_TraceType_t type = regNum == FUSB302_REG_FIFOS ? FUSB302_TRACE_RX : FUSB302_TRACE_READ;
+    FUSB302_TraceRecord_t *record = &replay.record;
+    SkipNestedCalls();
+    if (!IsAccess(&replay)) {
+        Diverge(typeNames[type], regNum, length);
+        return -1;
+    }
+    replay.accesses++;
+
+    // Serve recorded data, zeros on mismatch
+    bool failed = record->failed;
+    if (record->type != type || record->reg != regNum || (!failed && record->len != length)) {
+        Diverge(typeNames[type], regNum, length);
+        memset(data, 0, length);
+        failed = false;
+    } else if (!failed) {
+        memcpy(data, record->data, length);
+    }
+
+    Next(&replay);
+    return failed ? -1 : 0;
+}
+
+static int WriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
+                    uint8_t wait) {
+    (void)addr7bit;
+    (void)wait;
+
+    FUSB302_TraceType_t type = regNum == FUSB302_REG_FIFOS ? FUSB302_TRACE_TX : FUSB302_TRACE_WRITE;
+    FUSB302_TraceRecord_t *record = &replay.record;
+    SkipNestedCalls();
+    if (!IsAccess(&replay)) {
+        Diverge(typeNames[type], regNum, length);
+        return -1;
+    }
+    replay.accesses++;
+
+    bool failed = record->failed;
+    if (record->type != type || record->reg != regNum ||
+        (!failed && (record->len != length || memcmp(record->data, data, length)))) {
+        Diverge(typeNames[type], regNum, length);
+        failed = false;
+    }
+
+    Next(&replay);
+    return failed ? -1 : 0;
+}
+
+static void DelayUs(uint32_t us) {
+    (void)us;
+}
+
+static void DebugPrint(const char *fmt, ...) {
+    (void)fmt;
+}
+
+// Recorded platform clock: 32 bit counter at the tick rate of the header
+static FUSB302_TimeDiffMs GetTimeDiffMs(FUSB302_CycleTime end, FUSB302_CycleTime start) {
+    return (FUSB302_TimeDiffMs)(int32_t)(end - start) / (FUSB302_TimeDiffMs)replay.ticksPerMs;
+}
+
+static FUSB302_CycleTime GetCycleTime(void) {
+    return replay.baseTime + replay.timeMs * replay.ticksPerMs;
+}
+
+// Power stage of the source: recorded results
+static bool TakeResult(void) {
+    SkipNestedCalls();
+    if (!IsMark(&replay, FUSB302_TRACE_MARK_RESULT)) {
+        Diverge("result", 0, 0);
+        return true;
+    }
+    bool result = replay.record.value != 0;
+    Next(&replay);
+    return result;
+}
+
+static bool SetOutput(FUSB302_Source_t *source, int objectPosition) {
+    (void)source;
+    (void)objectPosition;
+    return TakeResult();
+}
+
+static bool IsOutputReady(FUSB302_Source_t *source) {
+    (void)source;
+    return TakeResult();
+}
+
+static const FUSB302_SourcePower_t power = {SetOutput, IsOutputReady};
+
+static void SetupPlatform(FUSB302_Platform_t *platform) {
+    memset(platform, 0, sizeof(*platform));
+    platform->i2cWriteReg = WriteReg;
+    platform->i2cReadReg = ReadReg;
+    platform->delayUs = DelayUs;
+    platform->debugPrint = DebugPrint;
+    platform->getTimeDiffMs = GetTimeDiffMs;
+    platform->invalidCycleTime = 0xFFFFFFFF;
+    platform->getCycleTime = GetCycleTime;
+}
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void PrintRecord(const FUSB302_TraceRecord_t *record) {
+    printf("%10u %-5s ", (unsigned)record->timeMs, typeNames[record->type]);
+    if (record->type == FUSB302_TRACE_MARK) {
+        printf("tag 0x%02X value %u\n", record->reg, (unsigned)record->value);
+        return;
+    }
+    printf("0x%02X", record->reg);
+    if (record->failed) {
+        printf(" failed\n");
+        return;
+    }
+    for (int i = 0; i < record->len; i++) {
+        printf(" %02X", record->data[i]);
+    }
+    printf("\n");
+}
+
+static int DecodePackets(const uint8_t *stream, uint32_t streamLen, bool dump) {
+    // FIFO drains come in pieces (token and header, then the rest), extract across records
+    static uint8_t rx[RX_BUFFER_SIZE];
+    int rxLen = 0, packets = 0;
+
+    uint32_t pos, ticksPerMs, timeMs = 0;
+    FUSB302_CycleTime baseTime;
+    FUSB302_TraceRecord_t record;
+    if (!FUSB302_ReadTraceHeader(stream, streamLen, &pos, &baseTime, &ticksPerMs)) {
+        return -1;
+    }
+    if (dump) {
+        printf("base time %u, %u ticks per ms\n", (unsigned)baseTime, (unsigned)ticksPerMs);
+    }
+
+    while (FUSB302_ReadTraceRecord(stream, streamLen, &pos, &timeMs, &record)) {
+        if (dump) {
+            PrintRecord(&record);
+        }
+        if (record.type != FUSB302_TRACE_RX || record.failed) {
+            continue;
+        }
+
+        if (rxLen + record.len > RX_BUFFER_SIZE) {
+            rxLen = 0;
+        }
+        memcpy(&rx[rxLen], record.data, record.len);
+        rxLen += record.len;
+
+        int packetStart, packetLen;
+        FUSB302_SOP_t sop;
+        while (FUSB302_ExtractPacket(rx, rxLen, 0, &packetStart, &packetLen, &sop)) {
+            FUSB302_PDMessage_t message;
+            memset(&message, 0, sizeof(message));
+            FUSB302_DecodeCorpusPacket(&rx[packetStart], packetLen, sop, &message);
+
+            printf("%10u packet sop %d header 0x%04X objects %d%s", (unsigned)record.timeMs, sop,
+                   message.header, FUSB302_PD_HEADER_NUM_OBJECTS(message.header),
+                   FUSB302_VerifyPacketCRC(&rx[packetStart], packetLen) ? "" : " bad crc");
+            FUSB302_PDIdentity_t identity;
+            if (FUSB302_ParseDiscoverIdentityReply(&message, &identity)) {
+                printf(" identity vid 0x%04X product type %d", identity.vid,
+                       identity.productType);
+            }
+            printf("\n");
+            packets++;
+
+            rxLen -= packetStart + packetLen;
+            memmove(rx, &rx[packetStart + packetLen], rxLen);
+        }
+    }
+
+    if (pos != streamLen) {
+        fprintf(stderr, "corrupt record at offset %u\n", (unsigned)pos);
+    }
+    return packets;
+}
+
+static void SetupPort(Port_t *port) {
+    memset(port, 0, sizeof(*port));
+    SetupPlatform(&port->platform);
+    FUSB302_SetupBufferPool(&port->pool);
+    port->platform.bufferPool = &port->pool;
+    FUSB302_SetupTxScheduler(&port->scheduler, false);
+    port->source.power = power; // idle until the capabilities of the first attach
+    FUSB302_SetupDiscovery(&port->discovery, 0);
+}
+
+// Replays one marked call with its inputs, false: not replayable (*ok unchanged)
+static bool ReplayCall(Port_t *port, const FUSB302_TraceRecord_t *mark, const uint32_t *args,
+                       int numArgs, bool *ok) {
+    FUSB302_Platform_t *platform = &port->platform;
+    FUSB302_Data_t *data = &port->data;
+    FUSB302_CycleTime time = mark->value;
+    uint8_t tag = mark->reg;
+
+    if (tag <= FUSB302_TRACE_MARK_HOST_SETUP + FUSB302_HOST_CURRENT_MODE_3A) {
+        *ok = FUSB302_SetupHostMonitoring(
+            platform, data, (FUSB302_HostCurrentMode_t)(tag - FUSB302_TRACE_MARK_HOST_SETUP), time,
+            &port->monitoring);
+        port->started = true;
+    } else if (tag == FUSB302_TRACE_MARK_HOST_UPDATE && port->started) {
+        *ok = FUSB302_UpdateHostMonitoring(platform, data, time, &port->monitoring);
+    } else if (tag == FUSB302_TRACE_MARK_HOST_CURRENT && port->started) {
+        *ok = FUSB302_SetHostCurrent(platform, data, &port->monitoring,
+                                     (FUSB302_HostCurrentMode_t)mark->value);
+    } else if (tag == FUSB302_TRACE_MARK_HOST_CURRENT_CAP && port->started) {
+        *ok = FUSB302_SetHostCurrentCap(platform, data, &port->monitoring,
+                                        (FUSB302_HostCurrentMode_t)mark->value);
+    } else if (tag == FUSB302_TRACE_MARK_SINK_SETUP) {
+        *ok = FUSB302_SetupSinkMonitoring(platform, data, time, &port->sink);
+    } else if (tag == FUSB302_TRACE_MARK_SINK_START) {
+        *ok = FUSB302_StartSinkMonitoring(platform, data, time, &port->sink);
+    } else if (tag == FUSB302_TRACE_MARK_SINK_UPDATE) {
+        *ok = FUSB302_UpdateSinkMonitoring(platform, data, time, &port->sink);
+    } else if (tag >= FUSB302_TRACE_MARK_DRP_SETUP &&
+               tag <= FUSB302_TRACE_MARK_DRP_SETUP + FUSB302_HOST_CURRENT_MODE_3A && numArgs) {
+        *ok = FUSB302_SetupDRP(platform, data, (FUSB302_DRPPreference_t)args[0],
+                               (FUSB302_HostCurrentMode_t)(tag - FUSB302_TRACE_MARK_DRP_SETUP),
+                               time, &port->monitoring, &port->sink, &port->drp);
+        port->started = true;
+    } else if (tag == FUSB302_TRACE_MARK_DRP_UPDATE) {
+        *ok = FUSB302_UpdateDRP(platform, data, time, &port->drp);
+    } else if (tag == FUSB302_TRACE_MARK_TX_UPDATE || tag == FUSB302_TRACE_MARK_TX_UPDATE + 1) {
+        port->scheduler.collisionAvoidance = tag != FUSB302_TRACE_MARK_TX_UPDATE;
+        *ok = FUSB302_UpdateTxScheduler(platform, data, time, &port->monitoring, &port->scheduler);
+    } else if (tag == FUSB302_TRACE_MARK_SOURCE_UPDATE) {
+        // Capabilities come with the update that starts the source
+        if (numArgs) {
+            FUSB302_SetupSource(&port->source, args, numArgs, &power, 0);
+        }
+        *ok = FUSB302_UpdateSource(platform, data, time, &port->monitoring, &port->scheduler,
+                                   &port->source);
+    } else if (tag == FUSB302_TRACE_MARK_DISCOVERY_UPDATE && numArgs) {
+        FUSB302_PDMessage_t message;
+        bool received = (args[0] & 2) && numArgs >= 2;
+        if (received) {
+            memset(&message, 0, sizeof(message));
+            message.sop = (FUSB302_SOP_t)(args[1] >> 16);
+            message.header = (uint16_t)args[1];
+            for (int i = 2; i < numArgs; i++) {
+                message.objects[i - 2] = args[i];
+            }
+        }
+        port->discovery.enterSvid = (uint16_t)(args[0] >> 16);
+        *ok = FUSB302_UpdateDiscovery(platform, data, time, &port->monitoring, &port->scheduler,
+                                      &port->discovery, received ? &message : 0, args[0] & 1);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void PrintStateChange(uint32_t timeMs, const char *layer, int from, int to) {
+    if (from != to) {
+        printf("%10u %s state %d -> %d\n", (unsigned)timeMs, layer, from, to);
+    }
+}
+
+static int Replay(const uint8_t *stream, uint32_t streamLen) {
+    static Port_t port;
+    SetupPort(&port);
+
+    memset(&replay, 0, sizeof(replay));
+    replay.stream = stream;
+    replay.streamLen = streamLen;
+    FUSB302_ReadTraceHeader(stream, streamLen, &replay.pos, &replay.baseTime, &replay.ticksPerMs);
+    Next(&replay);
+
+    uint64_t calls = 0, failedCalls = 0, cpuNs = 0;
+    while (replay.valid) {
+        FUSB302_TraceRecord_t mark = replay.record;
+        if (!IsCall(&replay)) {
+            replay.skipped += mark.type != FUSB302_TRACE_MARK;
+            Next(&replay);
+            continue;
+        }
+        Next(&replay);
+
+        // Inputs of the call
+        uint32_t args[MAX_CALL_ARGS];
+        int numArgs = 0;
+        while (IsMark(&replay, FUSB302_TRACE_MARK_ARG)) {
+            if (numArgs < MAX_CALL_ARGS) {
+                args[numArgs++] = replay.record.value;
+            }
+            Next(&replay);
+        }
+
+        FUSB302_HostState_t state = port.monitoring.state;
+        FUSB302_SinkState_t sinkState = port.sink.state;
+        FUSB302_DRPState_t drpState = port.drp.state;
+        FUSB302_SourceState_t sourceState = port.source.state;
+        uint64_t start = NowNs();
+        bool ok = true;
+        if (!ReplayCall(&port, &mark, args, numArgs, &ok)) {
+            continue;
+        }
+        cpuNs += NowNs() - start;
+        calls++;
+        failedCalls += !ok;
+
+        // The call must have consumed exactly its recorded accesses and results
+        if (replay.valid && !IsCall(&replay)) {
+            Diverge("call end", 0, 0);
+            while (replay.valid && !IsCall(&replay)) {
+                Next(&replay);
+            }
+        }
+
+        if (port.monitoring.state != state) {
+            printf("%10u state %s -> %s\n", (unsigned)mark.timeMs, stateNames[state],
+                   stateNames[port.monitoring.state]);
+        }
+        PrintStateChange(mark.timeMs, "sink", sinkState, port.sink.state);
+        PrintStateChange(mark.timeMs, "drp", drpState, port.drp.state);
+        PrintStateChange(mark.timeMs, "source", sourceState, port.source.state);
+    }
+
+    printf("replay: %llu calls (%llu failed), %llu accesses, %llu skipped, %llu divergences, "
+           "%.1f ns per call\n",
+           (unsigned long long)calls, (unsigned long long)failedCalls,
+           (unsigned long long)replay.accesses, (unsigned long long)replay.skipped,
+           (unsigned long long)replay.divergences, calls ? (double)cpuNs / calls : 0.0);
+    return replay.divergences ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    bool dump = argc == 3 && !strcmp(argv[1], "--dump");
+    if (argc != 2 && !dump) {
+        fprintf(stderr, "usage: %s [--dump] FILE\n", argv[0]);
+        return 2;
+    }
+
+    const char *path = argv[argc - 1];
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+    uint8_t *stream = malloc(MAX_TRACE_SIZE);
+    if (!stream) {
+        return 1;
+    }
+    uint32_t streamLen = (uint32_t)fread(stream, 1, MAX_TRACE_SIZE, file);
+    fclose(file);
+
+    int packets = DecodePackets(stream, streamLen, dump);
+    if (packets < 0) {
+        fprintf(stderr, "%s: no FUSB302 trace\n", path);
+        free(stream);
+        return 1;
+    }
+    printf("decode: %u bytes, %d packets\n", (unsigned)streamLen, packets);
+
+    int status = Replay(stream, streamLen);
+    free(stream);
+    return status;
+}
@@ -0,0 +1,169 @@
+// TX FIFO checks of FUSB302_SendPacket on a FIFO model: the PHY drains one token per byte time
+// after the preamble, I2C transfers take bus time. Message lengths around the 48 token FIFO (with
+// and without TXON) must never overfill the FIFO, write past the 48 byte token buffer or underrun.
+// Prints one line per case, exit status is the number of failed cases.
+//
+//   cc -O2 -I.. ../FUSB302*.c FUSB302TxFifoTest.c -o fusb302-tx-fifo-test
+//   ./fusb302-tx-fifo-test
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FUSB302PD.h"
+
+#define PHY_PREAMBLE_US 213.3
+#define PHY_BYTE_US 33.33
+#define BUS_BYTE_US 22.5
+
+typedef struct Case {
+    const char *name;
+    int packedDataLen;
+} Case_t;
+
+static const Case_t cases[] = {
+    {"47-tokens-txon", 38},  // 47 tokens and TXON fill the FIFO
+    {"48-tokens", 39},       // 35 byte unchunked extended message, streamed with TX_START
+    {"49-tokens", 40},       // one refill
+    {"max-unchunked", FUSB302_PD_MAX_UNCHUNKED_MESSAGE_LEN},
+};
+
+// FIFO model state
+static double nowUs, startUs;
+static int level, maxLevel, written, underruns;
+static bool started, sent;
+
+static void Advance(double us) {
+    double from = nowUs;
+    nowUs += us;
+    if (!started) {
+        return;
+    }
+
+    // Tokens drained by the PHY in this step
+    double a = from - startUs - PHY_PREAMBLE_US, b = nowUs - startUs - PHY_PREAMBLE_US;
+    if (b < 0) {
+        return;
+    }
+    if (a < 0) {
+        a = 0;
+    }
+    for (int n = (int)(b / PHY_BYTE_US) - (int)(a / PHY_BYTE_US); n > 0; n--) {
+        if (level > 0) {
+            level--;
+        } else if (!sent) {
+            underruns++;
+        }
+    }
+}
+
+static int WriteReg(uint8_t addr7bit, uint8_t regNum, const uint8_t *data, uint8_t length,
+                    uint8_t wait) {
+    (void)addr7bit;
+    (void)wait;
+    Advance(2 * BUS_BYTE_US);
+    for (int i = 0; i < length; i++) {
+        Advance(BUS_BYTE_US);
+        if (regNum != FUSB302_REG_FIFOS) {
+            continue;
+        }
+        written++;
+        if (data[i] == FUSB302_TOKEN_TXON) {
+            started = true;
+            startUs = nowUs;
+            continue;
+        }
+        if (data[i] == FUSB302_TOKEN_TXOFF) {
+            sent = true;
+        }
+        if (++level > maxLevel) {
+            maxLevel = level;
+        }
+    }
+    if (regNum == FUSB302_REG_CONTROL0 && (data[0] & FUSB302_TX_START)) {
+        started = true;
+        startUs = nowUs;
+    }
+    return 0;
+}
+
+static int ReadReg(uint8_t addr7bit, uint8_t regNum, uint8_t *data, uint8_t length, int timeout) {
+    (void)addr7bit;
+    (void)timeout;
+    Advance(3 * BUS_BYTE_US);
+    for (int i = 0; i < length; i++) {
+        Advance(BUS_BYTE_US);
+        data[i] = 0;
+        if (regNum + i == FUSB302_REG_STATUS1) {
+            data[i] |= level >= FUSB302_PD_TX_FIFO_SIZE ? FUSB302_TX_FULL : 0;
+            data[i] |= level == 0 ? FUSB302_TX_EMPTY : 0;
+        }
+    }
+    return 0;
+}
+
+static void DelayUs(uint32_t us) {
+    Advance(us);
+}
+
+static void DebugPrint(const char *fmt, ...) {
+    (void)fmt;
+}
+
+static bool RunCase(const Case_t *c, const char **error) {
+    FUSB302_Platform_t platform;
+    memset(&platform, 0, sizeof(platform));
+    platform.i2cReadReg = ReadReg;
+    platform.i2cWriteReg = WriteReg;
+    platform.delayUs = DelayUs;
+    platform.debugPrint = DebugPrint;
+    FUSB302_Data_t data;
+    memset(&data, 0, sizeof(data));
+
+    nowUs = startUs = 0;
+    level = maxLevel = written = underruns = 0;
+    started = sent = false;
+
+    uint8_t packed[FUSB302_PD_MAX_UNCHUNKED_MESSAGE_LEN];
+    for (int i = 0; i < c->packedDataLen; i++) {
+        packed[i] = (uint8_t)i;
+    }
+
+    // Token buffer of one FIFO fill, followed by a guard
+    uint8_t txBuffer[FUSB302_PD_TX_FIFO_SIZE + 8];
+    memset(txBuffer, 0xA5, sizeof(txBuffer));
+
+    if (!FUSB302_SendPacket(&platform, &data, FUSB302_SOP, packed, c->packedDataLen, txBuffer,
+                            FUSB302_PD_TX_FIFO_SIZE)) {
+        *error = "send failed";
+        return false;
+    }
+    for (unsigned i = FUSB302_PD_TX_FIFO_SIZE; i < sizeof(txBuffer); i++) {
+        if (txBuffer[i] != 0xA5) {
+            *error = "token buffer overrun";
+            return false;
+        }
+    }
+    Advance(100000);
+
+    if (maxLevel > FUSB302_PD_TX_FIFO_SIZE) {
+        *error = "TX FIFO overfilled";
+        return false;
+    }
+    if (underruns || !sent || level) {
+        *error = "TX FIFO underrun";
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    int failed = 0;
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const char *error = "";
+        bool ok = RunCase(&cases[i], &error);
+        printf("%-22s %s%s%s\n", cases[i].name, ok ? "ok" : "FAIL", ok ? "" : ": ", error);
+        failed += !ok;
+    }
+
+    return failed;
+}